@@ -0,0 +1,280 @@
+#include "RegressionHarness.h"
+
+#include "AbcReader.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <algorithm>
+
+RegressionHarness::RegressionHarness()
+{
+}
+
+
+RegressionHarness::~RegressionHarness()
+{
+}
+
+std::string
+RegressionHarness::generateFileName(const std::string& base, const std::string& extension, int idx, int version)
+{
+	//same naming as PBD's output files
+	std::stringstream ss;
+	ss << base << "_" << idx << "_" << version << "." << extension;
+	return ss.str();
+}
+
+bool
+RegressionHarness::compareAnimations(const std::string& file1, const std::string& file2, bool requireEqualNumSamples,
+	std::vector<float>& sumOfSquaredPositionDifferences, std::vector<float>& meanPositionDifferences)
+{
+	sumOfSquaredPositionDifferences.clear();
+	meanPositionDifferences.clear();
+
+	//the readers do not report missing files
+	if (!std::ifstream(file1).good() || !std::ifstream(file2).good())
+	{
+		std::cout << "ERROR: Could not open [ " << file1 << " ] / [ " << file2 << " ]." << std::endl;
+		return false;
+	}
+
+	AbcReader reader1;
+	AbcReader reader2;
+	if (!reader1.openArchive(file1) || !reader2.openArchive(file2))
+	{
+		std::cout << "ERROR: Could not read [ " << file1 << " ] / [ " << file2 << " ]." << std::endl;
+		return false;
+	}
+
+	if (reader1.getNumSamples() != reader2.getNumSamples())
+	{
+		if (requireEqualNumSamples)
+		{
+			std::cout << "ERROR: [ " << file1 << " ] has " << reader1.getNumSamples() << " samples, [ " << file2 << " ] has "
+				<< reader2.getNumSamples() << "." << std::endl;
+			return false;
+		}
+
+		std::cout << "WARNING: Meshes contain a different Number of Samples" << std::endl;
+	}
+
+	const int numSamples = std::min(reader1.getNumSamples(), reader2.getNumSamples());
+	for (int s = 0; s < numSamples; ++s)
+	{
+		reader1.sampleSpecific(s);
+		reader2.sampleSpecific(s);
+
+		std::vector<Eigen::Vector3f>& positions1 = reader1.getPositions();
+		std::vector<Eigen::Vector3f>& positions2 = reader2.getPositions();
+
+		if (positions1.size() != positions2.size() || positions1.empty())
+		{
+			std::cout << "ERROR: Sample " << s << " has " << positions1.size() << " vs. " << positions2.size() << " vertices." << std::endl;
+			return false;
+		}
+
+		float sosd = 0.0f;
+		for (int i = 0; i < positions1.size(); ++i)
+		{
+			sosd += (positions1[i] - positions2[i]).squaredNorm();
+		}
+
+		sumOfSquaredPositionDifferences.push_back(sosd);
+		meanPositionDifferences.push_back(sosd / (float)positions1.size());
+	}
+
+	return true;
+}
+
+bool
+RegressionHarness::readScenarios(const std::string& fileName, std::vector<RegressionScenario>& scenarios)
+{
+	std::ifstream file;
+	file.open(fileName);
+
+	if (!file.is_open())
+	{
+		std::cout << "ERROR: Could not open the scenario list [ " << fileName << " ]." << std::endl;
+		return false;
+	}
+
+	std::string currentLine;
+	while (std::getline(file, currentLine))
+	{
+		std::stringstream ss(currentLine);
+
+		RegressionScenario scenario;
+		if (!(ss >> scenario.name) || scenario.name[0] == '#')
+		{
+			continue;
+		}
+
+		std::string parameter;
+		if (!(ss >> scenario.positionTolerance >> scenario.maxSlowdown >> scenario.numFrames) || !(ss >> parameter)
+			|| parameter.find("TEST_") != 0)
+		{
+			std::cout << "ERROR: Expected <NAME> <POSITION_TOLERANCE> <MAX_SLOWDOWN> <NUM_FRAMES> TEST_<IDX>_<VERSION> ..., got [ "
+				<< currentLine << " ]." << std::endl;
+			return false;
+		}
+
+		const size_t separator = parameter.find('_', 5);
+		if (separator == std::string::npos)
+		{
+			std::cout << "ERROR: Invalid test [ " << parameter << " ] (Valid Example: [ TEST_1_0 ])." << std::endl;
+			return false;
+		}
+		scenario.testIdx = std::atoi(parameter.substr(5, separator - 5).c_str());
+		scenario.testVersion = std::atoi(parameter.substr(separator + 1).c_str());
+
+		do
+		{
+			scenario.testParameters.push_back(parameter);
+		} while (ss >> parameter);
+
+		scenarios.push_back(scenario);
+	}
+
+	if (scenarios.empty())
+	{
+		std::cout << "ERROR: No scenarios in [ " << fileName << " ]." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool
+RegressionHarness::readSolverTimePerFrame(const std::string& fileName, double& solverTimePerFrame)
+{
+	const std::string key = "solver time per frame [s]: ";
+
+	std::ifstream file;
+	file.open(fileName);
+
+	std::string currentLine;
+	while (std::getline(file, currentLine))
+	{
+		if (currentLine.find(key) == 0)
+		{
+			solverTimePerFrame = std::atof(currentLine.substr(key.size()).c_str());
+			return true;
+		}
+	}
+
+	std::cout << "ERROR: No solver time in [ " << fileName << " ]." << std::endl;
+	return false;
+}
+
+bool
+RegressionHarness::copyFile(const std::string& source, const std::string& destination)
+{
+	std::ifstream in(source, std::ios::binary);
+	std::ofstream out(destination, std::ios::binary);
+
+	if (!in.is_open() || !out.is_open())
+	{
+		std::cout << "ERROR: Could not copy [ " << source << " ] to [ " << destination << " ]." << std::endl;
+		return false;
+	}
+
+	out << in.rdbuf();
+	return true;
+}
+
+bool
+RegressionHarness::run(const std::string& pbdExecutable, const std::string& scenarioFile, const std::string& goldenDirectory,
+	bool updateGolden, const std::string& resultsFile)
+{
+	std::vector<RegressionScenario> scenarios;
+	if (!readScenarios(scenarioFile, scenarios))
+	{
+		return false;
+	}
+
+	std::ofstream results;
+	results.open(resultsFile);
+	if (!results.is_open())
+	{
+		std::cout << "ERROR: Could not write [ " << resultsFile << " ]." << std::endl;
+		return false;
+	}
+	results << "scenario,numFrames,maxMeanSquaredDifference,finalMeanSquaredDifference,positionTolerance,positionPassed,"
+		<< "solverTimePerFrame,baselineSolverTimePerFrame,speedup,maxSlowdown,timingPassed" << std::endl;
+
+	int numFailed = 0;
+	for (int i = 0; i < scenarios.size(); ++i)
+	{
+		const RegressionScenario& scenario = scenarios[i];
+		std::cout << "SCENARIO [ " << scenario.name << " ]" << std::endl;
+
+		std::stringstream command;
+		command << "\"" << pbdExecutable << "\" HEADLESS " << scenario.numFrames;
+		for (int p = 0; p < scenario.testParameters.size(); ++p)
+		{
+			command << " " << scenario.testParameters[p];
+		}
+
+		if (std::system(command.str().c_str()) != 0)
+		{
+			std::cout << "FAILED: [ " << command.str() << " ] did not complete." << std::endl;
+			++numFailed;
+			continue;
+		}
+
+		const std::string archive = generateFileName("deformedMesh", "abc", scenario.testIdx, scenario.testVersion);
+		const std::string timing = generateFileName("headlessTiming", "txt", scenario.testIdx, scenario.testVersion);
+		const std::string goldenArchive = goldenDirectory + "/" + scenario.name + ".abc";
+		const std::string goldenTiming = goldenDirectory + "/" + scenario.name + "_timing.txt";
+
+		if (updateGolden)
+		{
+			if (!copyFile(archive, goldenArchive) || !copyFile(timing, goldenTiming))
+			{
+				++numFailed;
+				continue;
+			}
+			std::cout << "Golden files of [ " << scenario.name << " ] updated." << std::endl;
+			continue;
+		}
+
+		std::vector<float> sumOfSquaredPositionDifferences;
+		std::vector<float> meanPositionDifferences;
+		double solverTimePerFrame;
+		double baselineSolverTimePerFrame;
+		//a truncated run must not pass on the frames it has
+		if (!compareAnimations(archive, goldenArchive, true, sumOfSquaredPositionDifferences, meanPositionDifferences)
+			|| meanPositionDifferences.empty()
+			|| !readSolverTimePerFrame(timing, solverTimePerFrame) || !readSolverTimePerFrame(goldenTiming, baselineSolverTimePerFrame))
+		{
+			std::cout << "FAILED: [ " << scenario.name << " ] could not be compared." << std::endl;
+			++numFailed;
+			continue;
+		}
+
+		const float maxMeanSquaredDifference = *std::max_element(meanPositionDifferences.begin(), meanPositionDifferences.end());
+		const bool positionPassed = maxMeanSquaredDifference <= scenario.positionTolerance;
+		const bool timingPassed = solverTimePerFrame <= scenario.maxSlowdown * baselineSolverTimePerFrame;
+		const double speedup = (solverTimePerFrame > 0.0) ? baselineSolverTimePerFrame / solverTimePerFrame : 0.0;
+
+		std::cout << (positionPassed && timingPassed ? "PASSED" : "FAILED") << ": largest mean squared difference "
+			<< maxMeanSquaredDifference << " (tolerance " << scenario.positionTolerance << "); solver time per frame "
+			<< solverTimePerFrame << "s vs. baseline " << baselineSolverTimePerFrame << "s, speedup " << speedup << std::endl;
+
+		if (!positionPassed || !timingPassed)
+		{
+			++numFailed;
+		}
+
+		results << scenario.name << "," << meanPositionDifferences.size() << "," << maxMeanSquaredDifference << ","
+			<< meanPositionDifferences.back() << "," << scenario.positionTolerance << "," << (positionPassed ? 1 : 0) << ","
+			<< solverTimePerFrame << "," << baselineSolverTimePerFrame << "," << speedup << "," << scenario.maxSlowdown << ","
+			<< (timingPassed ? 1 : 0) << std::endl;
+	}
+
+	results.close();
+
+	std::cout << "REGRESSION RUN: " << scenarios.size() - numFailed << " of " << scenarios.size() << " scenarios passed." << std::endl;
+	return numFailed == 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+//One line of the scenario list
+struct RegressionScenario
+{
+	std::string name;
+
+	//largest per-frame mean of the squared position differences to the golden archive
+	float positionTolerance;
+
+	//largest solver time per frame relative to the baseline (e.g. 1.2: at most 20% slower)
+	float maxSlowdown;
+
+	int numFrames;
+
+	//TEST_<IDX>_<VERSION> and the further PBD parameters; SAVE_MESH is needed for the Alembic output
+	std::vector<std::string> testParameters;
+	int testIdx;
+	int testVersion;
+};
+
+//Golden trajectory regression runs: every scenario of a list is simulated with [ PBD HEADLESS <NUM_FRAMES> ... ], its
+//Alembic archive is compared frame by frame to <GOLDEN_DIR>/<NAME>.abc (the sums of squared position differences
+//of the pairwise comparison) and its solver time per frame to <GOLDEN_DIR>/<NAME>_timing.txt. PBD reads the
+//scenario data relative to the working directory, so the harness has to run in PBD's directory.
+class RegressionHarness
+{
+public:
+	//Returns true if every scenario is within its tolerances. With 'updateGolden' the outputs of the runs replace the
+	//golden files instead. Writes one CSV line per scenario to 'resultsFile'.
+	static bool run(const std::string& pbdExecutable, const std::string& scenarioFile, const std::string& goldenDirectory,
+		bool updateGolden, const std::string& resultsFile);
+
+	//Per-frame sums of squared position differences and their means per vertex over the samples both archives have.
+	//With 'requireEqualNumSamples' archives with different sample counts fail instead of comparing the shorter prefix.
+	static bool compareAnimations(const std::string& file1, const std::string& file2, bool requireEqualNumSamples,
+		std::vector<float>& sumOfSquaredPositionDifferences, std::vector<float>& meanPositionDifferences);
+
+private:
+	//<NAME> <POSITION_TOLERANCE> <MAX_SLOWDOWN> <NUM_FRAMES> TEST_<IDX>_<VERSION> ..., '#' starts a comment line
+	static bool readScenarios(const std::string& fileName, std::vector<RegressionScenario>& scenarios);
+
+	//'solver time per frame [s]' of a headless timing file
+	static bool readSolverTimePerFrame(const std::string& fileName, double& solverTimePerFrame);
+
+	static bool copyFile(const std::string& source, const std::string& destination);
+
+	static std::string generateFileName(const std::string& base, const std::string& extension, int idx, int version);
+
+	RegressionHarness();
+	~RegressionHarness();
+};
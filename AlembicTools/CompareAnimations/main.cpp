@@ -1,4 +1,5 @@
 #include "AbcReader.h"
+#include "RegressionHarness.h"
 
 #include <vector>
 #include <string>
@@ -7,10 +8,17 @@
 
 int main(int argc, char* argv[])
 {
+	//REGRESSION <PBD_EXECUTABLE> <SCENARIO_FILE> <GOLDEN_DIR> [UPDATE]: golden trajectory runs, see RegressionHarness
+	if (argc >= 5 && std::string(argv[1]) == "REGRESSION")
+	{
+		const bool updateGolden = argc >= 6 && std::string(argv[5]) == "UPDATE";
+		return RegressionHarness::run(argv[2], argv[3], argv[4], updateGolden, "RegressionResults.csv") ? 0 : 1;
+	}
+
 	std::string input1;
 	std::string input2;
 
-	if (argc >= 2)
+	if (argc >= 3)
 	{
 		input1 = std::string(argv[1]);
 		input2 = std::string(argv[2]);
@@ -24,47 +32,15 @@ int main(int argc, char* argv[])
 	std::cout << "FILE 1: " << input1 << std::endl;
 	std::cout << "FILE 2: " << input2 << std::endl;
 
-	//Read the archives
-	AbcReader reader1;
-	if (!reader1.openArchive(input1))
-	{
-		std::cout << "Error Opening first file, aborting..." << std::endl;
-		return 1;
-	}
-
-	AbcReader reader2;
-	if (!reader2.openArchive(input2))
-	{
-		std::cout << "Error Opening first file, aborting..." << std::endl;
-		return 1;
-	}
-
-	if (reader1.getNumSamples() != reader2.getNumSamples())
-	{
-		std::cout << "WARNING: Meshes contain a different Number of Samples" << std::endl;
-	}
-
-	std::vector<float> sumofSquaredPositionDifferences;;
+	std::vector<float> sumofSquaredPositionDifferences;
 
 	std::vector<float> meanPositionDifferences;
 
-	int meanLength = 200;
-
 	//Compare Mesh Samples
-	while (reader1.sampleForward() & reader2.sampleForward())
+	if (!RegressionHarness::compareAnimations(input1, input2, false, sumofSquaredPositionDifferences, meanPositionDifferences))
 	{
-		std::vector<Eigen::Vector3f>& positions1 = reader1.getPositions();
-		std::vector<Eigen::Vector3f>& positions2 = reader2.getPositions();
-
-		float sosd = 0.0f;
-
-		for (int i = 0; i < positions1.size(); ++i)
-		{
-			sosd += (positions1[i] - positions2[i]).squaredNorm();
-		}
-
-		sumofSquaredPositionDifferences.push_back(sosd);
-		meanPositionDifferences.push_back(sosd / (float)positions1.size());
+		std::cout << "Error comparing the files, aborting..." << std::endl;
+		return 1;
 	}
 
 	//Write Results for Matlab
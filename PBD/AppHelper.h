@@ -57,6 +57,10 @@ bool parseGeneralParams(Parameters& params, const int argc, char* argv[])
 	params.solverSettings.numConstraintIts = std::stoi(argv[6]);
 	params.solverSettings.deltaT = std::stof(argv[7]);
 	params.useFEMSolver = (std::string(argv[8]) == "USE_FEM");
+	if (std::string(argv[8]) == "USE_JACOBI")
+	{
+		params.solverSettings.useJacobiSolver = true;
+	}
 	
 	//IO
 	params.writeToAlembic = (std::string(argv[9]) == "SAVE_MESH");
@@ -126,9 +130,18 @@ bool parseTerminalParameters(const int argc, char* argv[],
 		std::cout << "SOLVER--------------------" << std::endl;
 		std::cout << "	- Num Constraint Its" << std::endl;
 		std::cout << "	- Time Step Size" << std::endl;
-		std::cout << "	- USE_FEM" << std::endl;
+		std::cout << "	- USE_FEM / USE_JACOBI (PBD with the Jacobi projection)" << std::endl;
 		std::cout << "IO--------------------" << std::endl;
 		std::cout << "	- SAVE_MESH" << std::endl;
+		std::cout << "Alternatively run [ SCALING_REPORT <NUM_FRAMES> <MAX_THREADS> ] to measure the thread scaling of the multi-threaded and Jacobi solvers." << std::endl;
+		std::cout << "Run [ SVD_BENCHMARK <NUM_MATRICES> ] to check and time the 3x3 SVD used for inversion handling." << std::endl;
+		std::cout << "Run [ SUBSTEPPING_BENCHMARK <NUM_FRAMES> <YOUNGS_MODULUS> ] to compare substepping with the iteration-heavy solver." << std::endl;
+		std::cout << "Run [ CHEBYSHEV_BENCHMARK <NUM_FRAMES> <TOLERANCE> <MAX_ITS> ] to count the sweeps saved by Chebyshev acceleration." << std::endl;
+		std::cout << "Run [ WARM_START_BENCHMARK <NUM_FRAMES> <TOLERANCE> <MAX_ITS> <YOUNGS_MODULUS> ] to count the sweeps saved by warm starting." << std::endl;
+		std::cout << "Run [ BENCHMARK_SUITE <MAX_TETS> <NUM_FRAMES> <MAX_THREADS> <CSV_FILE> ] to time the solver, its kernels and the I/O on 1k - 5M tets." << std::endl;
+		std::cout << "Run [ HEADLESS [<NUM_FRAMES>] TEST_<IDX>_<VERSION> ... ] to simulate NUM_FRAMES (default: maxFrames) without a window, writing Alembic output and timings." << std::endl;
+		std::cout << "Run [ PARAMETER_SWEEP <NUM_FRAMES> <YOUNGS_MODULI> <POISSON_RATIOS> <ALPHA:RHO> <NUM_CONSTRAINT_ITS> TEST_<IDX>_<VERSION> ... ]" << std::endl;
+		std::cout << "	with comma separated lists to run every combination in one process, writing parameterSweep_<IDX>_<VERSION>.csv." << std::endl;
 		return false;
 	}
 
@@ -230,7 +243,7 @@ bool parseTerminalParameters(const int argc, char* argv[],
 
 bool doIO(Parameters& params, IOParameters& paramsIO, std::vector<int>& vertexConstraintIndices,
 	std::vector<PBDTetrahedra3d>& tetrahedra,
-	std::shared_ptr<std::vector<PBDParticle>>& particles,
+	std::shared_ptr<PBDParticleStore>& particles,
 	std::vector<std::vector<Eigen::Vector2f>>& trackingData,
 	std::vector<CollisionRod>& collisionRodGeometry,
 	std::vector<CollisionSphere>& collisionSphereGeometry,
@@ -243,13 +256,9 @@ bool doIO(Parameters& params, IOParameters& paramsIO, std::vector<int>& vertexCo
 	}
 	else if (params.TEST_IDX == 1 || params.TEST_IDX == 2 || params.TEST_IDX == 3 || params.TEST_IDX == 4)
 	{
+		//the Prony series state of TEST_IDX 3 is allocated by the solver (see PBDTetRestStateTable)
 		MeshCreator::generateSingleTet(particles, tetrahedra, 0, 0, 0);
 
-		if (params.TEST_IDX == 3)
-		{
-			tetrahedra[0].setFullUpsilonCount(params.solverSettings.fullAlpha.size());
-		}
-
 		return true;
 	}
 	else if (params.TEST_IDX == 5)
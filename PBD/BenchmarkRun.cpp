@@ -0,0 +1,87 @@
+#include "BenchmarkRun.h"
+
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+
+#include <tbb\tick_count.h>
+
+#include "PBDSimulationContext.h"
+
+BenchmarkRun::BenchmarkRun()
+{
+}
+
+
+BenchmarkRun::~BenchmarkRun()
+{
+}
+
+void
+BenchmarkRun::measure(PBDSimulationContext& context, int numFrames, const BenchmarkFrameCallback& beforeStep,
+	BenchmarkRunResult& result)
+{
+	result.numSweeps = 0;
+	result.maxResidual = 0.0f;
+
+	tbb::tick_count start = tbb::tick_count::now();
+	for (int f = 0; f < numFrames; ++f)
+	{
+		if (beforeStep)
+		{
+			beforeStep(context, f);
+		}
+
+		context.step();
+
+		result.numSweeps += context.getSolver().getNumConstraintItsUsed();
+		result.maxResidual = std::max(result.maxResidual, context.getSolver().getConstraintResidual());
+	}
+	tbb::tick_count end = tbb::tick_count::now();
+
+	result.seconds = (end - start).seconds();
+	result.positions = context.getParticles()->getPreviousPositions();
+}
+
+void
+BenchmarkRun::measureTetBar(const PBDSolverSettings& settings, int width, int height, int depth, int numFrames,
+	BenchmarkRunResult& result)
+{
+	//the colouring is part of the setup, not of the measured frames
+	PBDSimulationContext context;
+	context.generateTetBar(width, height, depth);
+	context.initialiseFirstFrame(settings);
+
+	measure(context, numFrames, BenchmarkFrameCallback(), result);
+}
+
+float
+BenchmarkRun::computeRMSDistance(const std::vector<Eigen::Vector3f>& positions, const std::vector<Eigen::Vector3f>& reference)
+{
+	double sum = 0.0;
+	for (int p = 0; p < positions.size(); ++p)
+	{
+		sum += (positions[p] - reference[p]).squaredNorm();
+	}
+
+	return std::sqrt(sum / (double)positions.size());
+}
+
+void
+BenchmarkRun::printRun(const std::string& name, const BenchmarkRunResult& result, int numFrames)
+{
+	std::cout << "	" << std::left << std::setw(13) << (name + ":") << std::right << (double)result.numSweeps / numFrames
+		<< " sweeps per frame; " << result.seconds << "s; max residual " << result.maxResidual << std::endl;
+}
+
+void
+BenchmarkRun::printComparison(const std::string& baselineName, const BenchmarkRunResult& baseline,
+	const std::string& runName, const BenchmarkRunResult& run, int numFrames)
+{
+	printRun(baselineName, baseline, numFrames);
+	printRun(runName, run, numFrames);
+
+	std::cout << "	speedup: " << baseline.seconds / run.seconds << "x; RMS distance between the results: "
+		<< computeRMSDistance(baseline.positions, run.positions) << std::endl;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include <Eigen\Dense>
+
+#include "PBDSolverSettings.h"
+
+class PBDSimulationContext;
+
+//Called before every measured step with the frame index, e.g. to move driven particles
+typedef std::function<void(PBDSimulationContext&, int)> BenchmarkFrameCallback;
+
+struct BenchmarkRunResult
+{
+	//time spent stepping, the setup is not measured
+	double seconds;
+	//constraint sweeps of all frames and the largest residual a step ended with
+	long long numSweeps;
+	float maxResidual;
+	//final particle positions
+	std::vector<Eigen::Vector3f> positions;
+};
+
+//Run-and-measure helpers shared by the solver benchmarks: they step a PBDSimulationContext for a number of frames and
+//compare the outcome of two runs.
+class BenchmarkRun
+{
+public:
+	//Steps an initialised context 'numFrames' times
+	static void measure(PBDSimulationContext& context, int numFrames, const BenchmarkFrameCallback& beforeStep,
+		BenchmarkRunResult& result);
+
+	//Generates a tet bar, initialises it with 'settings' and steps it 'numFrames' times
+	static void measureTetBar(const PBDSolverSettings& settings, int width, int height, int depth, int numFrames,
+		BenchmarkRunResult& result);
+
+	static float computeRMSDistance(const std::vector<Eigen::Vector3f>& positions, const std::vector<Eigen::Vector3f>& reference);
+
+	//Prints sweeps per frame, time and residual of both runs, the speedup of 'run' and the distance between the results
+	static void printComparison(const std::string& baselineName, const BenchmarkRunResult& baseline,
+		const std::string& runName, const BenchmarkRunResult& run, int numFrames);
+
+private:
+	static void printRun(const std::string& name, const BenchmarkRunResult& result, int numFrames);
+
+	BenchmarkRun();
+	~BenchmarkRun();
+};
@@ -0,0 +1,461 @@
+#include "BenchmarkSuite.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <memory>
+
+#include <tbb\task_scheduler_init.h>
+#include <tbb\parallel_for.h>
+#include <tbb\blocked_range.h>
+#include <tbb\tick_count.h>
+
+#include "TetGenIO.h"
+#include "SurfaceMeshHandler.h"
+#include "commonMath.h"
+#include "PBDConstraintKernels.h"
+#include "PBDSolverBatchKernel.h"
+
+BenchmarkSuite::BenchmarkSuite()
+{
+}
+
+
+BenchmarkSuite::~BenchmarkSuite()
+{
+}
+
+void
+BenchmarkSuite::computeBarSize(int numTets, int& width, int& height, int& depth)
+{
+	//4 s x s x s cells
+	const int s = std::max(1, (int)std::floor(std::cbrt(numTets / 20.0) + 0.5));
+	width = 4 * s + 1;
+	height = s + 1;
+	depth = s + 1;
+}
+
+void
+BenchmarkSuite::addResult(const std::string& benchmark, const PBDSimulationContext& scene, int numThreads,
+	int numRepetitions, long long numItems, double time, std::vector<BenchmarkSuiteResult>& results)
+{
+	BenchmarkSuiteResult result;
+	result.benchmark = benchmark;
+	result.numTets = scene.getTetrahedra().size();
+	result.numParticles = scene.getParticleStore().size();
+	result.numThreads = numThreads;
+	result.numRepetitions = numRepetitions;
+	result.numItems = numItems;
+	result.time = time;
+	results.push_back(result);
+
+	std::cout << "    " << benchmark << ": " << time / numRepetitions << "s per repetition, "
+		<< time * 1.0e9 / ((double)numItems * numRepetitions) << " ns per item" << std::endl;
+}
+
+double
+BenchmarkSuite::timeConstraintKernel(PBDSimulationContext& context, int numRepetitions, std::string& kernelName)
+{
+	PBDSolverSettings& settings = context.getSettings();
+	const PBDConstraintKernels kernels = PBDConstraintKernels::select(settings, false);
+	kernelName = (kernels.numLanes > 1) ? "constraintKernelSIMD" : "constraintKernel";
+
+	const PBDConstraintColoring& coloring = context.getSolver().getTetrahedraColoring();
+	PBDTetRestStateTable& tetRestStates = context.getSolver().getTetRestStates();
+	PBDParticleStore& particles = *context.getParticles();
+	std::vector<CollisionSphere> noColliders;
+
+	//same ranges as projectConstraintsVISCOELASTIC_MULTI
+	const size_t grainSize = kernels.numLanes > 1 ? 2 * kernels.numLanes : 1;
+
+	tbb::tick_count start = tbb::tick_count::now();
+	for (int it = 0; it < numRepetitions; ++it)
+	{
+		for (int c = 0; c < coloring.getNumColors(); ++c)
+		{
+			const std::vector<int>& colorTetIdxs = coloring.getColor(c);
+			tbb::parallel_for(tbb::blocked_range<size_t>(0, colorTetIdxs.size(), grainSize), [&](const tbb::blocked_range<size_t>& r)
+			{
+				PBDInversionHandlingCounts inversionCounts;
+				PBDProjectionResidual residual;
+				kernels.projectTetrahedra(tetRestStates, particles, settings, noColliders,
+					&colorTetIdxs[r.begin()], r.size(), inversionCounts, residual);
+			});
+		}
+	}
+	return (tbb::tick_count::now() - start).seconds();
+}
+
+double
+BenchmarkSuite::timeCardano(const PBDSimulationContext& scene, const PBDSimulationContext& context, int numRepetitions)
+{
+	const std::vector<PBDTetrahedra3d>& tetrahedra = scene.getTetrahedra();
+	const PBDParticleStore& restParticles = scene.getParticleStore();
+	const PBDParticleStore& particles = context.getParticleStore();
+
+	std::vector<Eigen::Matrix3f> FTransposeF(tetrahedra.size());
+	for (int t = 0; t < tetrahedra.size(); ++t)
+	{
+		const std::vector<int>& vertexIndices = tetrahedra[t].getVertexIndices();
+		Eigen::Matrix3f Dm;
+		Eigen::Matrix3f Ds;
+		for (int c = 0; c < 3; ++c)
+		{
+			Dm.col(c) = restParticles.position(vertexIndices[c + 1]) - restParticles.position(vertexIndices[0]);
+			Ds.col(c) = particles.previousPosition(vertexIndices[c + 1]) - particles.previousPosition(vertexIndices[0]);
+		}
+		const Eigen::Matrix3f F = Ds * Dm.inverse();
+		FTransposeF[t] = F.transpose() * F;
+	}
+
+	//keeps the decompositions from being optimised away
+	std::vector<float> largestEigenValues(tetrahedra.size());
+
+	tbb::tick_count start = tbb::tick_count::now();
+	for (int it = 0; it < numRepetitions; ++it)
+	{
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, FTransposeF.size()), [&](const tbb::blocked_range<size_t>& r)
+		{
+			Eigen::Matrix3f A;
+			Eigen::Matrix3f S;
+			Eigen::Matrix3f V;
+			for (size_t i = r.begin(); i != r.end(); ++i)
+			{
+				A = FTransposeF[i];
+				eigenDecompositionCardano(A, S, V);
+				largestEigenValues[i] = S(0, 0);
+			}
+		});
+	}
+	return (tbb::tick_count::now() - start).seconds();
+}
+
+double
+BenchmarkSuite::timeCollisions(PBDSimulationContext& context, int numRepetitions)
+{
+	std::shared_ptr<PBDParticleStore>& particles = context.getParticles();
+
+	Eigen::Vector3f minPosition = particles->previousPosition(0);
+	Eigen::Vector3f maxPosition = particles->previousPosition(0);
+	for (int p = 1; p < particles->size(); ++p)
+	{
+		minPosition = minPosition.cwiseMin(particles->previousPosition(p));
+		maxPosition = maxPosition.cwiseMax(particles->previousPosition(p));
+	}
+
+	//particles pushed out by the first pass stay outside, later passes mostly measure the distance tests
+	std::vector<CollisionSphere>& collisionGeometry3 = context.getCollisionGeometry3();
+	collisionGeometry3.assign(1, CollisionSphere());
+	collisionGeometry3[0].setCollisionSphereCentre(0.5f * (minPosition + maxPosition));
+
+	PBDSolverSettings settings = context.getSettings();
+	settings.collisionSpheresRadius.assign(1, 0.25f * (maxPosition - minPosition).minCoeff());
+
+	tbb::tick_count start = tbb::tick_count::now();
+	for (int it = 0; it < numRepetitions; ++it)
+	{
+		context.getSolver().processCollisions(context.getState(), settings);
+	}
+	return (tbb::tick_count::now() - start).seconds();
+}
+
+bool
+BenchmarkSuite::benchmarkSolver(const PBDSimulationContext& scene, int numFrames, int numThreads,
+	std::vector<Eigen::Vector3f>& deterministicPositions, std::vector<BenchmarkSuiteResult>& results)
+{
+	const int numTets = scene.getTetrahedra().size();
+	const int numParticles = scene.getParticleStore().size();
+
+	//enough repetitions to make the small meshes measurable
+	const int numRepetitions = std::max(1, std::min(100, 1000000 / numTets));
+
+	tbb::task_scheduler_init init(numThreads);
+	std::cout << "  Threads [ " << numThreads << " ]" << std::endl;
+
+	PBDSimulationContext context;
+	context.shareMesh(scene, scene.getSettings());
+
+	tbb::tick_count start = tbb::tick_count::now();
+	for (int f = 0; f < numFrames; ++f)
+	{
+		context.step();
+	}
+	addResult("advanceSystem", scene, numThreads, numFrames, numTets, (tbb::tick_count::now() - start).seconds(), results);
+
+	{
+		PBDSolverSettings jacobiSettings = scene.getSettings();
+		jacobiSettings.useJacobiSolver = true;
+
+		PBDSimulationContext jacobiContext;
+		jacobiContext.shareMesh(scene, jacobiSettings);
+
+		start = tbb::tick_count::now();
+		for (int f = 0; f < numFrames; ++f)
+		{
+			jacobiContext.step();
+		}
+		addResult("advanceSystemJacobi", scene, numThreads, numFrames, numTets, (tbb::tick_count::now() - start).seconds(),
+			results);
+	}
+
+	bool isDeterministic = true;
+	{
+		PBDSolverSettings deterministicSettings = scene.getSettings();
+		deterministicSettings.useDeterministicParallelism = true;
+
+		PBDSimulationContext deterministicContext;
+		deterministicContext.shareMesh(scene, deterministicSettings);
+
+		start = tbb::tick_count::now();
+		for (int f = 0; f < numFrames; ++f)
+		{
+			deterministicContext.step();
+		}
+		addResult("advanceSystemDeterministic", scene, numThreads, numFrames, numTets, (tbb::tick_count::now() - start).seconds(),
+			results);
+
+		const PBDParticleStore& particles = deterministicContext.getParticleStore();
+		if (deterministicPositions.empty())
+		{
+			for (int p = 0; p < particles.size(); ++p)
+			{
+				deterministicPositions.push_back(particles.previousPosition(p));
+			}
+		}
+		else
+		{
+			//bitwise
+			for (int p = 0; p < particles.size(); ++p)
+			{
+				isDeterministic = isDeterministic && particles.previousPosition(p) == deterministicPositions[p];
+			}
+
+			if (!isDeterministic)
+			{
+				std::cout << "ERROR: The deterministic mode differs from the run with the first thread count!" << std::endl;
+			}
+		}
+	}
+
+	//the kernels run on the deformed bar
+	std::string kernelName;
+	const double kernelTime = timeConstraintKernel(context, numRepetitions, kernelName);
+	addResult(kernelName, scene, numThreads, numRepetitions, numTets, kernelTime, results);
+
+	addResult("eigenDecompositionCardano", scene, numThreads, numRepetitions, numTets,
+		timeCardano(scene, context, numRepetitions), results);
+
+	addResult("collisionSpheres", scene, numThreads, numRepetitions, numParticles,
+		timeCollisions(context, numRepetitions), results);
+
+	return isDeterministic;
+}
+
+bool
+BenchmarkSuite::writeTetGenFiles(const PBDSimulationContext& scene, const std::string& nodeFile, const std::string& eleFile)
+{
+	const PBDParticleStore& particles = scene.getParticleStore();
+	const std::vector<PBDTetrahedra3d>& tetrahedra = scene.getTetrahedra();
+
+	std::ofstream nodes;
+	nodes.open(nodeFile);
+	std::ofstream elements;
+	elements.open(eleFile);
+
+	if (!nodes.is_open() || !elements.is_open())
+	{
+		std::cout << "ERROR: Could not write [ " << nodeFile << " ] / [ " << eleFile << " ]." << std::endl;
+		return false;
+	}
+
+	nodes << particles.size() << " 3 0 0" << std::endl;
+	for (int p = 0; p < particles.size(); ++p)
+	{
+		const Eigen::Vector3f& x = particles.position(p);
+		nodes << p << " " << x.x() << " " << x.y() << " " << x.z() << "\n";
+	}
+
+	//TetGenIO::readTetrahedra reads the vertices in the order 1, 4, 2, 3
+	elements << tetrahedra.size() << " 4 0" << std::endl;
+	for (int t = 0; t < tetrahedra.size(); ++t)
+	{
+		const std::vector<int>& vertexIndices = tetrahedra[t].getVertexIndices();
+		elements << t << " " << vertexIndices[0] << " " << vertexIndices[2] << " " << vertexIndices[3] << " "
+			<< vertexIndices[1] << "\n";
+	}
+
+	return true;
+}
+
+bool
+BenchmarkSuite::benchmarkIO(const PBDSimulationContext& scene, int numFrames, std::vector<BenchmarkSuiteResult>& results)
+{
+	const std::string nodeFile = "BenchmarkSuite.node";
+	const std::string eleFile = "BenchmarkSuite.ele";
+	const std::string abcFile = "BenchmarkSuite.abc";
+
+	//the readers and the Alembic writer are serial
+	tbb::task_scheduler_init init(1);
+	std::cout << "  I/O" << std::endl;
+
+	if (!writeTetGenFiles(scene, nodeFile, eleFile))
+	{
+		return false;
+	}
+
+	std::vector<PBDTetrahedra3d> tetrahedra;
+	std::shared_ptr<PBDParticleStore> particles = std::make_shared<PBDParticleStore>();
+
+	tbb::tick_count start = tbb::tick_count::now();
+	bool success = TetGenIO::readNodes(nodeFile, *particles, 1.0f, Eigen::Vector3f::Zero());
+	const double nodeTime = (tbb::tick_count::now() - start).seconds();
+
+	start = tbb::tick_count::now();
+	success = success && TetGenIO::readTetrahedra(eleFile, tetrahedra, particles);
+	const double eleTime = (tbb::tick_count::now() - start).seconds();
+
+	std::remove(nodeFile.c_str());
+	std::remove(eleFile.c_str());
+
+	if (!success || particles->size() != scene.getParticleStore().size() || tetrahedra.size() != scene.getTetrahedra().size())
+	{
+		std::cout << "ERROR: TetGenIO did not read back the benchmark mesh!" << std::endl;
+		return false;
+	}
+
+	addResult("TetGenIO::readNodes", scene, 1, 1, particles->size(), nodeTime, results);
+	addResult("TetGenIO::readTetrahedra", scene, 1, 1, tetrahedra.size(), eleTime, results);
+
+	std::vector<Eigen::Vector3f> positions(scene.getParticleStore().size());
+	for (int p = 0; p < positions.size(); ++p)
+	{
+		positions[p] = scene.getParticleStore().position(p);
+	}
+
+	//one sample per frame, closing the archive is part of the measurement
+	start = tbb::tick_count::now();
+	{
+		SurfaceMeshHandler writer("WRITE_TETS", abcFile);
+		writer.initTopology(*particles, tetrahedra);
+		for (int f = 0; f < numFrames; ++f)
+		{
+			writer.setSample(positions);
+		}
+	}
+	addResult("AbcWriter::addSample", scene, 1, numFrames, positions.size(), (tbb::tick_count::now() - start).seconds(), results);
+
+	std::remove(abcFile.c_str());
+	return true;
+}
+
+bool
+BenchmarkSuite::writeResults(const std::vector<BenchmarkSuiteResult>& results, const std::string& fileName)
+{
+	std::ofstream file;
+	file.open(fileName);
+
+	if (!file.is_open())
+	{
+		std::cout << "ERROR: Could not write [ " << fileName << " ]." << std::endl;
+		return false;
+	}
+
+	file << "benchmark,instructionSet,numTets,numParticles,numThreads,numRepetitions,numItems,time,timePerRepetition,"
+		<< "nsPerItem" << std::endl;
+
+	for (int i = 0; i < results.size(); ++i)
+	{
+		const BenchmarkSuiteResult& result = results[i];
+		const double timePerRepetition = result.time / result.numRepetitions;
+		file << result.benchmark << "," << PBDSolverBatchKernel::getInstructionSetName() << "," << result.numTets << ","
+			<< result.numParticles << "," << result.numThreads << "," << result.numRepetitions << "," << result.numItems << ","
+			<< result.time << "," << timePerRepetition << "," << timePerRepetition * 1.0e9 / result.numItems << std::endl;
+	}
+
+	file.close();
+
+	std::cout << "Benchmark results written to [ " << fileName << " ]." << std::endl;
+	return true;
+}
+
+bool
+BenchmarkSuite::run(const PBDSolverSettings& settings, int maxNumTets, int numFrames, int maxNumThreads,
+	const std::string& fileName)
+{
+	if (numFrames < 1)
+	{
+		std::cout << "ERROR: The benchmark suite needs at least one frame!" << std::endl;
+		return false;
+	}
+
+	if (maxNumThreads <= 0)
+	{
+		maxNumThreads = tbb::task_scheduler_init::default_num_threads();
+	}
+
+	std::vector<int> numThreads;
+	for (int n = 1; n <= maxNumThreads; n *= 2)
+	{
+		numThreads.push_back(n);
+	}
+	if (numThreads.back() != maxNumThreads)
+	{
+		numThreads.push_back(maxNumThreads);
+	}
+
+	const int meshSizes[] = { 1000, 10000, 100000, 1000000, 5000000 };
+	const int numMeshSizes = sizeof(meshSizes) / sizeof(meshSizes[0]);
+
+	PBDSolverSettings benchmarkSettings = settings;
+	benchmarkSettings.currentFrame = 1;
+	benchmarkSettings.calculateLambda();
+	benchmarkSettings.calculateMu();
+	benchmarkSettings.calculateFiberStructureTensor();
+	if (!benchmarkSettings.useMultiThreadedSolver && !benchmarkSettings.useJacobiSolver)
+	{
+		//the runs share the mesh (see PBDSimulationContext::shareMesh)
+		std::cout << "WARNING: The serial solver cannot run on shared tetrahedra, benchmarking the multi-threaded solver." << std::endl;
+		benchmarkSettings.useMultiThreadedSolver = true;
+	}
+
+	std::cout << "BENCHMARK SUITE: up to " << maxNumTets << " tets, " << numFrames << " frames, up to " << maxNumThreads
+		<< " threads, instruction set: " << PBDSolverBatchKernel::getInstructionSetName() << std::endl;
+
+	std::vector<BenchmarkSuiteResult> results;
+	bool isDeterministic = true;
+	for (int m = 0; m < numMeshSizes && meshSizes[m] <= maxNumTets; ++m)
+	{
+		int width;
+		int height;
+		int depth;
+		computeBarSize(meshSizes[m], width, height, depth);
+
+		PBDSimulationContext scene;
+		scene.generateTetBar(width, height, depth);
+		scene.initialise(benchmarkSettings);
+
+		std::cout << "Tet bar [ " << width << " x " << height << " x " << depth << " ]: " << scene.getTetrahedra().size()
+			<< " tets, " << scene.getParticleStore().size() << " particles" << std::endl;
+
+		std::vector<Eigen::Vector3f> deterministicPositions;
+		for (int i = 0; i < numThreads.size(); ++i)
+		{
+			isDeterministic = benchmarkSolver(scene, numFrames, numThreads[i], deterministicPositions, results) && isDeterministic;
+		}
+
+		if (!benchmarkIO(scene, numFrames, results))
+		{
+			return false;
+		}
+	}
+
+	if (results.empty())
+	{
+		std::cout << "ERROR: No mesh size up to " << maxNumTets << " tets!" << std::endl;
+		return false;
+	}
+
+	return writeResults(results, fileName) && isDeterministic;
+}
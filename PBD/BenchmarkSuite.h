@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include <Eigen\Dense>
+
+#include "PBDSolverSettings.h"
+#include "PBDSimulationContext.h"
+
+//One measurement: 'numItems' tets, particles or matrices were processed 'numRepetitions' times in 'time' seconds
+struct BenchmarkSuiteResult
+{
+	std::string benchmark;
+	int numTets;
+	int numParticles;
+	int numThreads;
+	int numRepetitions;
+	long long numItems;
+	double time;
+};
+
+//Times the parts of a PBD step on generated tet bars of 1k, 10k, 100k, 1M and 5M tets, for 1, 2, 4, .. threads:
+//the full advanceSystem (also with the Jacobi solver and with PBDSolverSettings::useDeterministicParallelism), a
+//sweep of the coloured constraint kernel, eigenDecompositionCardano on the deformation gradients of the mesh, the
+//collision sphere pass, and, single threaded, the TetGenIO readers and the Alembic output. The results are written
+//as one CSV line per measurement, so runs of different versions can be compared.
+class BenchmarkSuite
+{
+public:
+	//Mesh sizes up to 'maxNumTets'; thread counts up to 'maxNumThreads' (<= 0: all cores)
+	static bool run(const PBDSolverSettings& settings, int maxNumTets, int numFrames, int maxNumThreads,
+		const std::string& fileName);
+
+private:
+	//Tet bar of about 'numTets' tets (5 per cell) with a 4 : 1 : 1 aspect ratio
+	static void computeBarSize(int numTets, int& width, int& height, int& depth);
+
+	//advanceSystem (default, Jacobi and deterministic mode), constraint kernel, Cardano and collisions with 'numThreads' threads
+	//on a copy of 'scene'. The final positions of the deterministic mode are compared to 'deterministicPositions',
+	//which the first call fills; returns false if they differ.
+	static bool benchmarkSolver(const PBDSimulationContext& scene, int numFrames, int numThreads,
+		std::vector<Eigen::Vector3f>& deterministicPositions, std::vector<BenchmarkSuiteResult>& results);
+
+	//TetGenIO and AbcWriter (through SurfaceMeshHandler) on the mesh of 'scene'
+	static bool benchmarkIO(const PBDSimulationContext& scene, int numFrames, std::vector<BenchmarkSuiteResult>& results);
+
+	//Sweeps over all colours with the kernels the solver selects for the settings
+	static double timeConstraintKernel(PBDSimulationContext& context, int numRepetitions, std::string& kernelName);
+
+	//F^T F of every tet of 'context' relative to the rest positions of 'scene'
+	static double timeCardano(const PBDSimulationContext& scene, const PBDSimulationContext& context, int numRepetitions);
+
+	//A static sphere in the middle of the deformed bar; replaces the colliders of 'context'
+	static double timeCollisions(PBDSimulationContext& context, int numRepetitions);
+
+	static bool writeTetGenFiles(const PBDSimulationContext& scene, const std::string& nodeFile, const std::string& eleFile);
+
+	static void addResult(const std::string& benchmark, const PBDSimulationContext& scene, int numThreads,
+		int numRepetitions, long long numItems, double time, std::vector<BenchmarkSuiteResult>& results);
+
+	static bool writeResults(const std::vector<BenchmarkSuiteResult>& results, const std::string& fileName);
+
+	BenchmarkSuite();
+	~BenchmarkSuite();
+};
@@ -0,0 +1,62 @@
+#include "ChebyshevBenchmark.h"
+
+#include <iostream>
+
+#include "BenchmarkRun.h"
+
+ChebyshevBenchmark::ChebyshevBenchmark()
+{
+}
+
+
+ChebyshevBenchmark::~ChebyshevBenchmark()
+{
+}
+
+bool
+ChebyshevBenchmark::run(const PBDSolverSettings& settings, int numFrames, float constraintTolerance, int maxNumConstraintIts)
+{
+	if (numFrames < 1 || constraintTolerance <= 0.0f || maxNumConstraintIts < 1)
+	{
+		std::cout << "ERROR: Chebyshev benchmark needs at least one frame, one sweep and a positive tolerance!" << std::endl;
+		return false;
+	}
+
+	if (!settings.useMultiThreadedSolver)
+	{
+		std::cout << "ERROR: Chebyshev acceleration is only available for the multi-threaded and Jacobi solvers!" << std::endl;
+		return false;
+	}
+
+	PBDSolverSettings benchmarkSettings = settings;
+	benchmarkSettings.constraintTolerance = constraintTolerance;
+	benchmarkSettings.numConstraintIts = maxNumConstraintIts;
+
+	std::cout << "CHEBYSHEV BENCHMARK: " << numFrames << " frames, tolerance " << constraintTolerance << ", at most "
+		<< maxNumConstraintIts << " sweeps per step, Young's modulus " << settings.youngsModulus << "." << std::endl;
+
+	const int numResolutions = 3;
+	const int widths[numResolutions] = { 10, 20, 30 };
+
+	for (int r = 0; r < numResolutions; ++r)
+	{
+		const int width = widths[r];
+		const int height = (width * 6) / 10;
+		const int depth = (width * 6) / 10;
+
+		PBDSolverSettings plainSettings = benchmarkSettings;
+		plainSettings.useChebyshevAcceleration = false;
+		PBDSolverSettings acceleratedSettings = benchmarkSettings;
+		acceleratedSettings.useChebyshevAcceleration = true;
+
+		BenchmarkRunResult plain;
+		BenchmarkRunResult accelerated;
+		BenchmarkRun::measureTetBar(plainSettings, width, height, depth, numFrames, plain);
+		BenchmarkRun::measureTetBar(acceleratedSettings, width, height, depth, numFrames, accelerated);
+
+		std::cout << "tet bar [ " << width << " x " << height << " x " << depth << " ]:" << std::endl;
+		BenchmarkRun::printComparison("plain", plain, "Chebyshev", accelerated, numFrames);
+	}
+
+	return true;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "PBDSolverSettings.h"
+
+//Number of sweeps the multi-threaded solver needs to reach a constraint tolerance with and without Chebyshev
+//acceleration, on generated tet bars of increasing resolution. Every run iterates until the residual drops below
+//the tolerance (or the sweep limit is hit); the final positions of both runs are compared against each other.
+class ChebyshevBenchmark
+{
+public:
+	static bool run(const PBDSolverSettings& settings, int numFrames, float constraintTolerance, int maxNumConstraintIts);
+
+private:
+	ChebyshevBenchmark();
+	~ChebyshevBenchmark();
+};
@@ -34,7 +34,7 @@ bool PointInTriangle(Eigen::Vector3f& p, Eigen::Vector3f& a, Eigen::Vector3f& b,
 	return (SameSide(p, a, b, c) && SameSide(p, b, a, c) && SameSide(p, c, a, b));
 }
 void
-CollisionMesh::resolveParticleCollisions(std::vector<PBDParticle>& particles)
+CollisionMesh::resolveParticleCollisions(PBDParticleStore& particles)
 {
 	//for all particles
 	for (int p = 0; p < particles.size(); ++p)
@@ -49,16 +49,16 @@ CollisionMesh::resolveParticleCollisions(std::vector<PBDParticle>& particles)
 			Eigen::Vector3f p2 = m_reader->getPositions()[m_reader->getFaceIndices(t)[2]] + m_translation;
 
 
-			Eigen::Vector3f particle = particles[p].position();
+			Eigen::Vector3f particle = particles.position(p);
 
 			p0[1] = 0.0f;
 			p1[1] = 0.0f;
 			p2[1] = 0.0f;
 			particle[1] = 0.0f;
 
-			if (PointInTriangle(particle, p0, p1, p2) && particles[p].position()[1] > (m_reader->getPositions()[m_reader->getFaceIndices(t)[0]] + m_translation)[1])
+			if (PointInTriangle(particle, p0, p1, p2) && particles.position(p)[1] > (m_reader->getPositions()[m_reader->getFaceIndices(t)[0]] + m_translation)[1])
 			{
-				particles[p].position()[1] = (m_reader->getPositions()[m_reader->getFaceIndices(t)[0]] + m_translation)[1] - 1e-12f;
+				particles.position(p)[1] = (m_reader->getPositions()[m_reader->getFaceIndices(t)[0]] + m_translation)[1] - 1e-12f;
 			}
 		}
 	}
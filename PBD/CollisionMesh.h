@@ -17,7 +17,7 @@ public:
 
 	void readFromAbc(const std::string& fileName);
 
-	void resolveParticleCollisions(std::vector<PBDParticle>& particles);
+	void resolveParticleCollisions(PBDParticleStore& particles);
 
 	Eigen::Vector3f& getCollisionMeshTranslation()
 	{
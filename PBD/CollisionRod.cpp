@@ -87,7 +87,7 @@ const Eigen::Vector3f& x1, const Eigen::Vector3f& x2, Eigen::Vector3f& temp, Eig
 
 
 void
-CollisionRod::resolveParticleCollisions(std::vector<PBDParticle>& particles, int systemFrame, float timeStep,
+CollisionRod::resolveParticleCollisions(PBDParticleStore& particles, int systemFrame, float timeStep,
 int numSpheres, float sphereRadius)
 {
 	timeStep *= 8.0f;
@@ -127,15 +127,15 @@ int numSpheres, float sphereRadius)
 		Eigen::Vector3f temp;
 		for (int p = 0; p < particles.size(); ++p)
 		{
-			if ((particles[p].position() - sphereCentre).squaredNorm() < sphereRadius)
+			if ((particles.position(p) - sphereCentre).squaredNorm() < sphereRadius)
 			{
 				//enforce distant constraint
-				float w2 = particles[p].inverseMass();
-				Eigen::Vector3f x2 = particles[p].position();
+				float w2 = particles.inverseMass(p);
+				Eigen::Vector3f x2 = particles.position(p);
 				Eigen::Vector3f deltaX;
 				//computeDeltaXPositionConstraint(0.0f, w2, sphereRadius + 1e-15, sphereCentre, x2, temp, deltaX);
 				computeDeltaXPositionConstraint(w2, 0.0f, sphereRadius, x2, sphereCentre, temp, deltaX);
-				particles[p].position() += deltaX;
+				particles.position(p) += deltaX;
 			}
 		}
 	}
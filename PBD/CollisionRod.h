@@ -17,7 +17,7 @@ public:
 
 	void readFromAbc(const std::string& fileName, const std::vector<std::string>& topBottomTransformNames);
 
-	void resolveParticleCollisions(std::vector<PBDParticle>& particles, int systemFrame, float timeStep,
+	void resolveParticleCollisions(PBDParticleStore& particles, int systemFrame, float timeStep,
 		int numSpheres, float sphereRadius);
 
 	Eigen::Vector3f& getCollisionMeshTranslation()
@@ -12,7 +12,7 @@ CollisionSphere::CollisionSphere()
 	m_frameLimit == -1;
 	m_translation.setZero();
 	m_previousCollisionSphereCentre = Eigen::Vector3f(-1.119f, -1.119f, -1.771f);
-	m_lastProcessedFrame = -1;
+	m_lastProcessedFrame = -1.0f;
 }
 
 
@@ -30,7 +30,7 @@ CollisionSphere::readFromAbc(const std::string& fileName, const std::string& tra
 }
 
 void
-CollisionSphere::resolveParticleCollisions(std::vector<PBDParticle>& particles, int systemFrame, float timeStep,
+CollisionSphere::resolveParticleCollisions(PBDParticleStore& particles, int systemFrame, float timeStep,
 float sphereRadius)
 {
 	timeStep *= 4.0f;
@@ -64,7 +64,7 @@ float sphereRadius)
 	//std::cout << sphereCentre << std::endl;
 	for (int p = 0; p < particles.size(); ++p)
 	{;
-		if (std::sqrtf((sphereCentre - particles[p].position()).squaredNorm()) < sphereRadius)
+		if (std::sqrtf((sphereCentre - particles.position(p)).squaredNorm()) < sphereRadius)
 		{
 			Eigen::Vector3f sphereMotion;
 			Eigen::Vector3f particleMotion;
@@ -77,33 +77,33 @@ float sphereRadius)
 				sphereMotion = sphereCentre - m_previousCollisionSphereCentre;
 			}
 
-			particleMotion = particles[p].position() - particles[p].previousPosition();
+			particleMotion = particles.position(p) - particles.previousPosition(p);
 
-			float penetrationAmount = sphereRadius - std::sqrtf((sphereCentre - particles[p].position()).squaredNorm());
+			float penetrationAmount = sphereRadius - std::sqrtf((sphereCentre - particles.position(p)).squaredNorm());
 
 			//std::cout << penetrationAmount << std::endl;
 
 			//if (sphereMotion.squaredNorm() == 0.0f) //interpenetration caused by particles
 			//{
-			//	particles[p].position() -= particleMotion.normalized() * penetrationAmount;
+			//	particles.position(p) -= particleMotion.normalized() * penetrationAmount;
 			//}
 			//else //interpenetration caused by sphere
 			//{
 			//	std::vector<Eigen::Vector3f> intersectionPoints(2);
 			//	int numIntersections;
 
-			//	particles[p].position() += sphereMotion.normalized() * penetrationAmount;
+			//	particles.position(p) += sphereMotion.normalized() * penetrationAmount;
 			//}
-			particles[p].position() -= (sphereCentre - particles[p].position()).normalized() * penetrationAmount;
+			particles.position(p) -= (sphereCentre - particles.position(p)).normalized() * penetrationAmount;
 
 			//std::cout << "eC";
 			//enforce distant constraint
-			//float w2 = particles[p].inverseMass();
-			//Eigen::Vector3f x2 = particles[p].position();
+			//float w2 = particles.inverseMass(p);
+			//Eigen::Vector3f x2 = particles.position(p);
 			//Eigen::Vector3f deltaX;
 			//Eigen::Vector3f temp;
 			//computeDeltaXPositionConstraint(0.0f, w2, sphereRadius + 1e-15, sphereCentre, x2, temp, deltaX);
-			//particles[p].position() += deltaX;
+			//particles.position(p) += deltaX;
 
 			m_previousCollisionSphereCentre = sphereCentre;
 		}
@@ -111,7 +111,7 @@ float sphereRadius)
 }
 
 void
-CollisionSphere::calculateNewSphereCentre(int systemFrame, float timeStep)
+CollisionSphere::calculateNewSphereCentre(float systemFrame, float timeStep)
 {
 	//Don't process frames twice
 	if (systemFrame == m_lastProcessedFrame)
@@ -149,14 +149,15 @@ CollisionSphere::calculateNewSphereCentre(int systemFrame, float timeStep)
 	m_lastProcessedFrame = systemFrame;
 }
 
-void
-CollisionSphere::resolveParticleCollisions_SAFE(std::vector<PBDParticle>& particles, int systemFrame, float timeStep,
+int
+CollisionSphere::resolveParticleCollisions_SAFE(PBDParticleStore& particles, int systemFrame, float timeStep,
 	float sphereRadius, int start, int end)
 {
+	int numCorrections = 0;
 	Eigen::Vector3f sphereCentre = m_collisionSphereCentre;
 	for (int p = start; p != end; ++p)
 	{
-		if (std::sqrtf((sphereCentre - particles[p].position()).squaredNorm()) < sphereRadius)
+		if (std::sqrtf((sphereCentre - particles.position(p)).squaredNorm()) < sphereRadius)
 		{
 			Eigen::Vector3f sphereMotion;
 			Eigen::Vector3f particleMotion;
@@ -169,11 +170,11 @@ CollisionSphere::resolveParticleCollisions_SAFE(std::vector<PBDParticle>& partic
 				sphereMotion = sphereCentre - m_previousCollisionSphereCentre;
 			}
 
-			particleMotion = particles[p].position() - particles[p].previousPosition();
+			particleMotion = particles.position(p) - particles.previousPosition(p);
 
-			float penetrationAmount = sphereRadius - std::sqrtf((sphereCentre - particles[p].position()).squaredNorm());
+			float penetrationAmount = sphereRadius - std::sqrtf((sphereCentre - particles.position(p)).squaredNorm());
 			
-			Eigen::Vector3f correction = (sphereCentre - particles[p].position()).normalized() * penetrationAmount;
+			Eigen::Vector3f correction = (sphereCentre - particles.position(p)).normalized() * penetrationAmount;
 
 			if (std::isnan(correction[0]) || std::isinf(correction[0])
 				|| std::isnan(correction[1]) || std::isinf(correction[1])
@@ -182,7 +183,8 @@ CollisionSphere::resolveParticleCollisions_SAFE(std::vector<PBDParticle>& partic
 				std::cout << "ERROR in spher collision: NaN result!" << std::endl;
 			}
 
-			particles[p].position() -= correction;
+			particles.position(p) -= correction;
+			++numCorrections;
 			//for (int n = 0; n < particles[p].getContainingTetIdxs().size(); ++n)
 			//{
 			//	
@@ -190,7 +192,7 @@ CollisionSphere::resolveParticleCollisions_SAFE(std::vector<PBDParticle>& partic
 			continue;
 		}
 		//sphereRadius += sphereRadius / 16.0f;
-		//if (std::sqrtf((sphereCentre - particles[p].position()).squaredNorm()) < sphereRadius)
+		//if (std::sqrtf((sphereCentre - particles.position(p)).squaredNorm()) < sphereRadius)
 		//{
 		//	Eigen::Vector3f sphereMotion;
 		//	Eigen::Vector3f particleMotion;
@@ -203,13 +205,15 @@ CollisionSphere::resolveParticleCollisions_SAFE(std::vector<PBDParticle>& partic
 		//		sphereMotion = sphereCentre - m_previousCollisionSphereCentre;
 		//	}
 
-		//	particleMotion = particles[p].position() - particles[p].previousPosition();
+		//	particleMotion = particles.position(p) - particles.previousPosition(p);
 
-		//	float penetrationAmount = (sphereRadius - std::sqrtf((sphereCentre - particles[p].position()).squaredNorm())) / 2;
+		//	float penetrationAmount = (sphereRadius - std::sqrtf((sphereCentre - particles.position(p)).squaredNorm())) / 2;
 
-		//	particles[p].position() -= (sphereCentre - particles[p].position()).normalized() * penetrationAmount;
+		//	particles.position(p) -= (sphereCentre - particles.position(p)).normalized() * penetrationAmount;
 		//}
 	}
+
+	return numCorrections;
 }
 
 
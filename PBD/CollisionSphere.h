@@ -17,12 +17,14 @@ public:
 
 	void readFromAbc(const std::string& fileName, const std::string& transformName);
 
-	void resolveParticleCollisions(std::vector<PBDParticle>& particles, int systemFrame, float timeStep,
+	void resolveParticleCollisions(PBDParticleStore& particles, int systemFrame, float timeStep,
 		float sphereRadius);
 
-	void calculateNewSphereCentre(int systemFrame, float timeStep);
+	//Fractional frames (substeps) interpolate between the two neighbouring samples
+	void calculateNewSphereCentre(float systemFrame, float timeStep);
 
-	void resolveParticleCollisions_SAFE(std::vector<PBDParticle>& particles, int systemFrame, float timeStep,
+	//Returns the number of particles in [start, end) moved out of the sphere
+	int resolveParticleCollisions_SAFE(PBDParticleStore& particles, int systemFrame, float timeStep,
 		float sphereRadius,
 		int start, int end);
 
@@ -37,6 +39,18 @@ public:
 		return m_translation;
 	}
 
+	//Centre at the current / previous calculateNewSphereCentre call
+	const Eigen::Vector3f& getCollisionSphereCentre() const { return m_collisionSphereCentre; }
+	const Eigen::Vector3f& getPreviousCollisionSphereCentre() const { return m_previousCollisionSphereCentre; }
+
+	//Places a static sphere without an Alembic transform (e.g. for BenchmarkSuite); the sphere does not move until the
+	//next calculateNewSphereCentre call
+	void setCollisionSphereCentre(const Eigen::Vector3f& centre)
+	{
+		m_collisionSphereCentre = centre;
+		m_previousCollisionSphereCentre = centre;
+	}
+
 	void glRender(int systemFrame, float timeStep, float sphereRadius);
 
 	int& getFrameLimit(){ return m_frameLimit; }
@@ -52,7 +66,7 @@ private:
 
 	int m_frameLimit;
 
-	int m_lastProcessedFrame;
+	float m_lastProcessedFrame;
 
 	Eigen::Vector3f m_previousCollisionSphereCentre;
 };
@@ -3,7 +3,7 @@
 #include <iostream>
 
 
-FiberMesh::FiberMesh(std::shared_ptr<std::vector<PBDParticle>> particles, std::vector<PBDTetrahedra3d>* tetrahedra)
+FiberMesh::FiberMesh(std::shared_ptr<PBDParticleStore> particles, std::vector<PBDTetrahedra3d>* tetrahedra)
 {
 }
 
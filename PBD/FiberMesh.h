@@ -12,7 +12,7 @@
 class FiberMesh
 {
 public:
-	FiberMesh(std::shared_ptr<std::vector<PBDParticle>> particles, std::vector<PBDTetrahedra3d>* tetrahedra);
+	FiberMesh(std::shared_ptr<PBDParticleStore> particles, std::vector<PBDTetrahedra3d>* tetrahedra);
 	~FiberMesh();
 
 
@@ -31,7 +31,7 @@ private:
 	std::vector<float> m_vertices;
 	std::vector<int> faces;
 
-	std::shared_ptr<std::vector<PBDParticle>> m_particles;
+	std::shared_ptr<PBDParticleStore> m_particles;
 	std::vector<PBDTetrahedra3d>* m_tetrahedra;
 };
 
@@ -37,7 +37,7 @@ GPUPBD_Solver::determineCUDALaunchParameters(int numParticles)
 
 void
 GPUPBD_Solver::setup(std::vector<PBDTetrahedra3d>& tetrahedra,
-	std::shared_ptr<std::vector<PBDParticle>>& particles)
+	std::shared_ptr<PBDParticleStore>& particles)
 {
 	//0. Determine CUDA Launch parameters
 	determineCUDALaunchParameters(tetrahedra.size());
@@ -86,7 +86,7 @@ GPUPBD_Solver::setup(std::vector<PBDTetrahedra3d>& tetrahedra,
 }
 
 void
-GPUPBD_Solver::advanceSystem(std::shared_ptr<std::vector<PBDParticle>>& particles,
+GPUPBD_Solver::advanceSystem(std::shared_ptr<PBDParticleStore>& particles,
 	const PBDSolverSettings& settings)
 {
 	//check that the system is set up correctly
@@ -13,9 +13,9 @@ public:
 	~GPUPBD_Solver();
 
 	void setup(std::vector<PBDTetrahedra3d>& tetrahedra,
-		std::shared_ptr<std::vector<PBDParticle>>& particles);
+		std::shared_ptr<PBDParticleStore>& particles);
 
-	void advanceSystem(std::shared_ptr<std::vector<PBDParticle>>& particles,
+	void advanceSystem(std::shared_ptr<PBDParticleStore>& particles,
 		const PBDSolverSettings& settings);
 
 private:
@@ -0,0 +1,257 @@
+#include "KernelCheck.h"
+
+#include <iostream>
+#include <random>
+#include <memory>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#include <Eigen\Dense>
+
+#include "PBDParticleStore.h"
+#include "PBDTetrahedra3d.h"
+#include "PBDGeometricConstraints.h"
+#include "PBDProjectionResidual.h"
+#include "PBDSolverBatchKernel.h"
+
+//same signed volume as PBDTetrahedra3d::getUndeformedVolumeAlternative
+static float computeSignedVolume(const PBDParticleStore& particles)
+{
+	return 1.0f / 6.0f * (particles.position(1) - particles.position(0)).cross(particles.position(2) - particles.position(0))
+		.dot(particles.position(3) - particles.position(0));
+}
+
+KernelCheck::KernelCheck()
+{
+}
+
+
+KernelCheck::~KernelCheck()
+{
+}
+
+bool
+KernelCheck::checkVolumeProjection()
+{
+	//the remaining volume error is quadratic in the deformation; with 2% of the edge length it has to drop by at least
+	//90% (a multiplier missing the factor 6 of the gradients removes about a sixth of it)
+	const float maxRemainingFraction = 0.1f;
+	const float maxDisplacement = 0.02f;
+	const int numDeformations = 1000;
+
+	std::mt19937 generator(42);
+	std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+	float maxFraction = 0.0f;
+	for (int d = 0; d < numDeformations; ++d)
+	{
+		std::shared_ptr<PBDParticleStore> particles = std::make_shared<PBDParticleStore>();
+		particles->addParticle(Eigen::Vector3f(0.0f, 0.0f, 0.0f), Eigen::Vector3f::Zero(), 1.0f);
+		particles->addParticle(Eigen::Vector3f(1.0f, 0.0f, 0.0f), Eigen::Vector3f::Zero(), 1.0f);
+		particles->addParticle(Eigen::Vector3f(0.0f, 1.0f, 0.0f), Eigen::Vector3f::Zero(), 1.0f);
+		particles->addParticle(Eigen::Vector3f(0.0f, 0.0f, 1.0f), Eigen::Vector3f::Zero(), 1.0f);
+
+		std::vector<int> vertexIndices = { 0, 1, 2, 3 };
+		std::vector<PBDTetrahedra3d> tetrahedra;
+		tetrahedra.push_back(PBDTetrahedra3d(vertexIndices, particles, 0));
+		particles->initialiseTetAdjacency(tetrahedra);
+
+		PBDGeometricConstraints constraints;
+		constraints.initialise(tetrahedra, particles->size());
+
+		//also vary the masses, incl. a fixed vertex
+		for (int p = 0; p < 4; ++p)
+		{
+			particles->position(p) += maxDisplacement * Eigen::Vector3f(uniform(generator), uniform(generator), uniform(generator));
+			particles->inverseMass(p) = (d % 4 == 0 && p == 0) ? 0.0f : 1.0f + 0.5f * uniform(generator);
+		}
+
+		const float restVolume = tetrahedra[0].getUndeformedVolumeAlternative();
+		const float initialError = std::fabs(computeSignedVolume(*particles) - restVolume);
+		if (initialError < 1.0e-4f * std::fabs(restVolume))
+		{
+			continue;
+		}
+
+		PBDProjectionResidualReduction residual;
+		constraints.projectVolumeConstraints(*particles, 1.0f, NULL, residual);
+
+		maxFraction = std::max(maxFraction, std::fabs(computeSignedVolume(*particles) - restVolume) / initialError);
+	}
+
+	const bool passed = maxFraction <= maxRemainingFraction;
+	std::cout << (passed ? "PASSED" : "FAILED") << ": volume constraint, largest remaining fraction of the volume error "
+		<< "after one projection " << maxFraction << " (tolerance " << maxRemainingFraction << ")" << std::endl;
+
+	return passed;
+}
+
+void
+KernelCheck::computeCorrections(PBDConstraintKernels::ProjectTetrahedraFunction projectTetrahedra,
+	PBDSimulationContext& context, const std::vector<int>& colorTetIdxs, std::vector<Eigen::Vector3f>& corrections)
+{
+	//the kernels update the viscous stresses and multipliers, so both start from copies
+	PBDTetRestStateTable tetRestStates = context.getSolver().getTetRestStates();
+	PBDParticleStore particles = *context.getParticles();
+	std::vector<CollisionSphere> noColliders;
+
+	PBDInversionHandlingCounts inversionCounts;
+	PBDProjectionResidual residual;
+	projectTetrahedra(tetRestStates, particles, context.getSettings(), noColliders, &colorTetIdxs[0], colorTetIdxs.size(),
+		inversionCounts, residual);
+
+	corrections.resize(4 * colorTetIdxs.size());
+	for (int i = 0; i < colorTetIdxs.size(); ++i)
+	{
+		const PBDTetRestState& rest = tetRestStates.getRestState(colorTetIdxs[i]);
+		for (int v = 0; v < 4; ++v)
+		{
+			const int p = rest.vertexIndices[v];
+			corrections[4 * i + v] = particles.position(p) - context.getParticles()->position(p);
+		}
+	}
+}
+
+bool
+KernelCheck::checkBatchKernel(float maxRelativeDifference)
+{
+	if (PBDSolverBatchKernel::getInstructionSet() == PBDSolverBatchKernel::SCALAR)
+	{
+		std::cout << "SKIPPED: batch kernel, no SIMD instruction set on this CPU" << std::endl;
+		return true;
+	}
+
+	PBDSolverSettings baseSettings;
+	baseSettings.initialise();
+	baseSettings.youngsModulus = 10.0f;
+	baseSettings.poissonRatio = 0.4f;
+	baseSettings.deltaT = 0.005f;
+	baseSettings.alpha = 0.0f;
+	baseSettings.rho = 0.0f;
+	baseSettings.anisotropyParameter = 0.5f;
+	baseSettings.MR_a = Eigen::Vector3f(0.0f, 1.0f, 1.0f);
+
+	const int numConfigurations = 5;
+	const char* names[numConfigurations] = { "Neo-Hookean, adaptive inversion handling", "Neo-Hookean, SVD for every tet",
+		"Neo-Hookean, viscoelastic", "Neo-Hookean, XPBD", "Neo-Hookean fibre" };
+
+	bool passed = true;
+	for (int c = 0; c < numConfigurations; ++c)
+	{
+		PBDSolverSettings settings = baseSettings;
+		switch (c)
+		{
+		case 1:
+			settings.useInversionFastPath = false;
+			break;
+		case 2:
+			settings.alpha = 0.25f;
+			settings.rho = 0.1f;
+			break;
+		case 3:
+			settings.useXPBD = true;
+			break;
+		case 4:
+			settings.materialModel = PBDSolverSettings::NEO_HOOKEAN_FIBER;
+			break;
+		default:
+			break;
+		}
+
+		PBDSimulationContext context;
+		context.generateTetBar(8, 5, 5);
+		context.initialiseFirstFrame(settings);
+		context.getSolver().getTetRestStates().resetLagrangeMultipliers(context.getSettings());
+
+		const PBDConstraintKernels::ProjectTetrahedraFunction batchKernel =
+			PBDSolverBatchKernel::selectProjectTetrahedra(context.getSettings(), false);
+		const PBDConstraintKernels::ProjectTetrahedraFunction scalarKernel =
+			PBDConstraintKernels::selectScalarProjection(context.getSettings(), false);
+		if (batchKernel == NULL || scalarKernel == NULL)
+		{
+			std::cout << "FAILED: batch kernel [ " << names[c] << " ], no kernel for the settings" << std::endl;
+			passed = false;
+			continue;
+		}
+
+		//deform the bar (the cells are 0.3 wide), then invert and flatten tets of the colour; its tets share no particles
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+		PBDParticleStore& particles = *context.getParticles();
+		for (int p = 0; p < particles.size(); ++p)
+		{
+			particles.position(p) += 0.05f * Eigen::Vector3f(uniform(generator), uniform(generator), uniform(generator));
+		}
+
+		const std::vector<int>& colorTetIdxs = context.getSolver().getTetrahedraColoring().getColor(0);
+		for (int i = 0; i < colorTetIdxs.size(); ++i)
+		{
+			const PBDTetRestState& rest = context.getSolver().getTetRestStates().getRestState(colorTetIdxs[i]);
+			const Eigen::Vector3f& x0 = particles.position(rest.vertexIndices[0]);
+			const Eigen::Vector3f& x1 = particles.position(rest.vertexIndices[1]);
+			const Eigen::Vector3f& x2 = particles.position(rest.vertexIndices[2]);
+			Eigen::Vector3f& x3 = particles.position(rest.vertexIndices[3]);
+
+			const Eigen::Vector3f normal = (x1 - x0).cross(x2 - x0).normalized();
+			const float height = normal.dot(x3 - x0);
+
+			if (i % 3 == 1)
+			{
+				//mirrored through the opposite face
+				x3 -= 2.0f * height * normal;
+			}
+			else if (i % 3 == 2)
+			{
+				//0.1% of its height left
+				x3 -= 0.999f * height * normal;
+			}
+		}
+
+		std::vector<Eigen::Vector3f> batchCorrections;
+		std::vector<Eigen::Vector3f> scalarCorrections;
+		computeCorrections(batchKernel, context, colorTetIdxs, batchCorrections);
+		computeCorrections(scalarKernel, context, colorTetIdxs, scalarCorrections);
+
+		float maxDifference = 0.0f;
+		for (int i = 0; i < colorTetIdxs.size(); ++i)
+		{
+			float difference = 0.0f;
+			float scale = 1.0e-6f;
+			for (int v = 0; v < 4; ++v)
+			{
+				difference = std::max(difference, (batchCorrections[4 * i + v] - scalarCorrections[4 * i + v]).norm());
+				scale = std::max(scale, scalarCorrections[4 * i + v].norm());
+			}
+
+			//NaN fails as well
+			const float relativeDifference = difference / scale;
+			if (!(relativeDifference <= maxDifference))
+			{
+				maxDifference = std::isnan(relativeDifference) ? std::numeric_limits<float>::infinity() : relativeDifference;
+			}
+		}
+
+		const bool configurationPassed = maxDifference <= maxRelativeDifference;
+		std::cout << (configurationPassed ? "PASSED" : "FAILED") << ": batch kernel [ " << names[c] << " ], "
+			<< colorTetIdxs.size() << " tets, largest relative difference to the scalar kernel " << maxDifference
+			<< " (tolerance " << maxRelativeDifference << ")" << std::endl;
+
+		passed = passed && configurationPassed;
+	}
+
+	return passed;
+}
+
+bool
+KernelCheck::run()
+{
+	std::cout << "KERNEL CHECK" << std::endl;
+
+	bool passed = checkVolumeProjection();
+	passed = checkBatchKernel(1.0e-3f) && passed;
+
+	return passed;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+#include <Eigen\Dense>
+
+#include "PBDConstraintKernels.h"
+#include "PBDSimulationContext.h"
+
+//Correctness checks of the constraint kernels (the KERNEL_CHECK mode). Every check prints its largest error and
+//fails if that exceeds the tolerance it states.
+class KernelCheck
+{
+public:
+	//Returns false if any check fails.
+	static bool run();
+
+private:
+	//A single tet projected once by its volume constraint with stiffness 1 has to reach its rest volume up to the
+	//linearisation error, on random deformations of a few percent of its edge length.
+	static bool checkVolumeProjection();
+
+	//One sweep over the first colour of a deformed tet bar through the SIMD batch kernel and the scalar kernel, for
+	//the kernel policies the batch kernel covers. A third of the colour's tets is inverted and another third nearly
+	//flat. Per tet, the largest difference of the vertex corrections relative to the largest scalar correction has
+	//to stay below 'maxRelativeDifference'. Skipped on CPUs without a batch kernel.
+	static bool checkBatchKernel(float maxRelativeDifference);
+
+	//The corrections of the tets of 'colorTetIdxs' made by 'projectTetrahedra' from the state of 'context', which is
+	//left untouched; 4 per tet
+	static void computeCorrections(PBDConstraintKernels::ProjectTetrahedraFunction projectTetrahedra,
+		PBDSimulationContext& context, const std::vector<int>& colorTetIdxs, std::vector<Eigen::Vector3f>& corrections);
+
+	KernelCheck();
+	~KernelCheck();
+};
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cmath>
+
+//Building blocks for code that is written once and instantiated both for single floats and for SIMD lane types
+//(see LaneMathAVX2.h). A lane type provides + - * /, lanesSqrt, lanesRsqrt, lanesAbs, lanesMin/Max, comparisons returning
+//masks and lanesSelect(mask, a, b); templates declare masks with 'auto' as the mask type differs per lane type.
+
+//The helpers are tiny and used from kernels with many instantiations (see PBDConstraintKernelPolicy.h), which can
+//exhaust the compiler's inlining budget for a translation unit; they are therefore always inlined.
+#ifdef _MSC_VER
+#define LANE_INLINE __forceinline
+#else
+#define LANE_INLINE inline __attribute__((always_inline))
+#endif
+
+//SCALAR LANES ------------------------------------------------------------------------------------------------------------------
+
+LANE_INLINE float lanesSqrt(float a) { return std::sqrt(a); }
+LANE_INLINE float lanesRsqrt(float a) { return 1.0f / std::sqrt(a); }
+LANE_INLINE float lanesAbs(float a) { return std::fabs(a); }
+
+//NaN in 'a' propagates, like the 'if (a < b) a = b' clamps of the scalar kernel
+LANE_INLINE float lanesMax(float a, float b) { return (a < b) ? b : a; }
+LANE_INLINE float lanesMin(float a, float b) { return (b < a) ? b : a; }
+
+LANE_INLINE bool lanesLess(float a, float b) { return a < b; }
+LANE_INLINE bool lanesLessEqual(float a, float b) { return a <= b; }
+LANE_INLINE bool lanesEqual(float a, float b) { return a == b; }
+LANE_INLINE bool lanesNotEqual(float a, float b) { return a != b; }
+
+LANE_INLINE bool lanesAnd(bool a, bool b) { return a && b; }
+LANE_INLINE bool lanesOr(bool a, bool b) { return a || b; }
+LANE_INLINE bool lanesAndNot(bool a, bool b) { return a && !b; }
+
+//mask ? a : b
+LANE_INLINE float lanesSelect(bool mask, float a, float b) { return mask ? a : b; }
+
+//3x3 ALGEBRA -------------------------------------------------------------------------------------------------------------------
+
+template<typename Real>
+struct LaneMat3
+{
+	Real m[3][3];
+};
+
+template<typename Real>
+LANE_INLINE void laneSetIdentity(LaneMat3<Real>& A)
+{
+	for (int r = 0; r < 3; ++r)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			A.m[r][c] = Real(r == c ? 1.0f : 0.0f);
+		}
+	}
+}
+
+template<typename Real>
+LANE_INLINE void laneSetDiagonal(LaneMat3<Real>& A, const Real d[3])
+{
+	for (int r = 0; r < 3; ++r)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			A.m[r][c] = r == c ? d[r] : Real(0.0f);
+		}
+	}
+}
+
+//A * B
+template<typename Real>
+LANE_INLINE LaneMat3<Real> laneMul(const LaneMat3<Real>& A, const LaneMat3<Real>& B)
+{
+	LaneMat3<Real> C;
+	for (int r = 0; r < 3; ++r)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			C.m[r][c] = A.m[r][0] * B.m[0][c] + A.m[r][1] * B.m[1][c] + A.m[r][2] * B.m[2][c];
+		}
+	}
+	return C;
+}
+
+//A^T * B
+template<typename Real>
+LANE_INLINE LaneMat3<Real> laneMulTransposeA(const LaneMat3<Real>& A, const LaneMat3<Real>& B)
+{
+	LaneMat3<Real> C;
+	for (int r = 0; r < 3; ++r)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			C.m[r][c] = A.m[0][r] * B.m[0][c] + A.m[1][r] * B.m[1][c] + A.m[2][r] * B.m[2][c];
+		}
+	}
+	return C;
+}
+
+//A * B^T
+template<typename Real>
+LANE_INLINE LaneMat3<Real> laneMulTransposeB(const LaneMat3<Real>& A, const LaneMat3<Real>& B)
+{
+	LaneMat3<Real> C;
+	for (int r = 0; r < 3; ++r)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			C.m[r][c] = A.m[r][0] * B.m[c][0] + A.m[r][1] * B.m[c][1] + A.m[r][2] * B.m[c][2];
+		}
+	}
+	return C;
+}
+
+template<typename Real>
+LANE_INLINE LaneMat3<Real> laneTranspose(const LaneMat3<Real>& A)
+{
+	LaneMat3<Real> B;
+	for (int r = 0; r < 3; ++r)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			B.m[r][c] = A.m[c][r];
+		}
+	}
+	return B;
+}
+
+template<typename Real>
+LANE_INLINE Real laneDeterminant(const LaneMat3<Real>& A)
+{
+	return A.m[0][0] * (A.m[1][1] * A.m[2][2] - A.m[1][2] * A.m[2][1])
+		- A.m[0][1] * (A.m[1][0] * A.m[2][2] - A.m[1][2] * A.m[2][0])
+		+ A.m[0][2] * (A.m[1][0] * A.m[2][1] - A.m[1][1] * A.m[2][0]);
+}
+
+template<typename Real>
+LANE_INLINE LaneMat3<Real> laneInverse(const LaneMat3<Real>& A)
+{
+	LaneMat3<Real> B;
+	B.m[0][0] = A.m[1][1] * A.m[2][2] - A.m[1][2] * A.m[2][1];
+	B.m[0][1] = A.m[0][2] * A.m[2][1] - A.m[0][1] * A.m[2][2];
+	B.m[0][2] = A.m[0][1] * A.m[1][2] - A.m[0][2] * A.m[1][1];
+	B.m[1][0] = A.m[1][2] * A.m[2][0] - A.m[1][0] * A.m[2][2];
+	B.m[1][1] = A.m[0][0] * A.m[2][2] - A.m[0][2] * A.m[2][0];
+	B.m[1][2] = A.m[0][2] * A.m[1][0] - A.m[0][0] * A.m[1][2];
+	B.m[2][0] = A.m[1][0] * A.m[2][1] - A.m[1][1] * A.m[2][0];
+	B.m[2][1] = A.m[0][1] * A.m[2][0] - A.m[0][0] * A.m[2][1];
+	B.m[2][2] = A.m[0][0] * A.m[1][1] - A.m[0][1] * A.m[1][0];
+
+	const Real invDet = Real(1.0f) / (A.m[0][0] * B.m[0][0] + A.m[0][1] * B.m[1][0] + A.m[0][2] * B.m[2][0]);
+	for (int r = 0; r < 3; ++r)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			B.m[r][c] = B.m[r][c] * invDet;
+		}
+	}
+	return B;
+}
+
+template<typename Real>
+LANE_INLINE Real laneTrace(const LaneMat3<Real>& A)
+{
+	return A.m[0][0] + A.m[1][1] + A.m[2][2];
+}
+
+template<typename Real>
+LANE_INLINE void laneScaleColumn(LaneMat3<Real>& A, int c, const Real& s)
+{
+	for (int r = 0; r < 3; ++r)
+	{
+		A.m[r][c] = A.m[r][c] * s;
+	}
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include "LaneMath.h"
+
+//Only to be included by translation units compiled with AVX2 code generation (/arch:AVX2). Uses nothing but
+//intrinsics, see PBDSolverBatchKernelAVX2.h.
+
+//Eight floats, e.g. one per tetrahedron. Comparisons return masks (all bits set per true lane) of the same type.
+struct LanesAVX2
+{
+	enum { numLanes = 8 };
+
+	__m256 v;
+
+	LANE_INLINE LanesAVX2() {}
+	LANE_INLINE LanesAVX2(__m256 in_v) : v(in_v) {}
+	LANE_INLINE LanesAVX2(float value) : v(_mm256_set1_ps(value)) {}
+
+	LANE_INLINE static LanesAVX2 load(const float* p) { return LanesAVX2(_mm256_loadu_ps(p)); }
+	LANE_INLINE void store(float* p) const { _mm256_storeu_ps(p, v); }
+};
+
+LANE_INLINE LanesAVX2 operator+(const LanesAVX2& a, const LanesAVX2& b) { return _mm256_add_ps(a.v, b.v); }
+LANE_INLINE LanesAVX2 operator-(const LanesAVX2& a, const LanesAVX2& b) { return _mm256_sub_ps(a.v, b.v); }
+LANE_INLINE LanesAVX2 operator*(const LanesAVX2& a, const LanesAVX2& b) { return _mm256_mul_ps(a.v, b.v); }
+LANE_INLINE LanesAVX2 operator/(const LanesAVX2& a, const LanesAVX2& b) { return _mm256_div_ps(a.v, b.v); }
+LANE_INLINE LanesAVX2 operator-(const LanesAVX2& a) { return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)); }
+
+LANE_INLINE LanesAVX2 lanesSqrt(const LanesAVX2& a) { return _mm256_sqrt_ps(a.v); }
+//1 / sqrt(a): hardware estimate refined by one Newton step (~1e-7 relative error)
+LANE_INLINE LanesAVX2 lanesRsqrt(const LanesAVX2& a)
+{
+	const __m256 y = _mm256_rsqrt_ps(a.v);
+	const __m256 ayy = _mm256_mul_ps(_mm256_mul_ps(a.v, y), y);
+	return _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), y), _mm256_sub_ps(_mm256_set1_ps(3.0f), ayy));
+}
+
+LANE_INLINE LanesAVX2 lanesAbs(const LanesAVX2& a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+
+//NaN in 'a' propagates, like the 'if (a < b) a = b' clamps of the scalar kernel
+LANE_INLINE LanesAVX2 lanesMax(const LanesAVX2& a, const LanesAVX2& b) { return _mm256_max_ps(b.v, a.v); }
+LANE_INLINE LanesAVX2 lanesMin(const LanesAVX2& a, const LanesAVX2& b) { return _mm256_min_ps(b.v, a.v); }
+
+LANE_INLINE LanesAVX2 lanesLess(const LanesAVX2& a, const LanesAVX2& b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+LANE_INLINE LanesAVX2 lanesLessEqual(const LanesAVX2& a, const LanesAVX2& b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+LANE_INLINE LanesAVX2 lanesEqual(const LanesAVX2& a, const LanesAVX2& b) { return _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ); }
+LANE_INLINE LanesAVX2 lanesNotEqual(const LanesAVX2& a, const LanesAVX2& b) { return _mm256_cmp_ps(a.v, b.v, _CMP_NEQ_UQ); }
+
+LANE_INLINE LanesAVX2 lanesAnd(const LanesAVX2& a, const LanesAVX2& b) { return _mm256_and_ps(a.v, b.v); }
+LANE_INLINE LanesAVX2 lanesOr(const LanesAVX2& a, const LanesAVX2& b) { return _mm256_or_ps(a.v, b.v); }
+LANE_INLINE LanesAVX2 lanesAndNot(const LanesAVX2& a, const LanesAVX2& b) { return _mm256_andnot_ps(b.v, a.v); }
+
+//mask ? a : b
+LANE_INLINE LanesAVX2 lanesSelect(const LanesAVX2& mask, const LanesAVX2& a, const LanesAVX2& b) { return _mm256_blendv_ps(b.v, a.v, mask.v); }
+
+//bit i set if lane i of the mask is set
+LANE_INLINE int lanesMoveMask(const LanesAVX2& mask) { return _mm256_movemask_ps(mask.v); }
+
+//+inf and a quiet NaN in all lanes
+LANE_INLINE __m256 lanesInfinityAVX2() { return _mm256_castsi256_ps(_mm256_set1_epi32(0x7f800000)); }
+LANE_INLINE __m256 lanesQuietNaNAVX2() { return _mm256_castsi256_ps(_mm256_set1_epi32(0x7fc00000)); }
+
+//neither NaN nor inf
+LANE_INLINE LanesAVX2 lanesIsFinite(const LanesAVX2& a) { return _mm256_cmp_ps(_mm256_sub_ps(a.v, a.v), _mm256_setzero_ps(), _CMP_EQ_OQ); }
+
+//Natural logarithm (Cephes logf polynomial), NaN for negative input and -inf for zero like std::log
+LANE_INLINE LanesAVX2 lanesLog(const LanesAVX2& a)
+{
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	__m256 x = _mm256_max_ps(a.v, _mm256_castsi256_ps(_mm256_set1_epi32(0x00800000)));
+
+	__m256i emm0 = _mm256_srli_epi32(_mm256_castps_si256(x), 23);
+	x = _mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(~0x7f800000)));
+	x = _mm256_or_ps(x, _mm256_set1_ps(0.5f));
+
+	emm0 = _mm256_sub_epi32(emm0, _mm256_set1_epi32(0x7f));
+	__m256 e = _mm256_add_ps(_mm256_cvtepi32_ps(emm0), one);
+
+	//x in [sqrt(0.5), sqrt(2))
+	__m256 mask = _mm256_cmp_ps(x, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+	__m256 tmp = _mm256_and_ps(x, mask);
+	x = _mm256_sub_ps(x, one);
+	e = _mm256_sub_ps(e, _mm256_and_ps(one, mask));
+	x = _mm256_add_ps(x, tmp);
+
+	__m256 z = _mm256_mul_ps(x, x);
+
+	__m256 y = _mm256_set1_ps(7.0376836292e-2f);
+	y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-1.1514610310e-1f));
+	y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.1676998740e-1f));
+	y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-1.2420140846e-1f));
+	y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.4249322787e-1f));
+	y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-1.6668057665e-1f));
+	y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(2.0000714765e-1f));
+	y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-2.4999993993e-1f));
+	y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(3.3333331174e-1f));
+	y = _mm256_mul_ps(_mm256_mul_ps(y, x), z);
+
+	y = _mm256_add_ps(y, _mm256_mul_ps(e, _mm256_set1_ps(-2.12194440e-4f)));
+	y = _mm256_sub_ps(y, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+
+	x = _mm256_add_ps(x, y);
+	x = _mm256_add_ps(x, _mm256_mul_ps(e, _mm256_set1_ps(0.693359375f)));
+
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 inf = lanesInfinityAVX2();
+	x = _mm256_blendv_ps(x, _mm256_sub_ps(zero, inf), _mm256_cmp_ps(a.v, zero, _CMP_EQ_OQ));
+	x = _mm256_blendv_ps(x, inf, _mm256_cmp_ps(a.v, inf, _CMP_EQ_OQ));
+	x = _mm256_blendv_ps(x, lanesQuietNaNAVX2(), _mm256_cmp_ps(a.v, zero, _CMP_NGE_UQ));
+	return x;
+}
+
+//Exponential (Cephes expf polynomial); NaN propagates, overflow gives inf
+LANE_INLINE LanesAVX2 lanesExp(const LanesAVX2& a)
+{
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 expHi = _mm256_set1_ps(88.3762626647949f);
+	const __m256 expLo = _mm256_set1_ps(-88.3762626647949f);
+
+	__m256 x = _mm256_min_ps(a.v, expHi);
+	x = _mm256_max_ps(x, expLo);
+
+	//exp(x) = 2^n * exp(g), n = round(x / ln(2))
+	__m256 fx = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)), _mm256_set1_ps(0.5f));
+	fx = _mm256_floor_ps(fx);
+
+	x = _mm256_sub_ps(x, _mm256_mul_ps(fx, _mm256_set1_ps(0.693359375f)));
+	x = _mm256_sub_ps(x, _mm256_mul_ps(fx, _mm256_set1_ps(-2.12194440e-4f)));
+
+	__m256 z = _mm256_mul_ps(x, x);
+
+	__m256 y = _mm256_set1_ps(1.9875691500e-4f);
+	y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.3981999507e-3f));
+	y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(8.3334519073e-3f));
+	y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(4.1665795894e-2f));
+	y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.6666665459e-1f));
+	y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(5.0000001201e-1f));
+	y = _mm256_add_ps(_mm256_mul_ps(y, z), x);
+	y = _mm256_add_ps(y, one);
+
+	__m256i emm0 = _mm256_cvttps_epi32(fx);
+	emm0 = _mm256_add_epi32(emm0, _mm256_set1_epi32(0x7f));
+	emm0 = _mm256_slli_epi32(emm0, 23);
+	y = _mm256_mul_ps(y, _mm256_castsi256_ps(emm0));
+
+	y = _mm256_blendv_ps(y, lanesInfinityAVX2(), _mm256_cmp_ps(a.v, expHi, _CMP_GT_OQ));
+	y = _mm256_blendv_ps(y, _mm256_setzero_ps(), _mm256_cmp_ps(a.v, expLo, _CMP_LT_OQ));
+	y = _mm256_blendv_ps(y, a.v, _mm256_cmp_ps(a.v, a.v, _CMP_UNORD_Q));
+	return y;
+}
+
+//a^b for a > 0 (NaN for a < 0, as std::pow with a non-integer exponent)
+LANE_INLINE LanesAVX2 lanesPow(const LanesAVX2& a, float b)
+{
+	return lanesExp(LanesAVX2(b) * lanesLog(a));
+}
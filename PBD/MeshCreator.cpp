@@ -14,7 +14,7 @@ MeshCreator::~MeshCreator()
 
 
 void
-MeshCreator::generateTetBar(std::shared_ptr<std::vector<PBDParticle>>& particles, std::vector<PBDTetrahedra3d>& tets,
+MeshCreator::generateTetBar(std::shared_ptr<PBDParticleStore>& particles, std::vector<PBDTetrahedra3d>& tets,
 int width, int height, int depth)
 {
 	std::vector<Eigen::Vector3f> points(width*height*depth);
@@ -55,23 +55,8 @@ int width, int height, int depth)
 				unsigned int p4 = i*height*depth + (j + 1)*depth + k;
 				unsigned int p5 = p4 + 1;
 
-				// Ensure that neighboring tetras are sharing faces
-				if ((i + j + k) % 2 == 1)
-				{
-					indices.push_back(p2); indices.push_back(p1); indices.push_back(p6); indices.push_back(p3);
-					indices.push_back(p6); indices.push_back(p3); indices.push_back(p4); indices.push_back(p7);
-					indices.push_back(p4); indices.push_back(p1); indices.push_back(p6); indices.push_back(p5);
-					indices.push_back(p3); indices.push_back(p1); indices.push_back(p4); indices.push_back(p0);
-					indices.push_back(p6); indices.push_back(p1); indices.push_back(p4); indices.push_back(p3);
-				}
-				else
-				{
-					indices.push_back(p0); indices.push_back(p2); indices.push_back(p5); indices.push_back(p1);
-					indices.push_back(p7); indices.push_back(p2); indices.push_back(p0); indices.push_back(p3);
-					indices.push_back(p5); indices.push_back(p2); indices.push_back(p7); indices.push_back(p6);
-					indices.push_back(p7); indices.push_back(p0); indices.push_back(p5); indices.push_back(p4);
-					indices.push_back(p0); indices.push_back(p2); indices.push_back(p7); indices.push_back(p5);
-				}
+				const unsigned int corners[8] = { p0, p1, p2, p3, p4, p5, p6, p7 };
+				addCubeTetrahedra(corners, (i + j + k) % 2 == 1, indices);
 			}
 		}
 	}
@@ -102,14 +87,16 @@ int width, int height, int depth)
 	//Generate Instances
 
 	//Particles
-	particles = std::make_shared<std::vector<PBDParticle>>();
+	particles = std::make_shared<PBDParticleStore>();
+
+	particles->reserve(numVertices);
 
 	Eigen::Vector3f velocity;
 	velocity.setZero();
 
 	for (int i = 0; i < numVertices; ++i)
 	{
-		(*particles).push_back(PBDParticle(points[i], velocity, InverseMasses[i]));
+		particles->addParticle(points[i], velocity, InverseMasses[i]);
 	}
 
 	//Tets
@@ -123,10 +110,108 @@ int width, int height, int depth)
 
 		tets.push_back(PBDTetrahedra3d(localIndices, particles, i));
 	}
+
+	particles->initialiseTetAdjacency(tets);
+}
+
+void
+MeshCreator::addCubeTetrahedra(const unsigned int corners[8], bool oddCell, std::vector<int>& indices)
+{
+	const unsigned int p0 = corners[0];
+	const unsigned int p1 = corners[1];
+	const unsigned int p2 = corners[2];
+	const unsigned int p3 = corners[3];
+	const unsigned int p4 = corners[4];
+	const unsigned int p5 = corners[5];
+	const unsigned int p6 = corners[6];
+	const unsigned int p7 = corners[7];
+
+	// Ensure that neighboring tetras are sharing faces
+	if (oddCell)
+	{
+		indices.push_back(p2); indices.push_back(p1); indices.push_back(p6); indices.push_back(p3);
+		indices.push_back(p6); indices.push_back(p3); indices.push_back(p4); indices.push_back(p7);
+		indices.push_back(p4); indices.push_back(p1); indices.push_back(p6); indices.push_back(p5);
+		indices.push_back(p3); indices.push_back(p1); indices.push_back(p4); indices.push_back(p0);
+		indices.push_back(p6); indices.push_back(p1); indices.push_back(p4); indices.push_back(p3);
+	}
+	else
+	{
+		indices.push_back(p0); indices.push_back(p2); indices.push_back(p5); indices.push_back(p1);
+		indices.push_back(p7); indices.push_back(p2); indices.push_back(p0); indices.push_back(p3);
+		indices.push_back(p5); indices.push_back(p2); indices.push_back(p7); indices.push_back(p6);
+		indices.push_back(p7); indices.push_back(p0); indices.push_back(p5); indices.push_back(p4);
+		indices.push_back(p0); indices.push_back(p2); indices.push_back(p7); indices.push_back(p5);
+	}
+}
+
+void
+MeshCreator::generateTetGridFromCells(std::shared_ptr<PBDParticleStore>& particles, std::vector<PBDTetrahedra3d>& tets,
+	const Eigen::Vector3f& origin, float cellSize, const std::vector<Eigen::Vector3i>& cells)
+{
+	Eigen::Vector3i gridSize(1, 1, 1);
+	for (int c = 0; c < cells.size(); ++c)
+	{
+		gridSize = gridSize.cwiseMax(cells[c] + Eigen::Vector3i(2, 2, 2));
+	}
+
+	//only the corners of the given cells become particles
+	std::vector<int> gridToParticle(gridSize[0] * gridSize[1] * gridSize[2], -1);
+
+	particles = std::make_shared<PBDParticleStore>();
+	tets.clear();
+
+	Eigen::Vector3f velocity;
+	velocity.setZero();
+
+	std::vector<int> indices;
+	indices.reserve(cells.size() * 20);
+
+	for (int c = 0; c < cells.size(); ++c)
+	{
+		const int i = cells[c][0];
+		const int j = cells[c][1];
+		const int k = cells[c][2];
+
+		//same numbering as in generateTetBar
+		const Eigen::Vector3i cornerOffsets[8] = {
+			Eigen::Vector3i(0, 0, 0), Eigen::Vector3i(0, 0, 1), Eigen::Vector3i(1, 0, 1), Eigen::Vector3i(1, 0, 0),
+			Eigen::Vector3i(0, 1, 0), Eigen::Vector3i(0, 1, 1), Eigen::Vector3i(1, 1, 1), Eigen::Vector3i(1, 1, 0) };
+
+		unsigned int corners[8];
+		for (int v = 0; v < 8; ++v)
+		{
+			const Eigen::Vector3i gridPoint = cells[c] + cornerOffsets[v];
+			int& particleIdx = gridToParticle[gridPoint[0] * gridSize[1] * gridSize[2] + gridPoint[1] * gridSize[2] + gridPoint[2]];
+
+			if (particleIdx < 0)
+			{
+				particleIdx = particles->addParticle(origin + cellSize * gridPoint.cast<float>(), velocity, 1.0f);
+			}
+			corners[v] = particleIdx;
+		}
+
+		addCubeTetrahedra(corners, (i + j + k) % 2 == 1, indices);
+	}
+
+	const int numTets = indices.size() / 4;
+	tets.reserve(numTets);
+	for (int i = 0; i < numTets; ++i)
+	{
+		std::vector<int> localIndices(4);
+		localIndices[0] = indices[i * 4 + 0];
+		localIndices[1] = indices[i * 4 + 1];
+		localIndices[2] = indices[i * 4 + 2];
+		localIndices[3] = indices[i * 4 + 3];
+
+		tets.push_back(PBDTetrahedra3d(localIndices, particles, i));
+	}
+
+	particles->initialiseTetAdjacency(tets);
 }
 
 void
-MeshCreator::generateTetBarToFit(std::shared_ptr<std::vector<PBDParticle>>& particles, std::vector<PBDTetrahedra3d>& tets,
+MeshCreator::generateTetBarToFit(std::shared_ptr<PBDParticleStore>& particles, std::vector<PBDTetrahedra3d>& tets,
 	int numDivsWidth, int numDivsHeight, int numDivsDepth,
 	Eigen::Vector2f bottomLeft_above, Eigen::Vector2f topLeft_above, Eigen::Vector2f topRight_above,
 	float thickness)
@@ -244,14 +329,16 @@ MeshCreator::generateTetBarToFit(std::shared_ptr<std::vector<PBDParticle>>& part
 	//Generate Instances
 
 	//Particles
-	particles = std::make_shared<std::vector<PBDParticle>>();
+	particles = std::make_shared<PBDParticleStore>();
+
+	particles->reserve(numVertices);
 
 	Eigen::Vector3f velocity;
 	velocity.setZero();
 
 	for (int i = 0; i < numVertices; ++i)
 	{
-		(*particles).push_back(PBDParticle(points[i], velocity, InverseMasses[i]));
+		particles->addParticle(points[i], velocity, InverseMasses[i]);
 	}
 
 	//Tets
@@ -266,11 +353,13 @@ MeshCreator::generateTetBarToFit(std::shared_ptr<std::vector<PBDParticle>>& part
 		tets.push_back(PBDTetrahedra3d(localIndices, particles, i));
 	}
 
+	particles->initialiseTetAdjacency(tets);
+
 
 }
 
 void
-MeshCreator::generateSingleTet(std::shared_ptr<std::vector<PBDParticle>>& particles, std::vector<PBDTetrahedra3d>& tets,
+MeshCreator::generateSingleTet(std::shared_ptr<PBDParticleStore>& particles, std::vector<PBDTetrahedra3d>& tets,
 	int width, int height, int depth)
 {
 	//1. Generate 4 Nodes
@@ -282,22 +371,22 @@ MeshCreator::generateSingleTet(std::shared_ptr<std::vector<PBDParticle>>& partic
 	position[0] = 1.0f;
 	position[1] = 0.0f;
 	position[2] = 0.0f;
-	(*particles).push_back(PBDParticle(position, velocity, invMass));
+	particles->addParticle(position, velocity, invMass);
 
 	position[0] = 0.0f;
 	position[1] = 1.0f;
 	position[2] = 0.0f;
-	(*particles).push_back(PBDParticle(position, velocity, invMass));
+	particles->addParticle(position, velocity, invMass);
 
 	position[0] = 0.0f;
 	position[1] = 0.0f;
 	position[2] = 1.0f;
-	(*particles).push_back(PBDParticle(position, velocity, invMass));
+	particles->addParticle(position, velocity, invMass);
 
 	position[0] = 0.0f;
 	position[1] = 0.0f;
 	position[2] = 0.0f;
-	(*particles).push_back(PBDParticle(position, velocity, invMass));
+	particles->addParticle(position, velocity, invMass);
 
 	//2. Constrain one face
 	(*particles)[0].inverseMass() = 0.0f;
@@ -308,4 +397,6 @@ MeshCreator::generateSingleTet(std::shared_ptr<std::vector<PBDParticle>>& partic
 	//3. Generate 1 Tet Element
 	std::vector<int> indices = { 0, 1, 2, 3 };
 	tets.push_back(PBDTetrahedra3d(std::move(indices), particles, 0));
+
+	particles->initialiseTetAdjacency(tets);
 }
\ No newline at end of file
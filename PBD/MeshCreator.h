@@ -13,18 +13,28 @@ class MeshCreator
 {
 public:
 
-	static void generateTetBar(std::shared_ptr<std::vector<PBDParticle>>& particles, std::vector<PBDTetrahedra3d>& tets,
+	static void generateTetBar(std::shared_ptr<PBDParticleStore>& particles, std::vector<PBDTetrahedra3d>& tets,
 		int width, int height, int depth);
 
-	static void generateTetBarToFit(std::shared_ptr<std::vector<PBDParticle>>& particles, std::vector<PBDTetrahedra3d>& tets,
+	static void generateTetBarToFit(std::shared_ptr<PBDParticleStore>& particles, std::vector<PBDTetrahedra3d>& tets,
 		int numDivsWidth, int numDivsHeight, int numDivsDepth,
 		Eigen::Vector2f bottomLeft_above, Eigen::Vector2f topLeft_above, Eigen::Vector2f topRight_above,
 		float thickness);
 
-	static void generateSingleTet(std::shared_ptr<std::vector<PBDParticle>>& particles, std::vector<PBDTetrahedra3d>& tets,
+	static void generateSingleTet(std::shared_ptr<PBDParticleStore>& particles, std::vector<PBDTetrahedra3d>& tets,
 		int width, int height, int depth);
 
+	//Tetrahedralises the given cells of a regular grid (cell (i, j, k) spans origin + cellSize * [i, i + 1] x ...)
+	//with the same 5-tet split as generateTetBar; corners shared by several cells become one particle. The cells'
+	//tets are added in cell order, 5 per cell. All particles get an inverse mass of 1.
+	static void generateTetGridFromCells(std::shared_ptr<PBDParticleStore>& particles, std::vector<PBDTetrahedra3d>& tets,
+		const Eigen::Vector3f& origin, float cellSize, const std::vector<Eigen::Vector3i>& cells);
+
 private:
+	//Splits the cube with the given corners (numbered as in generateTetBar) into 5 tets; the split alternates with the
+	//cell parity so that neighbouring cells share faces
+	static void addCubeTetrahedra(const unsigned int corners[8], bool oddCell, std::vector<int>& indices);
+
 	MeshCreator();
 	~MeshCreator();
 };
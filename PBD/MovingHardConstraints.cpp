@@ -36,19 +36,19 @@ MovingHardConstraints::readFromAbc(const std::string& fileName, const std::vecto
 }
 
 void
-MovingHardConstraints::initialisePositionMasses(std::vector<PBDParticle>& positions)
+MovingHardConstraints::initialisePositionMasses(PBDParticleStore& positions)
 {
 	for (int i = 0; i < m_constraintIndices.size(); ++i)
 	{
 		for (int c = 0; c < m_constraintIndices[i].size(); ++c)
 		{
-			positions[m_constraintIndices[i][c]].inverseMass() = 0.0f;
+			positions.inverseMass(m_constraintIndices[i][c]) = 0.0f;
 		}
 	}
 }
 
 void
-MovingHardConstraints::updatePositions(std::vector<PBDParticle>& positions, int systemFrame, float timeStep, int locatorIdx)
+MovingHardConstraints::updatePositions(PBDParticleStore& positions, float systemFrame, float timeStep, int locatorIdx)
 {
 	timeStep *= m_speed;
 
@@ -79,8 +79,9 @@ MovingHardConstraints::updatePositions(std::vector<PBDParticle>& positions, int
 
 		for (int c = 0; c < m_constraintIndices[locatorIdx].size(); ++c)
 		{
-			positions[m_constraintIndices[locatorIdx][c]].position() += position - m_previousPosition[locatorIdx];
-			positions[m_constraintIndices[locatorIdx][c]].previousPosition() = positions[m_constraintIndices[locatorIdx][c]].position();
+			//the previous positions hold the committed state, the current ones are stale between steps
+			positions.previousPosition(m_constraintIndices[locatorIdx][c]) += position - m_previousPosition[locatorIdx];
+			positions.position(m_constraintIndices[locatorIdx][c]) = positions.previousPosition(m_constraintIndices[locatorIdx][c]);
 		}
 	//}
 
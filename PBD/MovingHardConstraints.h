@@ -18,9 +18,10 @@ public:
 
 	void readFromAbc(const std::string& fileName, const std::vector<std::string>& topBottomTransformNames);
 
-	void initialisePositionMasses(std::vector<PBDParticle>& positions);
+	void initialisePositionMasses(PBDParticleStore& positions);
 
-	void updatePositions(std::vector<PBDParticle>& positions, int currentFrame, float timeStep, int locatorIdx);
+	//Fractional frames (substeps) interpolate between the two neighbouring samples
+	void updatePositions(PBDParticleStore& positions, float currentFrame, float timeStep, int locatorIdx);
 
 	float& getSpeed() { return m_speed; }
 private:
@@ -0,0 +1,245 @@
+#include "PBDActivityTracker.h"
+
+#include <algorithm>
+
+#include <tbb\parallel_for.h>
+#include <tbb\blocked_range.h>
+
+PBDActivityTracker::PBDActivityTracker()
+{
+}
+
+
+PBDActivityTracker::~PBDActivityTracker()
+{
+}
+
+void
+PBDActivityTracker::initialise(int numParticles, int numTetrahedra)
+{
+	m_numQuietSteps.assign(numParticles, 0);
+	m_isParticleSimulated.assign(numParticles, 1);
+	m_isTetActive.assign(numTetrahedra, 1);
+	m_simulatedParticles.clear();
+	m_boundaryParticles.clear();
+	m_activeColors.clear();
+	m_lastPositions.clear();
+}
+
+void
+PBDActivityTracker::beginStep(PBDParticleStore& particles, const std::vector<PBDTetrahedra3d>& tetrahedra,
+	const std::vector<CollisionSphere>& collisionGeometry3, const PBDSolverSettings& settings)
+{
+	if (!isInitialised(particles.size(), tetrahedra.size()))
+	{
+		initialise(particles.size(), tetrahedra.size());
+	}
+
+	std::vector<Eigen::Vector3f>& previousPositions = particles.getPreviousPositions();
+	std::vector<Eigen::Vector3f>& velocities = particles.getVelocities();
+	std::vector<Eigen::Vector3f>& previousVelocities = particles.getPreviousVelocities();
+
+	const float squaredVelocityThreshold = settings.sleepVelocityThreshold * settings.sleepVelocityThreshold;
+	const float squaredMoveThreshold = squaredVelocityThreshold * settings.deltaT * settings.deltaT;
+	const bool hasLastPositions = m_lastPositions.size() == particles.size();
+
+	//1. wake particles disturbed from outside (drivers, user interaction) or within reach of a collision sphere
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, particles.size()), [&](const tbb::blocked_range<size_t>& r)
+	{
+		for (size_t p = r.begin(); p != r.end(); ++p)
+		{
+			bool isDisturbed = previousVelocities[p].squaredNorm() >= squaredVelocityThreshold
+				|| (hasLastPositions && (previousPositions[p] - m_lastPositions[p]).squaredNorm() > squaredMoveThreshold);
+
+			for (int c = 0; c < collisionGeometry3.size() && !isDisturbed; ++c)
+			{
+				const float wakeRadius = settings.collisionSpheresRadius[c]
+					+ 2.0f * (collisionGeometry3[c].getCollisionSphereCentre() - collisionGeometry3[c].getPreviousCollisionSphereCentre()).norm();
+
+				isDisturbed = (previousPositions[p] - collisionGeometry3[c].getCollisionSphereCentre()).squaredNorm() < wakeRadius * wakeRadius;
+			}
+
+			if (isDisturbed)
+			{
+				m_numQuietSteps[p] = 0;
+			}
+		}
+	});
+
+	//2. spread one ring: tets with a disturbed or fast particle (no quiet step yet) wake all of their particles
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, tetrahedra.size()), [&](const tbb::blocked_range<size_t>& r)
+	{
+		for (size_t t = r.begin(); t != r.end(); ++t)
+		{
+			const std::vector<int>& vertexIndices = tetrahedra[t].getVertexIndices();
+
+			bool isDisturbed = false;
+			for (int v = 0; v < 4; ++v)
+			{
+				isDisturbed = isDisturbed || m_numQuietSteps[vertexIndices[v]] == 0;
+			}
+			m_isTetActive[t] = isDisturbed;
+		}
+	});
+
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, particles.size()), [&](const tbb::blocked_range<size_t>& r)
+	{
+		for (size_t p = r.begin(); p != r.end(); ++p)
+		{
+			const int* tetIdxs = particles.getContainingTetIdxs(p);
+			for (int i = 0; i < particles.getNumContainingTetrahedra(p); ++i)
+			{
+				if (m_isTetActive[tetIdxs[i]])
+				{
+					m_numQuietSteps[p] = 0;
+					break;
+				}
+			}
+		}
+	});
+
+	//3. a particle sleeps only once all particles of its tets have been quiet for numStepsToSleep steps; the ones
+	//falling asleep are stopped
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, tetrahedra.size()), [&](const tbb::blocked_range<size_t>& r)
+	{
+		for (size_t t = r.begin(); t != r.end(); ++t)
+		{
+			const std::vector<int>& vertexIndices = tetrahedra[t].getVertexIndices();
+
+			bool isAwake = false;
+			for (int v = 0; v < 4; ++v)
+			{
+				isAwake = isAwake || m_numQuietSteps[vertexIndices[v]] < settings.numStepsToSleep;
+			}
+			m_isTetActive[t] = isAwake;
+		}
+	});
+
+	m_simulatedParticles.clear();
+	for (int p = 0; p < particles.size(); ++p)
+	{
+		bool isSimulated = m_numQuietSteps[p] < settings.numStepsToSleep;
+
+		const int* tetIdxs = particles.getContainingTetIdxs(p);
+		for (int i = 0; i < particles.getNumContainingTetrahedra(p) && !isSimulated; ++i)
+		{
+			isSimulated = m_isTetActive[tetIdxs[i]] != 0;
+		}
+
+		if (!isSimulated && m_isParticleSimulated[p])
+		{
+			velocities[p].setZero();
+			previousVelocities[p].setZero();
+		}
+		m_isParticleSimulated[p] = isSimulated;
+
+		if (isSimulated)
+		{
+			m_simulatedParticles.push_back(p);
+		}
+	}
+
+	//4. active tets: any particle simulated. Their sleeping particles form the boundary, which is held in place during
+	//the projection, so every tet that contains a moving particle is projected and the sleeping region stays at rest.
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, tetrahedra.size()), [&](const tbb::blocked_range<size_t>& r)
+	{
+		for (size_t t = r.begin(); t != r.end(); ++t)
+		{
+			const std::vector<int>& vertexIndices = tetrahedra[t].getVertexIndices();
+
+			bool isActive = false;
+			for (int v = 0; v < 4; ++v)
+			{
+				isActive = isActive || m_isParticleSimulated[vertexIndices[v]] != 0;
+			}
+			m_isTetActive[t] = isActive;
+		}
+	});
+
+	m_boundaryParticles.clear();
+	for (int p = 0; p < particles.size(); ++p)
+	{
+		if (m_isParticleSimulated[p])
+		{
+			continue;
+		}
+
+		const int* tetIdxs = particles.getContainingTetIdxs(p);
+		for (int i = 0; i < particles.getNumContainingTetrahedra(p); ++i)
+		{
+			if (m_isTetActive[tetIdxs[i]])
+			{
+				m_boundaryParticles.push_back(p);
+				break;
+			}
+		}
+	}
+
+	m_counts.numParticles += particles.size();
+	m_counts.numSimulatedParticles += m_simulatedParticles.size();
+	m_counts.numTetrahedra += tetrahedra.size();
+	for (int t = 0; t < tetrahedra.size(); ++t)
+	{
+		m_counts.numActiveTetrahedra += m_isTetActive[t];
+	}
+}
+
+void
+PBDActivityTracker::endStep(PBDParticleStore& particles, const PBDSolverSettings& settings)
+{
+	//after the state swap, the committed velocities and positions are the previous ones
+	std::vector<Eigen::Vector3f>& velocities = particles.getPreviousVelocities();
+
+	const float squaredVelocityThreshold = settings.sleepVelocityThreshold * settings.sleepVelocityThreshold;
+
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, m_simulatedParticles.size()), [&](const tbb::blocked_range<size_t>& r)
+	{
+		for (size_t i = r.begin(); i != r.end(); ++i)
+		{
+			const int p = m_simulatedParticles[i];
+
+			if (velocities[p].squaredNorm() < squaredVelocityThreshold)
+			{
+				m_numQuietSteps[p] = std::min(m_numQuietSteps[p] + 1, settings.numStepsToSleep);
+			}
+			else
+			{
+				m_numQuietSteps[p] = 0;
+			}
+		}
+	});
+
+	m_lastPositions = particles.getPreviousPositions();
+}
+
+void
+PBDActivityTracker::holdBoundaryParticles(PBDParticleStore& particles) const
+{
+	std::vector<Eigen::Vector3f>& positions = particles.getPositions();
+	const std::vector<Eigen::Vector3f>& previousPositions = particles.getPreviousPositions();
+
+	for (int i = 0; i < m_boundaryParticles.size(); ++i)
+	{
+		positions[m_boundaryParticles[i]] = previousPositions[m_boundaryParticles[i]];
+	}
+}
+
+void
+PBDActivityTracker::filterColoring(const PBDConstraintColoring& coloring)
+{
+	m_activeColors.resize(coloring.getNumColors());
+
+	for (int c = 0; c < coloring.getNumColors(); ++c)
+	{
+		const std::vector<int>& color = coloring.getColor(c);
+
+		m_activeColors[c].clear();
+		for (int i = 0; i < color.size(); ++i)
+		{
+			if (m_isTetActive[color[i]])
+			{
+				m_activeColors[c].push_back(color[i]);
+			}
+		}
+	}
+}
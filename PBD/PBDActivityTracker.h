@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vector>
+#include <iostream>
+
+#include <Eigen\Dense>
+
+#include "PBDParticleStore.h"
+#include "PBDTetrahedra3d.h"
+#include "PBDSolverSettings.h"
+#include "PBDConstraintColoring.h"
+#include "CollisionSphere.h"
+
+//Simulated / total particles and active / total tetrahedra, summed over the steps since the last reset.
+struct PBDActivityCounts
+{
+	PBDActivityCounts() : numParticles(0), numSimulatedParticles(0), numTetrahedra(0), numActiveTetrahedra(0)
+	{
+	}
+
+	float getSimulatedParticleFraction() const
+	{
+		return numParticles > 0 ? (float)numSimulatedParticles / (float)numParticles : 0.0f;
+	}
+
+	float getActiveTetrahedraFraction() const
+	{
+		return numTetrahedra > 0 ? (float)numActiveTetrahedra / (float)numTetrahedra : 0.0f;
+	}
+
+	void print() const
+	{
+		std::cout << "Sleeping: " << 100.0f * getSimulatedParticleFraction() << "% of the particles and "
+			<< 100.0f * getActiveTetrahedraFraction() << "% of the tetrahedra simulated" << std::endl;
+	}
+
+	long long numParticles;
+	long long numSimulatedParticles;
+	long long numTetrahedra;
+	long long numActiveTetrahedra;
+};
+
+//Sleeping of quiescent regions (see PBDSolverSettings::useSleeping). A particle falls asleep once its velocity and
+//the velocities of all particles sharing a tet with it stayed below sleepVelocityThreshold for numStepsToSleep
+//steps; sleeping particles are neither integrated nor collided. Tets with at least one awake particle are projected.
+//Their sleeping particles keep their mass in the multipliers but are moved back after every projection pass
+//(holdBoundaryParticles), so a sleeping region stays exactly at rest; zeroing their inverse masses instead makes the
+//PBD energy projection overshoot on the remaining vertices. Wake-up spreads through the particle -> tet adjacency:
+//every particle sharing a tet with a fast particle wakes, as do particles moved or accelerated from outside the
+//solver (drivers, user interaction) and particles within reach of a collision sphere.
+class PBDActivityTracker
+{
+public:
+	PBDActivityTracker();
+	~PBDActivityTracker();
+
+	//Everything awake
+	void initialise(int numParticles, int numTetrahedra);
+
+	bool isInitialised(int numParticles, int numTetrahedra) const
+	{
+		return m_numQuietSteps.size() == numParticles && m_isTetActive.size() == numTetrahedra;
+	}
+
+	//Wakes the disturbed particles, then determines the active tets and simulated particles of the step
+	void beginStep(PBDParticleStore& particles, const std::vector<PBDTetrahedra3d>& tetrahedra,
+		const std::vector<CollisionSphere>& collisionGeometry3, const PBDSolverSettings& settings);
+
+	//Counts the quiet steps of the simulated particles; call after the velocity update
+	void endStep(PBDParticleStore& particles, const PBDSolverSettings& settings);
+
+	//Moves the sleeping particles of active tets back to their positions at the start of the step
+	void holdBoundaryParticles(PBDParticleStore& particles) const;
+
+	//Rebuilds the active tets per colour
+	void filterColoring(const PBDConstraintColoring& coloring);
+
+	const std::vector<int>& getActiveColor(int c) const { return m_activeColors[c]; }
+
+	const std::vector<char>& getSimulatedParticleFlags() const { return m_isParticleSimulated; }
+
+	const std::vector<char>& getActiveTetFlags() const { return m_isTetActive; }
+
+	const std::vector<int>& getSimulatedParticles() const { return m_simulatedParticles; }
+
+	const PBDActivityCounts& getCounts() const { return m_counts; }
+
+	void resetCounts() { m_counts = PBDActivityCounts(); }
+
+private:
+	std::vector<int> m_numQuietSteps;
+	std::vector<char> m_isParticleSimulated;
+	std::vector<char> m_isTetActive;
+	std::vector<int> m_simulatedParticles;
+
+	//sleeping particles of active tets
+	std::vector<int> m_boundaryParticles;
+
+	std::vector<std::vector<int> > m_activeColors;
+
+	//particle positions at the end of the last step
+	std::vector<Eigen::Vector3f> m_lastPositions;
+
+	PBDActivityCounts m_counts;
+};
@@ -0,0 +1,144 @@
+#include "PBDChebyshevAcceleration.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <tbb\parallel_for.h>
+#include <tbb\parallel_reduce.h>
+#include <tbb\blocked_range.h>
+
+PBDChebyshevAcceleration::PBDChebyshevAcceleration()
+{
+	m_numSweeps = 0;
+	m_numAcceleratedSweeps = 0;
+	m_omega = 1.0f;
+	m_spectralRadius = 0.0f;
+	m_lastSquaredChange = 0.0;
+	m_firstSquaredChange = 0.0;
+	m_numRestarts = 0;
+}
+
+
+PBDChebyshevAcceleration::~PBDChebyshevAcceleration()
+{
+}
+
+void
+PBDChebyshevAcceleration::begin(PBDParticleStore& particles, const PBDSolverSettings& settings)
+{
+	m_current = particles.getPositions();
+	m_previous = m_current;
+
+	m_numSweeps = 0;
+	m_numAcceleratedSweeps = 0;
+	m_omega = 1.0f;
+	m_lastSquaredChange = 0.0;
+	m_firstSquaredChange = 0.0;
+
+	m_spectralRadius = settings.chebyshevSpectralRadius;
+}
+
+double
+PBDChebyshevAcceleration::computeSquaredChange(PBDParticleStore& particles, const PBDSolverSettings& settings) const
+{
+	const std::vector<Eigen::Vector3f>& positions = particles.getPositions();
+
+	if (settings.useDeterministicParallelism)
+	{
+		const size_t blockSize = std::max(1, settings.deterministicBlockSize);
+		std::vector<double> blockSums((positions.size() + blockSize - 1) / blockSize);
+
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, blockSums.size()), [&](const tbb::blocked_range<size_t>& r)
+		{
+			for (size_t b = r.begin(); b != r.end(); ++b)
+			{
+				double sum = 0.0;
+				for (size_t p = b * blockSize; p != std::min((b + 1) * blockSize, positions.size()); ++p)
+				{
+					sum += (positions[p] - m_current[p]).squaredNorm();
+				}
+				blockSums[b] = sum;
+			}
+		});
+
+		double squaredChange = 0.0;
+		for (size_t b = 0; b < blockSums.size(); ++b)
+		{
+			squaredChange += blockSums[b];
+		}
+		return squaredChange;
+	}
+
+	return tbb::parallel_reduce(tbb::blocked_range<size_t>(0, positions.size()), 0.0,
+		[&](const tbb::blocked_range<size_t>& r, double sum)
+	{
+		for (size_t p = r.begin(); p != r.end(); ++p)
+		{
+			sum += (positions[p] - m_current[p]).squaredNorm();
+		}
+		return sum;
+	},
+		[](double a, double b)
+	{
+		return a + b;
+	});
+}
+
+void
+PBDChebyshevAcceleration::apply(PBDParticleStore& particles, const PBDSolverSettings& settings)
+{
+	std::vector<Eigen::Vector3f>& positions = particles.getPositions();
+
+	const double squaredChange = computeSquaredChange(particles, settings);
+	++m_numSweeps;
+
+	if (m_numSweeps == 1)
+	{
+		m_firstSquaredChange = squaredChange;
+	}
+
+	if (m_numSweeps <= settings.chebyshevWarmUpIts)
+	{
+		//plain sweeps; rho is the average decay of the changes since the first one
+		if (settings.chebyshevSpectralRadius <= 0.0f && m_numSweeps > 1 && m_firstSquaredChange > 0.0)
+		{
+			const double decay = std::pow(squaredChange / m_firstSquaredChange, 0.5 / (double)(m_numSweeps - 1));
+			m_spectralRadius = (float)std::min(std::max(decay, 0.0), 0.999);
+		}
+	}
+	else if (squaredChange > m_lastSquaredChange)
+	{
+		//overshooting, start a new sequence from the sweep's result
+		m_omega = 1.0f;
+		m_numAcceleratedSweeps = 0;
+		++m_numRestarts;
+	}
+	else
+	{
+		const float rhoSquared = m_spectralRadius * m_spectralRadius;
+		if (m_numAcceleratedSweeps == 0)
+		{
+			m_omega = 2.0f / (2.0f - rhoSquared);
+		}
+		else
+		{
+			m_omega = 4.0f / (4.0f - rhoSquared * m_omega);
+		}
+		++m_numAcceleratedSweeps;
+
+		const float omega = m_omega;
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, positions.size()), [&](const tbb::blocked_range<size_t>& r)
+		{
+			for (size_t p = r.begin(); p != r.end(); ++p)
+			{
+				positions[p] = omega * (positions[p] - m_previous[p]) + m_previous[p];
+			}
+		});
+	}
+
+	m_lastSquaredChange = squaredChange;
+
+	//x^(k-1) <- x^k, x^k <- x^(k+1)
+	m_previous.swap(m_current);
+	m_current = positions;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include <Eigen\Dense>
+
+#include "PBDParticleStore.h"
+#include "PBDSolverSettings.h"
+
+//Chebyshev semi-iterative acceleration of the constraint sweeps (Wang 2015, "A Chebyshev Semi-Iterative Approach
+//for Accelerating Projective and Position-based Dynamics"). After the sweep producing x_hat^(k+1) the positions
+//are extrapolated to
+//
+//   x^(k+1) = omega_(k+1) * (x_hat^(k+1) - x^(k-1)) + x^(k-1)
+//
+//with omega = 1 for the warm-up sweeps, omega = 2 / (2 - rho^2) for the first accelerated one and
+//omega_(k+1) = 4 / (4 - rho^2 * omega_k) afterwards, rho being the spectral radius of the sweep. Unless it is
+//given in the settings, rho is estimated from how fast the position changes of the warm-up sweeps decay. If a sweep
+//moves the positions further than the one before, the sequence restarts at omega = 1.
+class PBDChebyshevAcceleration
+{
+public:
+	PBDChebyshevAcceleration();
+	~PBDChebyshevAcceleration();
+
+	//Call before the first sweep of every step
+	void begin(PBDParticleStore& particles, const PBDSolverSettings& settings);
+
+	//Call after every sweep
+	void apply(PBDParticleStore& particles, const PBDSolverSettings& settings);
+
+	//Spectral radius used by the last step
+	float getSpectralRadius() const { return m_spectralRadius; }
+
+	//Restarts (divergence) since construction
+	int getNumRestarts() const { return m_numRestarts; }
+
+private:
+	//|positions - m_current|^2, summed per block of settings.deterministicBlockSize particles in block order with
+	//useDeterministicParallelism
+	double computeSquaredChange(PBDParticleStore& particles, const PBDSolverSettings& settings) const;
+
+	std::vector<Eigen::Vector3f> m_previous;
+	std::vector<Eigen::Vector3f> m_current;
+
+	int m_numSweeps;
+	int m_numAcceleratedSweeps;
+	float m_omega;
+	float m_spectralRadius;
+	double m_lastSquaredChange;
+	double m_firstSquaredChange;
+	int m_numRestarts;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "LaneMath.h"
+
+//XPBD formulation of the strain energy constraint (PBDSolverSettings::useXPBD). The strain energy E of a tet with
+//Young's modulus k is written as E = C^2 / (2 alpha) with the compliance alpha = 1 / k, i.e. C = sqrt(2 E / k).
+//Every iteration updates the tet's accumulated Lagrange multiplier by
+//
+//   deltaLambda = (-C - alpha_tilde * lambda) / (sum_i w_i |grad_i C|^2 + alpha_tilde),  alpha_tilde = alpha / deltaT^2
+//
+//which converges to the same material response independently of the number of iterations. With the strain energy
+//gradient g_i (the 'gradient' of the kernels) grad_i C = g_i / (k C), so sum_i w_i |grad_i C|^2 = sum_i w_i |g_i|^2 / (2 k E).
+//
+//Returns the multiplier the kernels scale inverseMass_i * g_i by, i.e. deltaLambda / (k C); NaN/inf if E is not
+//positive. 'weightedSquaredGradientNorm' is sum_i w_i |g_i|^2.
+template<typename Real>
+LANE_INLINE Real laneComplianceMultiplier(const Real& strainEnergy, const Real& weightedSquaredGradientNorm,
+	const Real& youngsModulus, const Real& lagrangeMultiplier, float deltaT, Real& deltaLagrangeMultiplier)
+{
+	const Real C = lanesSqrt(Real(2.0f) * strainEnergy / youngsModulus);
+	const Real complianceTilde = Real(1.0f / (deltaT * deltaT)) / youngsModulus;
+
+	deltaLagrangeMultiplier = (-C - complianceTilde * lagrangeMultiplier)
+		/ (weightedSquaredGradientNorm / (Real(2.0f) * youngsModulus * strainEnergy) + complianceTilde);
+
+	return deltaLagrangeMultiplier / (youngsModulus * C);
+}
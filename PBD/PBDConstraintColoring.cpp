@@ -0,0 +1,121 @@
+#include "PBDConstraintColoring.h"
+
+#include <iostream>
+#include <algorithm>
+
+PBDConstraintColoring::PBDConstraintColoring()
+{
+	m_isInitialised = false;
+}
+
+
+PBDConstraintColoring::~PBDConstraintColoring()
+{
+}
+
+void
+PBDConstraintColoring::clear()
+{
+	m_colors.clear();
+	m_constraintColor.clear();
+	m_isInitialised = false;
+}
+
+void
+PBDConstraintColoring::colorTetrahedra(std::vector<PBDTetrahedra3d>& tetrahedra, int numParticles)
+{
+	std::vector<int> indices(tetrahedra.size() * 4);
+
+	for (int t = 0; t < tetrahedra.size(); ++t)
+	{
+		for (int v = 0; v < 4; ++v)
+		{
+			indices[t * 4 + v] = tetrahedra[t].getVertexIndices()[v];
+		}
+	}
+
+	colorConstraints(indices, 4, numParticles);
+}
+
+void
+PBDConstraintColoring::colorConstraints(const std::vector<int>& constraintParticleIndices, int particlesPerConstraint, int numParticles)
+{
+	clear();
+
+	int numConstraints = constraintParticleIndices.size() / particlesPerConstraint;
+
+	//1. Particle -> constraint adjacency (CSR)
+	std::vector<int> offsets(numParticles + 1, 0);
+	for (int i = 0; i < constraintParticleIndices.size(); ++i)
+	{
+		++offsets[constraintParticleIndices[i] + 1];
+	}
+	for (int p = 0; p < numParticles; ++p)
+	{
+		offsets[p + 1] += offsets[p];
+	}
+
+	std::vector<int> adjacency(constraintParticleIndices.size());
+	std::vector<int> fillPosition(offsets.begin(), offsets.end() - 1);
+	for (int c = 0; c < numConstraints; ++c)
+	{
+		for (int v = 0; v < particlesPerConstraint; ++v)
+		{
+			int p = constraintParticleIndices[c * particlesPerConstraint + v];
+			adjacency[fillPosition[p]++] = c;
+		}
+	}
+
+	//2. Greedy colouring; 'forbidden[color] == c' marks a colour already used by a neighbour of c
+	m_constraintColor.assign(numConstraints, -1);
+	std::vector<int> forbidden;
+
+	for (int c = 0; c < numConstraints; ++c)
+	{
+		for (int v = 0; v < particlesPerConstraint; ++v)
+		{
+			int p = constraintParticleIndices[c * particlesPerConstraint + v];
+			for (int a = offsets[p]; a < offsets[p + 1]; ++a)
+			{
+				int neighbourColor = m_constraintColor[adjacency[a]];
+				if (neighbourColor >= 0)
+				{
+					forbidden[neighbourColor] = c;
+				}
+			}
+		}
+
+		int color = 0;
+		while (color < forbidden.size() && forbidden[color] == c)
+		{
+			++color;
+		}
+
+		if (color == forbidden.size())
+		{
+			forbidden.push_back(-1);
+			m_colors.push_back(std::vector<int>());
+		}
+
+		m_constraintColor[c] = color;
+		m_colors[color].push_back(c);
+	}
+
+	m_isInitialised = true;
+}
+
+void
+PBDConstraintColoring::printStatistics() const
+{
+	int smallest = m_constraintColor.size();
+	int largest = 0;
+
+	for (int c = 0; c < m_colors.size(); ++c)
+	{
+		smallest = std::min(smallest, (int)m_colors[c].size());
+		largest = std::max(largest, (int)m_colors[c].size());
+	}
+
+	std::cout << "Constraint Colouring: " << m_constraintColor.size() << " constraints in " << m_colors.size()
+		<< " colours (smallest: " << smallest << "; largest: " << largest << ")" << std::endl;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+
+#include "PBDTetrahedra3d.h"
+
+//Greedy graph colouring of constraints: no two constraints within the same colour share a particle.
+//All constraints of one colour can therefore be projected in parallel without any locking.
+class PBDConstraintColoring
+{
+public:
+	PBDConstraintColoring();
+	~PBDConstraintColoring();
+
+	void colorTetrahedra(std::vector<PBDTetrahedra3d>& tetrahedra, int numParticles);
+
+	//constraintParticleIndices holds 'particlesPerConstraint' consecutive particle indices per constraint
+	void colorConstraints(const std::vector<int>& constraintParticleIndices, int particlesPerConstraint, int numParticles);
+
+	bool isInitialised() const { return m_isInitialised; }
+
+	int getNumColors() const { return m_colors.size(); }
+
+	int getNumConstraints() const { return m_constraintColor.size(); }
+
+	const std::vector<int>& getColor(int color) const { return m_colors[color]; }
+
+	int getConstraintColor(int constraint) const { return m_constraintColor[constraint]; }
+
+	void clear();
+
+	void printStatistics() const;
+
+private:
+	std::vector<std::vector<int>> m_colors;
+	std::vector<int> m_constraintColor;
+
+	bool m_isInitialised;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "PBDSolverSettings.h"
+
+//Solver features the constraint kernels are specialised for at compile time. Each combination is a
+//PBDKernelPolicy; the kernels test its members instead of the settings, so the per-tet loop of every
+//instantiation is free of feature branches. selectKernelPolicy maps the settings to the matching instantiation.
+
+enum PBD_INVERSION_HANDLING
+{
+	INVERSION_HANDLING_NONE,
+	//always diagonalise F
+	INVERSION_HANDLING_FULL,
+	//diagonalise only elements outside the clamping range (see PBDInversionHandling.h)
+	INVERSION_HANDLING_ADAPTIVE
+};
+
+enum PBD_VISCOELASTICITY
+{
+	VISCOELASTICITY_NONE,
+	VISCOELASTICITY_SINGLE_TERM,
+	VISCOELASTICITY_FULL_PRONY
+};
+
+template<PBDSolverSettings::CONSTITUTIVE_MODEL MaterialModel, PBD_INVERSION_HANDLING InversionHandling,
+	PBD_VISCOELASTICITY Viscoelasticity, bool PerTetMaterials, bool XPBD, bool Colliders>
+struct PBDKernelPolicy
+{
+	static const PBDSolverSettings::CONSTITUTIVE_MODEL materialModel = MaterialModel;
+	static const PBD_INVERSION_HANDLING inversionHandling = InversionHandling;
+	static const PBD_VISCOELASTICITY viscoelasticity = Viscoelasticity;
+
+	//use the per-tet Young's modulus and anisotropy instead of the global ones
+	static const bool perTetMaterials = PerTetMaterials;
+
+	//compliance formulation with per-tet Lagrange multipliers (see PBDCompliance.h)
+	static const bool xpbd = XPBD;
+
+	//resolve the position corrections against the collision spheres
+	static const bool colliders = Colliders;
+
+	//Kernels that do not touch the collision spheres use this, which halves their number of instantiations
+	typedef PBDKernelPolicy<MaterialModel, InversionHandling, Viscoelasticity, PerTetMaterials, XPBD, false> WithoutColliders;
+};
+
+namespace PBDKernelPolicySelection
+{
+	template<typename Family, PBDSolverSettings::CONSTITUTIVE_MODEL M, PBD_INVERSION_HANDLING I, PBD_VISCOELASTICITY V, bool P, bool X>
+	typename Family::Result selectColliders(bool hasColliders)
+	{
+		return hasColliders ? Family::template get<PBDKernelPolicy<M, I, V, P, X, true> >()
+			: Family::template get<PBDKernelPolicy<M, I, V, P, X, false> >();
+	}
+
+	template<typename Family, PBDSolverSettings::CONSTITUTIVE_MODEL M, PBD_INVERSION_HANDLING I, PBD_VISCOELASTICITY V, bool P>
+	typename Family::Result selectXPBD(const PBDSolverSettings& settings, bool hasColliders)
+	{
+		return settings.useXPBD ? selectColliders<Family, M, I, V, P, true>(hasColliders)
+			: selectColliders<Family, M, I, V, P, false>(hasColliders);
+	}
+
+	template<typename Family, PBDSolverSettings::CONSTITUTIVE_MODEL M, PBD_INVERSION_HANDLING I, PBD_VISCOELASTICITY V>
+	typename Family::Result selectPerTetMaterials(const PBDSolverSettings& settings, bool hasColliders)
+	{
+		return settings.usePerTetMaterialAttributes ? selectXPBD<Family, M, I, V, true>(settings, hasColliders)
+			: selectXPBD<Family, M, I, V, false>(settings, hasColliders);
+	}
+
+	template<typename Family, PBDSolverSettings::CONSTITUTIVE_MODEL M, PBD_INVERSION_HANDLING I>
+	typename Family::Result selectViscoelasticity(const PBDSolverSettings& settings, bool hasColliders)
+	{
+		if (settings.alpha == 0.0f || settings.rho == 0.0f)
+		{
+			return selectPerTetMaterials<Family, M, I, VISCOELASTICITY_NONE>(settings, hasColliders);
+		}
+
+		return settings.useFullPronySeries ? selectPerTetMaterials<Family, M, I, VISCOELASTICITY_FULL_PRONY>(settings, hasColliders)
+			: selectPerTetMaterials<Family, M, I, VISCOELASTICITY_SINGLE_TERM>(settings, hasColliders);
+	}
+
+	template<typename Family, PBDSolverSettings::CONSTITUTIVE_MODEL M>
+	typename Family::Result selectInversionHandling(const PBDSolverSettings& settings, bool hasColliders)
+	{
+		if (settings.disableInversionHandling)
+		{
+			return selectViscoelasticity<Family, M, INVERSION_HANDLING_NONE>(settings, hasColliders);
+		}
+
+		//the fast path only exists for the isotropic model, which keeps the fibre model at two variants
+		const PBD_INVERSION_HANDLING adaptive = (M == PBDSolverSettings::NEO_HOOKEAN) ? INVERSION_HANDLING_ADAPTIVE : INVERSION_HANDLING_FULL;
+
+		return settings.isInversionFastPathApplicable() ? selectViscoelasticity<Family, M, adaptive>(settings, hasColliders)
+			: selectViscoelasticity<Family, M, INVERSION_HANDLING_FULL>(settings, hasColliders);
+	}
+}
+
+//Returns Family::get<Policy>() for the policy matching 'settings'. Family provides a 'Result' type (typically a
+//function pointer) and a static 'template<typename Policy> Result get()'. Returns Result() for material models
+//without a kernel (Rubin-Bodner).
+template<typename Family>
+typename Family::Result selectKernelPolicy(const PBDSolverSettings& settings, bool hasColliders)
+{
+	switch (settings.materialModel)
+	{
+	case PBDSolverSettings::NEO_HOOKEAN:
+		return PBDKernelPolicySelection::selectInversionHandling<Family, PBDSolverSettings::NEO_HOOKEAN>(settings, hasColliders);
+	case PBDSolverSettings::NEO_HOOKEAN_FIBER:
+		return PBDKernelPolicySelection::selectInversionHandling<Family, PBDSolverSettings::NEO_HOOKEAN_FIBER>(settings, hasColliders);
+	default:
+		return typename Family::Result();
+	}
+}
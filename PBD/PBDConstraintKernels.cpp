@@ -0,0 +1,50 @@
+#include "PBDConstraintKernels.h"
+
+#include "PBDSolverProcessingFunctionsTBB.h"
+#include "PBDSolverBatchKernel.h"
+
+struct ProjectTetrahedraFamily
+{
+	typedef PBDConstraintKernels::ProjectTetrahedraFunction Result;
+
+	template<typename Policy>
+	static Result get() { return &projectTetrahedraVISCOELASTIC<Policy>; }
+};
+
+struct ComputeJacobiCorrectionsFamily
+{
+	typedef PBDConstraintKernels::ComputeJacobiCorrectionsFunction Result;
+
+	//the collision spheres are resolved in the Jacobi gather step, not in the kernel
+	template<typename Policy>
+	static Result get() { return &computeJacobiCorrectionsVISCOELASTIC<typename Policy::WithoutColliders>; }
+};
+
+PBDConstraintKernels
+PBDConstraintKernels::select(const PBDSolverSettings& settings, bool hasColliders)
+{
+	PBDConstraintKernels kernels;
+
+	kernels.computeJacobiCorrections = selectKernelPolicy<ComputeJacobiCorrectionsFamily>(settings, hasColliders);
+
+	if (settings.useSIMDKernel)
+	{
+		kernels.projectTetrahedra = PBDSolverBatchKernel::selectProjectTetrahedra(settings, hasColliders);
+		if (kernels.projectTetrahedra != NULL)
+		{
+			kernels.numLanes = PBDSolverBatchKernel::getNumLanes();
+			return kernels;
+		}
+	}
+
+	kernels.projectTetrahedra = selectScalarProjection(settings, hasColliders);
+	kernels.numLanes = 1;
+
+	return kernels;
+}
+
+PBDConstraintKernels::ProjectTetrahedraFunction
+PBDConstraintKernels::selectScalarProjection(const PBDSolverSettings& settings, bool hasColliders)
+{
+	return selectKernelPolicy<ProjectTetrahedraFamily>(settings, hasColliders);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+
+#include <Eigen\Dense>
+
+#include "PBDParticleStore.h"
+#include "PBDTetRestStateTable.h"
+#include "PBDSolverSettings.h"
+#include "CollisionSphere.h"
+#include "PBDInversionHandling.h"
+#include "PBDProjectionResidual.h"
+#include "PBDConstraintKernelPolicy.h"
+
+//The viscoelastic constraint kernels instantiated for the PBDKernelPolicy matching a set of solver settings. The
+//solver selects them once per advanceSystem call; the settings the policy covers must not change in between.
+struct PBDConstraintKernels
+{
+	//Projects the tetrahedra tetIdxs[0 .. numTets - 1], which must not share particles (i.e. one colour). The applied
+	//corrections are tracked in 'residual'.
+	typedef void (*ProjectTetrahedraFunction)(PBDTetRestStateTable& tetRestStates, PBDParticleStore& particles,
+		PBDSolverSettings& settings, std::vector<CollisionSphere>& collisionGeometry3,
+		const int* tetIdxs, int numTets, PBDInversionHandlingCounts& inversionCounts, PBDProjectionResidual& residual);
+
+	//Jacobi: computes the corrections of the tetrahedra [begin, end) into 'deltas' (4 per tet), see PBDSolverJacobiTBB
+	typedef void (*ComputeJacobiCorrectionsFunction)(PBDTetRestStateTable& tetRestStates, PBDParticleStore& particles,
+		PBDSolverSettings& settings, std::vector<Eigen::Vector3f>& deltas, std::vector<char>& isCorrected,
+		int begin, int end, PBDInversionHandlingCounts& inversionCounts);
+
+	PBDConstraintKernels() : projectTetrahedra(NULL), computeJacobiCorrections(NULL), numLanes(1)
+	{
+	}
+
+	ProjectTetrahedraFunction projectTetrahedra;
+	ComputeJacobiCorrectionsFunction computeJacobiCorrections;
+
+	//Tetrahedra per batch of projectTetrahedra (1 unless it is the SIMD batch kernel)
+	int numLanes;
+
+	//false if there is no kernel for the settings' material model
+	bool isValid() const { return projectTetrahedra != NULL && computeJacobiCorrections != NULL; }
+
+	//Uses the SIMD batch kernel for projectTetrahedra if settings.useSIMDKernel is set and it supports the settings.
+	static PBDConstraintKernels select(const PBDSolverSettings& settings, bool hasColliders);
+
+	//Scalar projectTetrahedra only
+	static ProjectTetrahedraFunction selectScalarProjection(const PBDSolverSettings& settings, bool hasColliders);
+};
@@ -0,0 +1,211 @@
+#include "PBDGeometricConstraints.h"
+
+#include <map>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <tbb\parallel_for.h>
+#include <tbb\blocked_range.h>
+
+PBDGeometricConstraints::PBDGeometricConstraints()
+{
+	m_numParticles = 0;
+}
+
+
+PBDGeometricConstraints::~PBDGeometricConstraints()
+{
+}
+
+void
+PBDGeometricConstraints::clear()
+{
+	m_edgeIndices.clear();
+	m_edgeRestLengths.clear();
+	m_edgeColoring.clear();
+
+	m_volumeIndices.clear();
+	m_volumeRestVolumes.clear();
+	m_volumeColoring.clear();
+
+	m_numParticles = 0;
+}
+
+void
+PBDGeometricConstraints::initialise(std::vector<PBDTetrahedra3d>& tetrahedra, int numParticles)
+{
+	clear();
+
+	//vertex pairs of the tets' undeformed side lengths (see PBDTetrahedra3d::calculateUndeformedSideLengths)
+	const int sideVertices[6][2] = { { 0, 2 }, { 0, 3 }, { 0, 1 }, { 2, 3 }, { 2, 1 }, { 3, 1 } };
+
+	std::map<std::pair<int, int>, int> edgeIdxs;
+
+	for (int t = 0; t < tetrahedra.size(); ++t)
+	{
+		const std::vector<int>& vertexIndices = tetrahedra[t].getVertexIndices();
+
+		for (int s = 0; s < 6; ++s)
+		{
+			const int a = vertexIndices[sideVertices[s][0]];
+			const int b = vertexIndices[sideVertices[s][1]];
+			const std::pair<int, int> key(std::min(a, b), std::max(a, b));
+
+			if (edgeIdxs.find(key) == edgeIdxs.end())
+			{
+				edgeIdxs[key] = m_edgeRestLengths.size();
+				m_edgeIndices.push_back(a);
+				m_edgeIndices.push_back(b);
+				//the tets store squared lengths
+				m_edgeRestLengths.push_back(std::sqrt(tetrahedra[t].getUndeformedSideLength(s)));
+			}
+		}
+
+		for (int v = 0; v < 4; ++v)
+		{
+			m_volumeIndices.push_back(vertexIndices[v]);
+		}
+		m_volumeRestVolumes.push_back(tetrahedra[t].getUndeformedVolumeAlternative());
+	}
+
+	m_edgeColoring.colorConstraints(m_edgeIndices, 2, numParticles);
+	m_volumeColoring.colorConstraints(m_volumeIndices, 4, numParticles);
+
+	m_numParticles = numParticles;
+}
+
+void
+PBDGeometricConstraints::printStatistics() const
+{
+	std::cout << "Geometric constraints: " << m_edgeRestLengths.size() << " edges in " << m_edgeColoring.getNumColors()
+		<< " colours, " << m_volumeRestVolumes.size() << " volumes in " << m_volumeColoring.getNumColors() << " colours" << std::endl;
+}
+
+float
+PBDGeometricConstraints::getStiffnessMultiplier(float k, int numIterations)
+{
+	if (k >= 1.0f)
+	{
+		return 1.0f;
+	}
+
+	return 1.0f - std::pow((1.0f - k), 1.0f / (float)numIterations);
+}
+
+void
+PBDGeometricConstraints::projectDistanceConstraints(PBDParticleStore& particles, float stiffnessMultiplier,
+	const std::vector<char>* isParticleSimulated, PBDProjectionResidualReduction& residualReduction) const
+{
+	std::vector<Eigen::Vector3f>& positions = particles.getPositions();
+	const std::vector<float>& inverseMasses = particles.getInverseMasses();
+
+	for (int c = 0; c < m_edgeColoring.getNumColors(); ++c)
+	{
+		const std::vector<int>& color = m_edgeColoring.getColor(c);
+
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, color.size()), [&](const tbb::blocked_range<size_t>& r)
+		{
+			PBDProjectionResidual residual;
+
+			for (size_t i = r.begin(); i != r.end(); ++i)
+			{
+				const int e = color[i];
+				const int p1 = m_edgeIndices[2 * e];
+				const int p2 = m_edgeIndices[2 * e + 1];
+
+				if (isParticleSimulated != NULL && !(*isParticleSimulated)[p1] && !(*isParticleSimulated)[p2])
+				{
+					continue;
+				}
+
+				const float w1 = inverseMasses[p1];
+				const float w2 = inverseMasses[p2];
+
+				const Eigen::Vector3f difference = positions[p1] - positions[p2];
+				const float length = difference.norm();
+
+				if (w1 + w2 == 0.0f || length == 0.0f)
+				{
+					continue;
+				}
+
+				const Eigen::Vector3f deltaX = (stiffnessMultiplier * (length - m_edgeRestLengths[e]) / ((w1 + w2) * length)) * difference;
+
+				positions[p1] -= w1 * deltaX;
+				positions[p2] += w2 * deltaX;
+
+				residual.add(w1 * deltaX);
+				residual.add(w2 * deltaX);
+			}
+
+			residualReduction.add(residual);
+		});
+	}
+}
+
+void
+PBDGeometricConstraints::projectVolumeConstraints(PBDParticleStore& particles, float stiffnessMultiplier,
+	const std::vector<char>* isParticleSimulated, PBDProjectionResidualReduction& residualReduction) const
+{
+	std::vector<Eigen::Vector3f>& positions = particles.getPositions();
+	const std::vector<float>& inverseMasses = particles.getInverseMasses();
+
+	for (int c = 0; c < m_volumeColoring.getNumColors(); ++c)
+	{
+		const std::vector<int>& color = m_volumeColoring.getColor(c);
+
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, color.size()), [&](const tbb::blocked_range<size_t>& r)
+		{
+			PBDProjectionResidual residual;
+
+			for (size_t i = r.begin(); i != r.end(); ++i)
+			{
+				const int t = color[i];
+				const int* idxs = &m_volumeIndices[4 * t];
+
+				if (isParticleSimulated != NULL && !(*isParticleSimulated)[idxs[0]] && !(*isParticleSimulated)[idxs[1]]
+					&& !(*isParticleSimulated)[idxs[2]] && !(*isParticleSimulated)[idxs[3]])
+				{
+					continue;
+				}
+
+				const Eigen::Vector3f& p0 = positions[idxs[0]];
+				const Eigen::Vector3f& p1 = positions[idxs[1]];
+				const Eigen::Vector3f& p2 = positions[idxs[2]];
+				const Eigen::Vector3f& p3 = positions[idxs[3]];
+
+				const float volume = 1.0f / 6.0f * (p1 - p0).cross(p2 - p0).dot(p3 - p0);
+
+				Eigen::Vector3f gradients[4];
+				gradients[0] = (p1 - p2).cross(p3 - p2);
+				gradients[1] = (p2 - p0).cross(p3 - p0);
+				gradients[2] = (p0 - p1).cross(p3 - p1);
+				gradients[3] = (p1 - p0).cross(p2 - p0);
+
+				float denominator = 0.0f;
+				for (int v = 0; v < 4; ++v)
+				{
+					denominator += inverseMasses[idxs[v]] * gradients[v].squaredNorm();
+				}
+
+				if (std::fabs(denominator) < 1.0e-9f)
+				{
+					continue;
+				}
+
+				//the gradients are those of 6 V
+				const float lambda = stiffnessMultiplier * 6.0f * (volume - m_volumeRestVolumes[t]) / denominator;
+
+				for (int v = 0; v < 4; ++v)
+				{
+					const Eigen::Vector3f deltaX = -lambda * inverseMasses[idxs[v]] * gradients[v];
+					positions[idxs[v]] += deltaX;
+					residual.add(deltaX);
+				}
+			}
+
+			residualReduction.add(residual);
+		});
+	}
+}
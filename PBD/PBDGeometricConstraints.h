@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+#include <Eigen\Dense>
+
+#include "PBDParticleStore.h"
+#include "PBDTetrahedra3d.h"
+#include "PBDConstraintColoring.h"
+#include "PBDProjectionResidual.h"
+
+//Geometric constraint sets of a tet mesh: one distance constraint per unique edge and one volume constraint per tet,
+//with their rest lengths / volumes in flat tables. Both sets are graph coloured, so every colour is projected in
+//parallel; they run in the same iteration loop as the energy constraints (see PBDSolverSettings::useDistanceConstraints
+//and useVolumeConstraints).
+class PBDGeometricConstraints
+{
+public:
+	PBDGeometricConstraints();
+	~PBDGeometricConstraints();
+
+	//Rest lengths and volumes are the tets' undeformed ones
+	void initialise(std::vector<PBDTetrahedra3d>& tetrahedra, int numParticles);
+
+	bool isInitialised(int numParticles, int numTetrahedra) const
+	{
+		return m_numParticles == numParticles && m_volumeRestVolumes.size() == numTetrahedra;
+	}
+
+	//One Gauss-Seidel sweep over all edges. 'stiffnessMultiplier' scales the corrections (see getStiffnessMultiplier);
+	//constraints without a simulated particle are skipped if 'isParticleSimulated' is given.
+	void projectDistanceConstraints(PBDParticleStore& particles, float stiffnessMultiplier,
+		const std::vector<char>* isParticleSimulated, PBDProjectionResidualReduction& residualReduction) const;
+
+	//One Gauss-Seidel sweep over all tets, see projectDistanceConstraints
+	void projectVolumeConstraints(PBDParticleStore& particles, float stiffnessMultiplier,
+		const std::vector<char>* isParticleSimulated, PBDProjectionResidualReduction& residualReduction) const;
+
+	//Per iteration multiplier for which 'numIterations' iterations reach the stiffness k in [0, 1]
+	static float getStiffnessMultiplier(float k, int numIterations);
+
+	int getNumEdges() const { return m_edgeRestLengths.size(); }
+
+	void printStatistics() const;
+
+	void clear();
+
+private:
+	//2 particle indices and the rest length per edge
+	std::vector<int> m_edgeIndices;
+	std::vector<float> m_edgeRestLengths;
+	PBDConstraintColoring m_edgeColoring;
+
+	//4 particle indices and the signed rest volume per tet
+	std::vector<int> m_volumeIndices;
+	std::vector<float> m_volumeRestVolumes;
+	PBDConstraintColoring m_volumeColoring;
+
+	int m_numParticles;
+};
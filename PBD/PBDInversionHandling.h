@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <iostream>
+
+#include <Eigen\Dense>
+
+#include "PBDInversionHandlingLanes.h"
+
+//Single matrix version of laneIsWithinSingularValueRange (see PBDInversionHandlingLanes.h).
+inline bool isWithinSingularValueRange(const Eigen::Matrix3f& F, float minSingularValue, float maxSingularValue)
+{
+	const float squaredNorm = F.squaredNorm();
+	const float determinant = F.determinant();
+
+	return determinant > 0.0f && squaredNorm <= maxSingularValue * maxSingularValue
+		&& minSingularValue * squaredNorm <= 2.0f * determinant;
+}
+
+//Number of constraint evaluations that skipped the SVD (fast path) and that went through the diagonalised path,
+//plus the evaluations of the multi-threaded and Jacobi kernels in total and those skipped for an undeformed tet
+//(zero denominator) or a non-finite multiplier. The kernels count into a local instance and add it to the solver's
+//PBDInversionHandlingCounters once per range.
+struct PBDInversionHandlingCounts
+{
+	PBDInversionHandlingCounts() : numFastPath(0), numFullPath(0), numEvaluations(0), numZeroDenominatorSkips(0),
+		numInvalidMultiplierSkips(0)
+	{
+	}
+
+	long long numFastPath;
+	long long numFullPath;
+
+	long long numEvaluations;
+	long long numZeroDenominatorSkips;
+	long long numInvalidMultiplierSkips;
+};
+
+//Totals over all threads since the last reset.
+class PBDInversionHandlingCounters
+{
+public:
+	PBDInversionHandlingCounters()
+	{
+		reset();
+	}
+
+	void add(const PBDInversionHandlingCounts& counts)
+	{
+		m_numFastPath += counts.numFastPath;
+		m_numFullPath += counts.numFullPath;
+		m_numEvaluations += counts.numEvaluations;
+		m_numZeroDenominatorSkips += counts.numZeroDenominatorSkips;
+		m_numInvalidMultiplierSkips += counts.numInvalidMultiplierSkips;
+	}
+
+	void reset()
+	{
+		m_numFastPath = 0;
+		m_numFullPath = 0;
+		m_numEvaluations = 0;
+		m_numZeroDenominatorSkips = 0;
+		m_numInvalidMultiplierSkips = 0;
+	}
+
+	PBDInversionHandlingCounts getCounts() const
+	{
+		PBDInversionHandlingCounts counts;
+		counts.numFastPath = m_numFastPath;
+		counts.numFullPath = m_numFullPath;
+		counts.numEvaluations = m_numEvaluations;
+		counts.numZeroDenominatorSkips = m_numZeroDenominatorSkips;
+		counts.numInvalidMultiplierSkips = m_numInvalidMultiplierSkips;
+		return counts;
+	}
+
+	//Fraction of the evaluations that skipped the SVD; 0 if nothing was counted
+	float getFastPathFraction() const
+	{
+		const PBDInversionHandlingCounts counts = getCounts();
+		const long long numEvaluations = counts.numFastPath + counts.numFullPath;
+
+		return numEvaluations > 0 ? (float)counts.numFastPath / (float)numEvaluations : 0.0f;
+	}
+
+	void print() const
+	{
+		const PBDInversionHandlingCounts counts = getCounts();
+
+		std::cout << "Inversion handling: " << counts.numFastPath << " fast path, " << counts.numFullPath
+			<< " diagonalised evaluations (" << 100.0f * getFastPathFraction() << "% fast path)" << std::endl;
+	}
+
+private:
+	std::atomic<long long> m_numFastPath;
+	std::atomic<long long> m_numFullPath;
+	std::atomic<long long> m_numEvaluations;
+	std::atomic<long long> m_numZeroDenominatorSkips;
+	std::atomic<long long> m_numInvalidMultiplierSkips;
+};
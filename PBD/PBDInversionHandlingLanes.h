@@ -0,0 +1,31 @@
+#pragma once
+
+#include "LaneMath.h"
+
+//Inversion handling diagonalises F = U * F_hat * V^T and clamps the singular values to [minSingularValue,
+//maxSingularValue]. For elements whose singular values already lie within that range the clamping does nothing and
+//the isotropic stress is rotation invariant, i.e. the SVD can be skipped and PF evaluated on F directly.
+//
+//The test below bounds the singular values without computing them: sigma_max <= |F|_F, and
+//sigma_min = det(F) / (sigma_max * sigma_mid) >= 2 det(F) / |F|_F^2 as sigma_max * sigma_mid <= |F|_F^2 / 2.
+//An undeformed element gives 2/3 for the lower bound, so mildly deformed elements pass a minimum of 0.577.
+//Free of Eigen, see PBDSolverBatchKernelAVX2.h; PBDInversionHandling.h adds the single matrix version.
+template<typename Real>
+LANE_INLINE auto laneIsWithinSingularValueRange(const LaneMat3<Real>& F, float minSingularValue, float maxSingularValue)
+	-> decltype(lanesLess(Real(0.0f), Real(0.0f)))
+{
+	Real squaredNorm(0.0f);
+	for (int r = 0; r < 3; ++r)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			squaredNorm = squaredNorm + F.m[r][c] * F.m[r][c];
+		}
+	}
+
+	const Real determinant = laneDeterminant(F);
+
+	return lanesAnd(lanesAnd(lanesLess(Real(0.0f), determinant),
+		lanesLessEqual(squaredNorm, Real(maxSingularValue * maxSingularValue))),
+		lanesLessEqual(Real(minSingularValue) * squaredNorm, Real(2.0f) * determinant));
+}
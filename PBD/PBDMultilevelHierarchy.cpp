@@ -0,0 +1,372 @@
+#include "PBDMultilevelHierarchy.h"
+
+#include <iostream>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include <tbb\parallel_for.h>
+#include <tbb\blocked_range.h>
+
+#include "PBDSolver.h"
+#include "MeshCreator.h"
+
+namespace
+{
+	//The coarse levels only carry the elastic response: no viscoelasticity, per-tet materials, ground plane,
+	//early termination or acceleration, and no further levels
+	PBDSolverSettings
+	getCoarseLevelSettings(const PBDSolverSettings& settings)
+	{
+		PBDSolverSettings coarseSettings = settings;
+		coarseSettings.numConstraintIts = settings.numCoarseLevelIts;
+		coarseSettings.numCoarseLevels = 0;
+		coarseSettings.alpha = 0.0f;
+		coarseSettings.usePerTetMaterialAttributes = false;
+		coarseSettings.enableGroundPlaneCollision = false;
+		coarseSettings.constraintTolerance = 0.0f;
+		coarseSettings.useChebyshevAcceleration = false;
+		coarseSettings.useSleeping = false;
+		coarseSettings.useWarmStarting = false;
+		coarseSettings.useDistanceConstraints = false;
+		coarseSettings.useVolumeConstraints = false;
+		coarseSettings.useSOR = false;
+		coarseSettings.enableProfiling = false;
+		coarseSettings.useJacobiSolver = false;
+		coarseSettings.useMultiThreadedSolver = true;
+
+		return coarseSettings;
+	}
+}
+
+PBDMultilevelHierarchy::PBDMultilevelHierarchy()
+{
+	m_numFineParticles = 0;
+}
+
+
+PBDMultilevelHierarchy::~PBDMultilevelHierarchy()
+{
+}
+
+void
+PBDMultilevelHierarchy::clear()
+{
+	m_levels.clear();
+	m_fineRestPositions.clear();
+	m_numFineParticles = 0;
+}
+
+void
+PBDMultilevelHierarchy::initialise(std::vector<PBDTetrahedra3d>& tetrahedra, PBDParticleStore& particles,
+	const PBDSolverSettings& settings)
+{
+	clear();
+
+	if (tetrahedra.empty() || settings.numCoarseLevels < 1)
+	{
+		return;
+	}
+
+	m_fineRestPositions = particles.getPreviousPositions();
+	m_numFineParticles = particles.size();
+
+	//the first level's cells are twice the input mesh's average edge length
+	double edgeLengthSum = 0.0;
+	for (int t = 0; t < tetrahedra.size(); ++t)
+	{
+		const std::vector<int>& vertexIndices = tetrahedra[t].getVertexIndices();
+		for (int a = 0; a < 4; ++a)
+		{
+			for (int b = a + 1; b < 4; ++b)
+			{
+				edgeLengthSum += (m_fineRestPositions[vertexIndices[a]] - m_fineRestPositions[vertexIndices[b]]).norm();
+			}
+		}
+	}
+	float cellSize = 2.0f * (float)(edgeLengthSum / (6.0 * tetrahedra.size()));
+
+	m_levels.resize(settings.numCoarseLevels);
+	for (int l = 0; l < m_levels.size(); ++l)
+	{
+		const std::vector<Eigen::Vector3f>& finerRestPositions = (l == 0) ? m_fineRestPositions : m_levels[l - 1].restPositions;
+		const std::vector<float>& finerInverseMasses = (l == 0) ? particles.getInverseMasses() : m_levels[l - 1].state.particles->getInverseMasses();
+
+		buildLevel(finerRestPositions, finerInverseMasses, cellSize, settings, m_levels[l]);
+
+		std::cout << "Multilevel solver: level " << l + 1 << " has " << m_levels[l].state.tetrahedra->size() << " tets and "
+			<< m_levels[l].state.particles->size() << " vertices (cell size " << cellSize << ")" << std::endl;
+
+		cellSize *= 2.0f;
+	}
+}
+
+void
+PBDMultilevelHierarchy::buildLevel(const std::vector<Eigen::Vector3f>& finerRestPositions, const std::vector<float>& finerInverseMasses,
+	float cellSize, const PBDSolverSettings& settings, Level& level)
+{
+	//1. the grid cells touched by the finer particles
+	Eigen::Vector3f origin = finerRestPositions[0];
+	Eigen::Vector3f extent = finerRestPositions[0];
+	for (int p = 1; p < finerRestPositions.size(); ++p)
+	{
+		origin = origin.cwiseMin(finerRestPositions[p]);
+		extent = extent.cwiseMax(finerRestPositions[p]);
+	}
+
+	Eigen::Vector3i gridSize;
+	for (int d = 0; d < 3; ++d)
+	{
+		gridSize[d] = (int)std::floor((extent[d] - origin[d]) / cellSize) + 1;
+	}
+
+	std::vector<int> finerCells(finerRestPositions.size());
+	std::vector<int> gridToCell(gridSize[0] * gridSize[1] * gridSize[2], -1);
+	for (int p = 0; p < finerRestPositions.size(); ++p)
+	{
+		Eigen::Vector3i cell;
+		for (int d = 0; d < 3; ++d)
+		{
+			cell[d] = std::min(std::max((int)std::floor((finerRestPositions[p][d] - origin[d]) / cellSize), 0), gridSize[d] - 1);
+		}
+		finerCells[p] = cell[0] * gridSize[1] * gridSize[2] + cell[1] * gridSize[2] + cell[2];
+
+		//occupied, numbered below
+		gridToCell[finerCells[p]] = 0;
+	}
+
+	std::vector<Eigen::Vector3i> cells;
+	for (int i = 0; i < gridSize[0]; ++i)
+	{
+		for (int j = 0; j < gridSize[1]; ++j)
+		{
+			for (int k = 0; k < gridSize[2]; ++k)
+			{
+				int& cellIdx = gridToCell[i * gridSize[1] * gridSize[2] + j * gridSize[2] + k];
+				if (cellIdx == 0)
+				{
+					cellIdx = cells.size();
+					cells.push_back(Eigen::Vector3i(i, j, k));
+				}
+			}
+		}
+	}
+
+	MeshCreator::generateTetGridFromCells(level.state.particles, *level.state.tetrahedra, origin, cellSize, cells);
+
+	level.restPositions = level.state.particles->getPositions();
+	level.restrictedPositions = level.restPositions;
+
+	//2. barycentric embedding in the containing cell's tets (5 per cell); particles on a shared face may fall just
+	//outside all of them, the tet with the largest minimum coordinate is used and the weights are clamped
+	const int numFiner = finerRestPositions.size();
+	const int numCoarse = level.state.particles->size();
+
+	level.embeddingIndices.resize(numFiner * 4);
+	level.embeddingWeights.resize(numFiner * 4);
+
+	for (int p = 0; p < numFiner; ++p)
+	{
+		const int cellIdx = gridToCell[finerCells[p]];
+
+		float bestMinWeight = -std::numeric_limits<float>::max();
+		for (int t = cellIdx * 5; t < cellIdx * 5 + 5; ++t)
+		{
+			const std::vector<int>& vertexIndices = (*level.state.tetrahedra)[t].getVertexIndices();
+			const Eigen::Vector3f& x0 = level.restPositions[vertexIndices[0]];
+
+			Eigen::Matrix3f edges;
+			edges.col(0) = level.restPositions[vertexIndices[1]] - x0;
+			edges.col(1) = level.restPositions[vertexIndices[2]] - x0;
+			edges.col(2) = level.restPositions[vertexIndices[3]] - x0;
+
+			const Eigen::Vector3f coordinates = edges.inverse() * (finerRestPositions[p] - x0);
+			const Eigen::Vector4f weights(1.0f - coordinates.sum(), coordinates[0], coordinates[1], coordinates[2]);
+
+			if (weights.minCoeff() > bestMinWeight)
+			{
+				bestMinWeight = weights.minCoeff();
+
+				const Eigen::Vector4f clampedWeights = weights.cwiseMax(0.0f);
+				for (int v = 0; v < 4; ++v)
+				{
+					level.embeddingIndices[p * 4 + v] = vertexIndices[v];
+					level.embeddingWeights[p * 4 + v] = clampedWeights[v] / clampedWeights.sum();
+				}
+			}
+		}
+	}
+
+	//3. restriction (transposed embedding) and lumped masses. Coarse vertices without any embedded weight follow
+	//their nearest finer particle.
+	std::vector<std::vector<std::pair<int, float> > > coarseToFiner(numCoarse);
+	for (int p = 0; p < numFiner; ++p)
+	{
+		for (int v = 0; v < 4; ++v)
+		{
+			if (level.embeddingWeights[p * 4 + v] > 0.0f)
+			{
+				coarseToFiner[level.embeddingIndices[p * 4 + v]].push_back(std::make_pair(p, level.embeddingWeights[p * 4 + v]));
+			}
+		}
+	}
+
+	for (int c = 0; c < numCoarse; ++c)
+	{
+		if (!coarseToFiner[c].empty())
+		{
+			continue;
+		}
+
+		int nearest = 0;
+		float nearestSquaredDistance = std::numeric_limits<float>::max();
+		for (int p = 0; p < numFiner; ++p)
+		{
+			const float squaredDistance = (finerRestPositions[p] - level.restPositions[c]).squaredNorm();
+			if (squaredDistance < nearestSquaredDistance)
+			{
+				nearestSquaredDistance = squaredDistance;
+				nearest = p;
+			}
+		}
+		coarseToFiner[c].push_back(std::make_pair(nearest, 1.0f));
+	}
+
+	//a coarse vertex noticeably influencing a fixed particle is fixed itself
+	const float fixedWeightThreshold = 1e-3f;
+
+	level.restrictionOffsets.assign(numCoarse + 1, 0);
+	level.restrictionIndices.clear();
+	level.restrictionWeights.clear();
+
+	std::vector<float>& coarseInverseMasses = level.state.particles->getInverseMasses();
+	for (int c = 0; c < numCoarse; ++c)
+	{
+		float weightSum = 0.0f;
+		float mass = 0.0f;
+		bool isFixed = false;
+
+		for (int i = 0; i < coarseToFiner[c].size(); ++i)
+		{
+			const int p = coarseToFiner[c][i].first;
+			const float weight = coarseToFiner[c][i].second;
+
+			weightSum += weight;
+			if (finerInverseMasses[p] == 0.0f)
+			{
+				isFixed = isFixed || weight > fixedWeightThreshold;
+			}
+			else
+			{
+				mass += weight / finerInverseMasses[p];
+			}
+		}
+
+		for (int i = 0; i < coarseToFiner[c].size(); ++i)
+		{
+			level.restrictionIndices.push_back(coarseToFiner[c][i].first);
+			level.restrictionWeights.push_back(coarseToFiner[c][i].second / weightSum);
+		}
+		level.restrictionOffsets[c + 1] = level.restrictionIndices.size();
+
+		coarseInverseMasses[c] = isFixed ? 0.0f : ((mass > 0.0f) ? 1.0f / mass : 1.0f);
+	}
+
+	//4. the level's own solver state
+	const PBDSolverSettings coarseSettings = getCoarseLevelSettings(settings);
+
+	level.solver = std::make_shared<PBDSolver>();
+	level.solver->initialiseTetRestStates(*level.state.tetrahedra, coarseSettings);
+	level.solver->initialiseTetrahedraColoring(*level.state.tetrahedra, *level.state.particles);
+}
+
+void
+PBDMultilevelHierarchy::restrictPositions(const std::vector<Eigen::Vector3f>& finerPositions, const std::vector<Eigen::Vector3f>& finerRestPositions,
+	Level& level)
+{
+	std::vector<Eigen::Vector3f>& positions = level.state.particles->getPositions();
+
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, positions.size()), [&](const tbb::blocked_range<size_t>& r)
+	{
+		for (size_t c = r.begin(); c != r.end(); ++c)
+		{
+			Eigen::Vector3f displacement = Eigen::Vector3f::Zero();
+			for (int i = level.restrictionOffsets[c]; i < level.restrictionOffsets[c + 1]; ++i)
+			{
+				const int p = level.restrictionIndices[i];
+				displacement += level.restrictionWeights[i] * (finerPositions[p] - finerRestPositions[p]);
+			}
+
+			positions[c] = level.restPositions[c] + displacement;
+			level.restrictedPositions[c] = positions[c];
+		}
+	});
+}
+
+void
+PBDMultilevelHierarchy::prolongateCorrections(const Level& level, std::vector<Eigen::Vector3f>& finerPositions, const std::vector<float>& finerInverseMasses,
+	const std::vector<char>* isFinerParticleSimulated)
+{
+	const std::vector<Eigen::Vector3f>& positions = level.state.particles->getPositions();
+
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, finerPositions.size()), [&](const tbb::blocked_range<size_t>& r)
+	{
+		for (size_t p = r.begin(); p != r.end(); ++p)
+		{
+			if (finerInverseMasses[p] == 0.0f || (isFinerParticleSimulated != NULL && !(*isFinerParticleSimulated)[p]))
+			{
+				continue;
+			}
+
+			for (int v = 0; v < 4; ++v)
+			{
+				const int c = level.embeddingIndices[p * 4 + v];
+				finerPositions[p] += level.embeddingWeights[p * 4 + v] * (positions[c] - level.restrictedPositions[c]);
+			}
+		}
+	});
+}
+
+void
+PBDMultilevelHierarchy::projectCoarseLevels(PBDParticleStore& particles, const PBDSolverSettings& settings,
+	const std::vector<char>* isFineParticleSimulated)
+{
+	if (m_levels.empty())
+	{
+		return;
+	}
+
+	PBDSolverSettings coarseSettings = getCoarseLevelSettings(settings);
+
+	//down: every level follows the current state of the one below
+	for (int l = 0; l < m_levels.size(); ++l)
+	{
+		if (l == 0)
+		{
+			restrictPositions(particles.getPositions(), m_fineRestPositions, m_levels[l]);
+		}
+		else
+		{
+			restrictPositions(m_levels[l - 1].state.particles->getPositions(), m_levels[l - 1].restPositions, m_levels[l]);
+		}
+	}
+
+	//up: solve, then hand the level's total correction to the next finer level
+	for (int l = m_levels.size() - 1; l >= 0; --l)
+	{
+		Level& level = m_levels[l];
+
+		level.solver->selectConstraintKernels(coarseSettings, false);
+		level.solver->getTetRestStates().resetLagrangeMultipliers(coarseSettings);
+		level.solver->projectConstraintsVISCOELASTIC_MULTI(level.state, coarseSettings);
+
+		if (l == 0)
+		{
+			prolongateCorrections(level, particles.getPositions(), particles.getInverseMasses(), isFineParticleSimulated);
+		}
+		else
+		{
+			prolongateCorrections(level, m_levels[l - 1].state.particles->getPositions(), m_levels[l - 1].state.particles->getInverseMasses(), NULL);
+		}
+	}
+}
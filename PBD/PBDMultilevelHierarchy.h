@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include <Eigen\Dense>
+
+#include "PBDParticleStore.h"
+#include "PBDTetrahedra3d.h"
+#include "PBDSolverSettings.h"
+#include "PBDSimulationState.h"
+
+class PBDSolver;
+
+//Coarse tetrahedral levels for the multilevel solver mode (see PBDSolverSettings::numCoarseLevels). Every coarse
+//level is a regular tet grid (MeshCreator::generateTetGridFromCells) over the cells touched by the next finer
+//level's particles, with twice the cell size of the level below (the first one twice the average edge length of the
+//input mesh). The finer particles are embedded barycentrically in the coarse tets.
+//
+//Before the fine sweeps of a step, projectCoarseLevels restricts the current positions down to the coarsest level,
+//runs numCoarseLevelIts sweeps there and prolongates the resulting corrections back up level by level (with another
+//numCoarseLevelIts sweeps on every intermediate level). The coarse levels use the same material, so they resolve
+//the low-frequency part of the deformation the fine sweeps are slow to propagate.
+class PBDMultilevelHierarchy
+{
+public:
+	PBDMultilevelHierarchy();
+	~PBDMultilevelHierarchy();
+
+	//The committed particle positions (see PBDParticleStore::swapStates) are taken as the rest state of the coarse levels
+	void initialise(std::vector<PBDTetrahedra3d>& tetrahedra, PBDParticleStore& particles,
+		const PBDSolverSettings& settings);
+
+	bool isInitialised(int numFineParticles, int numCoarseLevels) const
+	{
+		return m_numFineParticles == numFineParticles && m_levels.size() == numCoarseLevels;
+	}
+
+	//Particles whose 'isFineParticleSimulated' flag is 0 keep their positions (sleeping, see PBDActivityTracker)
+	void projectCoarseLevels(PBDParticleStore& particles, const PBDSolverSettings& settings,
+		const std::vector<char>* isFineParticleSimulated);
+
+	int getNumLevels() const { return m_levels.size(); }
+
+	void clear();
+
+private:
+	struct Level
+	{
+		//the level's mesh and particles, without colliders
+		PBDSimulationState state;
+		std::shared_ptr<PBDSolver> solver;
+
+		std::vector<Eigen::Vector3f> restPositions;
+		std::vector<Eigen::Vector3f> restrictedPositions;
+
+		//finer particle -> 4 coarse particles and barycentric weights (prolongation)
+		std::vector<int> embeddingIndices;
+		std::vector<float> embeddingWeights;
+
+		//coarse particle -> finer particles (restriction, CSR, weights sum to 1)
+		std::vector<int> restrictionOffsets;
+		std::vector<int> restrictionIndices;
+		std::vector<float> restrictionWeights;
+	};
+
+	//Builds the level above the given finer particles (rest positions, inverse masses)
+	void buildLevel(const std::vector<Eigen::Vector3f>& finerRestPositions, const std::vector<float>& finerInverseMasses,
+		float cellSize, const PBDSolverSettings& settings, Level& level);
+
+	void restrictPositions(const std::vector<Eigen::Vector3f>& finerPositions, const std::vector<Eigen::Vector3f>& finerRestPositions,
+		Level& level);
+
+	void prolongateCorrections(const Level& level, std::vector<Eigen::Vector3f>& finerPositions, const std::vector<float>& finerInverseMasses,
+		const std::vector<char>* isFinerParticleSimulated);
+
+	std::vector<Level> m_levels;
+
+	std::vector<Eigen::Vector3f> m_fineRestPositions;
+	int m_numFineParticles;
+};
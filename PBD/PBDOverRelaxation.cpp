@@ -0,0 +1,147 @@
+#include "PBDOverRelaxation.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <tbb\parallel_for.h>
+#include <tbb\blocked_range.h>
+
+#include "PBDSolverProcessingFunctionsTBB.h"
+
+PBDOverRelaxation::PBDOverRelaxation()
+{
+	m_numSweeps = 0;
+	m_omega = 1.0f;
+	m_tunedOmega = 1.0f;
+	m_firstResidual = 0.0f;
+	m_lastResidual = 0.0f;
+	m_backOffDecay = 1.0f;
+	m_hasBackedOff = false;
+	m_numBackOffs = 0;
+}
+
+
+PBDOverRelaxation::~PBDOverRelaxation()
+{
+}
+
+void
+PBDOverRelaxation::begin(const PBDSolverSettings& settings)
+{
+	m_numSweeps = 0;
+	m_firstResidual = 0.0f;
+	m_lastResidual = 0.0f;
+	m_backOffDecay = 1.0f;
+	m_hasBackedOff = false;
+
+	if (settings.autoTuneSOR && settings.sorTuningIts > 0)
+	{
+		m_omega = 1.0f;
+	}
+	else
+	{
+		m_omega = settings.w;
+		m_tunedOmega = settings.w;
+	}
+}
+
+void
+PBDOverRelaxation::saveColor(const std::vector<int>& tetIdxs, PBDTetRestStateTable& tetRestStates,
+	const PBDParticleStore& particles, const PBDSolverSettings& settings)
+{
+	m_colorPositions.resize(4 * tetIdxs.size());
+	m_colorLagrangeMultipliers.resize(tetIdxs.size());
+
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, tetIdxs.size()), [&](const tbb::blocked_range<size_t>& r)
+	{
+		for (size_t i = r.begin(); i != r.end(); ++i)
+		{
+			const PBDTetRestState& rest = tetRestStates.getRestState(tetIdxs[i]);
+			for (int v = 0; v < 4; ++v)
+			{
+				m_colorPositions[4 * i + v] = particles.position(rest.vertexIndices[v]);
+			}
+
+			if (settings.useXPBD)
+			{
+				m_colorLagrangeMultipliers[i] = tetRestStates.getLagrangeMultiplier(tetIdxs[i]);
+			}
+		}
+	});
+}
+
+void
+PBDOverRelaxation::relaxColor(const std::vector<int>& tetIdxs, PBDTetRestStateTable& tetRestStates,
+	PBDParticleStore& particles, std::vector<CollisionSphere>& collisionGeometry3, const PBDSolverSettings& settings)
+{
+	const float omega = m_omega;
+
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, tetIdxs.size()), [&](const tbb::blocked_range<size_t>& r)
+	{
+		for (size_t i = r.begin(); i != r.end(); ++i)
+		{
+			const PBDTetRestState& rest = tetRestStates.getRestState(tetIdxs[i]);
+			for (int v = 0; v < 4; ++v)
+			{
+				const Eigen::Vector3f& start = m_colorPositions[4 * i + v];
+				Eigen::Vector3f& position = particles.position(rest.vertexIndices[v]);
+
+				Eigen::Vector3f proposedEndpoint = start + omega * (position - start);
+				if (!collisionGeometry3.empty())
+				{
+					correctEndpointForCollisionSpheres(position, proposedEndpoint, collisionGeometry3, settings);
+				}
+
+				position = proposedEndpoint;
+			}
+
+			if (settings.useXPBD)
+			{
+				float& lagrangeMultiplier = tetRestStates.getLagrangeMultiplier(tetIdxs[i]);
+				lagrangeMultiplier = m_colorLagrangeMultipliers[i] + omega * (lagrangeMultiplier - m_colorLagrangeMultipliers[i]);
+			}
+		}
+	});
+}
+
+void
+PBDOverRelaxation::endSweep(float residual, const PBDSolverSettings& settings)
+{
+	++m_numSweeps;
+
+	if (m_numSweeps == 1)
+	{
+		m_firstResidual = residual;
+	}
+
+	if (settings.autoTuneSOR && m_numSweeps == settings.sorTuningIts)
+	{
+		//omega stays 1 if the sweeps did not converge
+		if (m_numSweeps > 1 && m_firstResidual > 0.0f && residual < m_firstResidual)
+		{
+			const float rho = std::pow(residual / m_firstResidual, 1.0f / (float)(m_numSweeps - 1));
+			m_tunedOmega = std::min(2.0f / (1.0f + std::sqrt(1.0f - rho)), 1.95f);
+
+			//over-relaxed sweeps have to beat the plain ones
+			m_backOffDecay = rho;
+		}
+		else
+		{
+			m_tunedOmega = 1.0f;
+		}
+
+		m_omega = m_tunedOmega;
+	}
+	else if (m_omega > 1.0f && m_numSweeps > 1 && residual > m_backOffDecay * m_lastResidual)
+	{
+		m_omega = 1.0f + 0.5f * (m_omega - 1.0f);
+
+		if (!m_hasBackedOff)
+		{
+			m_hasBackedOff = true;
+			++m_numBackOffs;
+		}
+	}
+
+	m_lastResidual = residual;
+}
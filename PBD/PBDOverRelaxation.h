@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+
+#include <Eigen\Dense>
+
+#include "PBDParticleStore.h"
+#include "PBDSolverSettings.h"
+#include "PBDTetRestStateTable.h"
+#include "CollisionSphere.h"
+
+//Multi-colour successive over-relaxation of the multi-threaded solver (see PBDSolverSettings::useSOR). Every colour
+//sweep moves its particles from x to x_hat; they are then placed at
+//
+//   x + omega * (x_hat - x)
+//
+//before the next colour reads them; with XPBD the colour's Lagrange multipliers are relaxed the same way, so they
+//stay consistent with the positions. As the tets of one colour share no particles, this is Gauss-Seidel SOR over
+//the colour ordering and keeps the colours parallel. With auto-tuning, the first sorTuningIts sweeps of a step run
+//with omega = 1 and the spectral radius rho of the Gauss-Seidel sweep is estimated from how fast their residuals
+//decay; the remaining sweeps use the optimum of the linear theory, omega = 2 / (1 + sqrt(1 - rho)) (at most 1.95),
+//instead of settings.w. A sweep with a larger residual than the one before (auto-tuned: one that decays slower than
+//rho) halves omega - 1 for the rest of the step.
+class PBDOverRelaxation
+{
+public:
+	PBDOverRelaxation();
+	~PBDOverRelaxation();
+
+	//Call before the first sweep of every step
+	void begin(const PBDSolverSettings& settings);
+
+	//Omega of the current sweep
+	float getOmega() const { return m_omega; }
+
+	//Stores the positions (and multipliers) of the colour; call before projecting the colour if getOmega() != 1
+	void saveColor(const std::vector<int>& tetIdxs, PBDTetRestStateTable& tetRestStates, const PBDParticleStore& particles,
+		const PBDSolverSettings& settings);
+
+	//Over-relaxes the colour's corrections since saveColor; the positions are moved out of the collision spheres
+	void relaxColor(const std::vector<int>& tetIdxs, PBDTetRestStateTable& tetRestStates, PBDParticleStore& particles,
+		std::vector<CollisionSphere>& collisionGeometry3, const PBDSolverSettings& settings);
+
+	//Call after every sweep with its residual (PBDProjectionResidualReduction::getMaxCorrection)
+	void endSweep(float residual, const PBDSolverSettings& settings);
+
+	//Omega the last auto-tuning arrived at (settings.w without auto-tuning)
+	float getTunedOmega() const { return m_tunedOmega; }
+
+	//Steps that had to back off from their omega since construction
+	int getNumBackOffs() const { return m_numBackOffs; }
+
+private:
+	//4 per tet of the current colour
+	std::vector<Eigen::Vector3f> m_colorPositions;
+
+	//1 per tet of the current colour (XPBD)
+	std::vector<float> m_colorLagrangeMultipliers;
+
+	int m_numSweeps;
+	float m_omega;
+	float m_tunedOmega;
+	float m_firstResidual;
+	float m_lastResidual;
+	float m_backOffDecay;
+	bool m_hasBackedOff;
+	int m_numBackOffs;
+};
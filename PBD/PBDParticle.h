@@ -3,41 +3,38 @@
 #include <vector>
 #include <Eigen/Dense>
 
+#include "PBDParticleStore.h"
+
+//Handle to a single particle of a PBDParticleStore. It is cheap to copy and only valid as long as the store
+//is not resized; all accessors refer directly to the store's arrays.
 class PBDParticle
 {
 public:
-	PBDParticle();
-	PBDParticle(const Eigen::Vector3f& position, const Eigen::Vector3f& velocity, float inverseMass);
-	~PBDParticle();
+	PBDParticle(PBDParticleStore* store, int idx) : m_store(store), m_idx(idx) {}
 
-	Eigen::Vector3f& position() { return m_position; }
-	Eigen::Vector3f& velocity() { return m_velocity; }
+	Eigen::Vector3f& position() { return m_store->position(m_idx); }
+	Eigen::Vector3f& velocity() { return m_store->velocity(m_idx); }
 
-	Eigen::Vector3f& previousPosition() { return m_previousPosition; }
-	Eigen::Vector3f& previousVelocity() { return m_previousVelocity; }
+	Eigen::Vector3f& previousPosition() { return m_store->previousPosition(m_idx); }
+	Eigen::Vector3f& previousVelocity() { return m_store->previousVelocity(m_idx); }
 
-	Eigen::Vector3f& pastPosition() { return m_pastPosition; }
-	Eigen::Vector3f& pastVelocity() { return m_pastVelocity; }
+	Eigen::Vector3f& pastPosition() { return m_store->pastPosition(m_idx); }
 
-	float& inverseMass() { return m_inverseMass;  }
+	float& inverseMass() { return m_store->inverseMass(m_idx); }
 
-	void swapStates();
+	int getIdx() const { return m_idx; }
 
-	int getNumContainingTetrahedra() { return m_tetrahedra.size(); }
+	int getNumContainingTetrahedra() { return m_store->getNumContainingTetrahedra(m_idx); }
 
-	std::vector<int>& getContainingTetIdxs(){ return m_tetrahedra; }
+	const int* getContainingTetIdxs() { return m_store->getContainingTetIdxs(m_idx); }
 
 private:
-	std::vector<int> m_tetrahedra;
-	float m_inverseMass;
-
-	Eigen::Vector3f m_pastPosition;
-	Eigen::Vector3f m_pastVelocity;
-
-	Eigen::Vector3f m_previousPosition;
-	Eigen::Vector3f m_previousVelocity;
-
-	Eigen::Vector3f m_position;
-	Eigen::Vector3f m_velocity;
+	PBDParticleStore* m_store;
+	int m_idx;
 };
 
+PBDParticle
+PBDParticleStore::operator[](int idx)
+{
+	return PBDParticle(this, idx);
+}
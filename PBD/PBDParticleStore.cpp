@@ -0,0 +1,90 @@
+#include "PBDParticleStore.h"
+
+#include "PBDParticle.h"
+#include "PBDTetrahedra3d.h"
+
+PBDParticleStore::PBDParticleStore()
+{
+	m_tetAdjacencyOffsets.push_back(0);
+}
+
+
+PBDParticleStore::~PBDParticleStore()
+{
+}
+
+void
+PBDParticleStore::clear()
+{
+	m_positions.clear();
+	m_velocities.clear();
+	m_previousPositions.clear();
+	m_previousVelocities.clear();
+	m_pastPositions.clear();
+	m_inverseMasses.clear();
+
+	m_tetAdjacencyOffsets.assign(1, 0);
+	m_tetAdjacency.clear();
+}
+
+void
+PBDParticleStore::reserve(int numParticles)
+{
+	m_positions.reserve(numParticles);
+	m_velocities.reserve(numParticles);
+	m_previousPositions.reserve(numParticles);
+	m_previousVelocities.reserve(numParticles);
+	m_pastPositions.reserve(numParticles);
+	m_inverseMasses.reserve(numParticles);
+}
+
+int
+PBDParticleStore::addParticle(const Eigen::Vector3f& position, const Eigen::Vector3f& velocity, float inverseMass)
+{
+	m_positions.push_back(position);
+	m_previousPositions.push_back(position);
+	m_pastPositions.push_back(position);
+	m_velocities.push_back(velocity);
+	m_previousVelocities.push_back(velocity);
+	m_inverseMasses.push_back(inverseMass);
+
+	//a new particle is not part of any tetrahedron until initialiseTetAdjacency() is called
+	m_tetAdjacencyOffsets.push_back(m_tetAdjacencyOffsets.back());
+
+	return m_positions.size() - 1;
+}
+
+void
+PBDParticleStore::swapStates()
+{
+	m_pastPositions.swap(m_previousPositions);
+	m_previousPositions.swap(m_positions);
+	m_previousVelocities.swap(m_velocities);
+}
+
+void
+PBDParticleStore::initialiseTetAdjacency(const std::vector<PBDTetrahedra3d>& tetrahedra)
+{
+	m_tetAdjacencyOffsets.assign(size() + 1, 0);
+	for (int t = 0; t < tetrahedra.size(); ++t)
+	{
+		for (int v = 0; v < 4; ++v)
+		{
+			++m_tetAdjacencyOffsets[tetrahedra[t].getVertexIndices()[v] + 1];
+		}
+	}
+	for (int p = 0; p < size(); ++p)
+	{
+		m_tetAdjacencyOffsets[p + 1] += m_tetAdjacencyOffsets[p];
+	}
+
+	m_tetAdjacency.resize(m_tetAdjacencyOffsets.back());
+	std::vector<int> fillPosition(m_tetAdjacencyOffsets.begin(), m_tetAdjacencyOffsets.end() - 1);
+	for (int t = 0; t < tetrahedra.size(); ++t)
+	{
+		for (int v = 0; v < 4; ++v)
+		{
+			m_tetAdjacency[fillPosition[tetrahedra[t].getVertexIndices()[v]]++] = t;
+		}
+	}
+}
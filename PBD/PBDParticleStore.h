@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+#include <Eigen/Dense>
+
+class PBDParticle;
+class PBDTetrahedra3d;
+
+//Structure-of-arrays particle container: every particle state lives in its own contiguous array so the
+//integration sweeps only touch the data they need. Particle -> tetrahedra adjacency is stored in CSR form.
+class PBDParticleStore
+{
+public:
+	PBDParticleStore();
+	~PBDParticleStore();
+
+	size_t size() const { return m_positions.size(); }
+
+	void clear();
+
+	void reserve(int numParticles);
+
+	int addParticle(const Eigen::Vector3f& position, const Eigen::Vector3f& velocity, float inverseMass);
+
+	//lightweight handle, see PBDParticle
+	inline PBDParticle operator[](int idx);
+
+	Eigen::Vector3f& position(int idx) { return m_positions[idx]; }
+	const Eigen::Vector3f& position(int idx) const { return m_positions[idx]; }
+	Eigen::Vector3f& velocity(int idx) { return m_velocities[idx]; }
+
+	Eigen::Vector3f& previousPosition(int idx) { return m_previousPositions[idx]; }
+	const Eigen::Vector3f& previousPosition(int idx) const { return m_previousPositions[idx]; }
+	Eigen::Vector3f& previousVelocity(int idx) { return m_previousVelocities[idx]; }
+
+	Eigen::Vector3f& pastPosition(int idx) { return m_pastPositions[idx]; }
+
+	float& inverseMass(int idx) { return m_inverseMasses[idx]; }
+
+	std::vector<Eigen::Vector3f>& getPositions() { return m_positions; }
+	std::vector<Eigen::Vector3f>& getVelocities() { return m_velocities; }
+	std::vector<Eigen::Vector3f>& getPreviousPositions() { return m_previousPositions; }
+	const std::vector<Eigen::Vector3f>& getPreviousPositions() const { return m_previousPositions; }
+	std::vector<Eigen::Vector3f>& getPreviousVelocities() { return m_previousVelocities; }
+	std::vector<Eigen::Vector3f>& getPastPositions() { return m_pastPositions; }
+	std::vector<float>& getInverseMasses() { return m_inverseMasses; }
+
+	//past <- previous <- current positions and previous <- current velocities, all by pointer. The committed state is
+	//in the previous arrays afterwards; the current ones hold stale data until the next prediction overwrites them, so
+	//everything outside a solver step (rendering, output) reads the previous positions and velocities.
+	void swapStates();
+
+	//(Re)builds the particle -> tetrahedra adjacency; has to be called once the tetrahedra are set up
+	void initialiseTetAdjacency(const std::vector<PBDTetrahedra3d>& tetrahedra);
+
+	int getNumContainingTetrahedra(int idx) const { return m_tetAdjacencyOffsets[idx + 1] - m_tetAdjacencyOffsets[idx]; }
+
+	//data() + offset, as the offset is one past the end for trailing particles that belong to no tetrahedron (or before
+	//initialiseTetAdjacency)
+	const int* getContainingTetIdxs(int idx) const { return m_tetAdjacency.data() + m_tetAdjacencyOffsets[idx]; }
+
+private:
+	std::vector<Eigen::Vector3f> m_positions;
+	std::vector<Eigen::Vector3f> m_velocities;
+
+	std::vector<Eigen::Vector3f> m_previousPositions;
+	std::vector<Eigen::Vector3f> m_previousVelocities;
+
+	std::vector<Eigen::Vector3f> m_pastPositions;
+
+	std::vector<float> m_inverseMasses;
+
+	std::vector<int> m_tetAdjacencyOffsets;
+	std::vector<int> m_tetAdjacency;
+};
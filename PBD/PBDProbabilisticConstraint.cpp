@@ -14,7 +14,7 @@ PBDProbabilisticConstraint::~PBDProbabilisticConstraint()
 }
 
 void
-PBDProbabilisticConstraint::project(std::vector<PBDParticle>& particles)
+PBDProbabilisticConstraint::project(PBDParticleStore& particles)
 {
 	//correct particle positions (assuming that our current point is fixed
 	Eigen::Vector3f temp;
@@ -29,8 +29,8 @@ PBDProbabilisticConstraint::project(std::vector<PBDParticle>& particles)
 	Eigen::Vector3f p2;
 	for (int i = 0; i < m_particleInfluences.size(); ++i)
 	{
-		w2 = particles[m_particleInfluences[i]].inverseMass();
-		p2 = particles[m_particleInfluences[i]].position();
+		w2 = particles.inverseMass(m_particleInfluences[i]);
+		p2 = particles.position(m_particleInfluences[i]);
 
 		if ((p1 - p2).squaredNorm() <= m_initialDistances[i])
 		{
@@ -39,13 +39,13 @@ PBDProbabilisticConstraint::project(std::vector<PBDParticle>& particles)
 
 		solver.computeDeltaXPositionConstraint(w1, w2, m_initialDistances[i], p1, p2, temp, deltaX);
 
-		particles[m_particleInfluences[i]].position() += deltaX * w2;
+		particles.position(m_particleInfluences[i]) += deltaX * w2;
 	}
 }
 
 
 void
-PBDProbabilisticConstraint::initialise(std::vector<PBDParticle>& particles, float radius)
+PBDProbabilisticConstraint::initialise(PBDParticleStore& particles, float radius)
 {
 	m_initialRadius = radius;
 
@@ -53,7 +53,7 @@ PBDProbabilisticConstraint::initialise(std::vector<PBDParticle>& particles, floa
 	std::cout << m_constraintPosition << std::endl;
 	for (int p = 0; p < particles.size(); ++p)
 	{
-		float distance = (particles[p].position() - m_constraintPosition).squaredNorm();
+		float distance = (particles.position(p) - m_constraintPosition).squaredNorm();
 		//std::cout << distance << std::endl;
 		if (distance <= radius)
 		{
@@ -22,16 +22,21 @@ public:
 		return m_covariance;
 	}
 
-	void project(std::vector<PBDParticle>& particles);
+	void project(PBDParticleStore& particles);
 
-	void initialise(std::vector<PBDParticle>& particles, float radius);
+	void initialise(PBDParticleStore& particles, float radius);
 
 	Eigen::Vector3f& getConstraintPosition()
 	{
 		return m_constraintPosition;
 	}
 
-	float getInitialRadius()
+	const Eigen::Vector3f& getConstraintPosition() const
+	{
+		return m_constraintPosition;
+	}
+
+	float getInitialRadius() const
 	{
 		return m_initialRadius;
 	}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+
+#include <Eigen\Dense>
+
+//Residual of a constraint sweep: the length of the largest position correction applied during the sweep. The
+//kernels track it in a local instance and add it to the sweep's PBDProjectionResidualReduction once per range.
+struct PBDProjectionResidual
+{
+	PBDProjectionResidual() : maxSquaredCorrection(0.0f)
+	{
+	}
+
+	void add(const Eigen::Vector3f& deltaX)
+	{
+		maxSquaredCorrection = std::max(maxSquaredCorrection, deltaX.squaredNorm());
+	}
+
+	float maxSquaredCorrection;
+};
+
+//Maximum over all threads since the last reset.
+class PBDProjectionResidualReduction
+{
+public:
+	PBDProjectionResidualReduction()
+	{
+		reset();
+	}
+
+	void add(const PBDProjectionResidual& residual)
+	{
+		float current = m_maxSquaredCorrection;
+		while (residual.maxSquaredCorrection > current
+			&& !m_maxSquaredCorrection.compare_exchange_weak(current, residual.maxSquaredCorrection))
+		{
+			//'current' has been reloaded, try again
+		}
+	}
+
+	void reset()
+	{
+		m_maxSquaredCorrection = 0.0f;
+	}
+
+	float getMaxCorrection() const
+	{
+		return std::sqrt(m_maxSquaredCorrection.load());
+	}
+
+private:
+	std::atomic<float> m_maxSquaredCorrection;
+};
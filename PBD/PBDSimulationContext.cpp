@@ -0,0 +1,78 @@
+#include "PBDSimulationContext.h"
+
+#include "MeshCreator.h"
+
+PBDSimulationContext::PBDSimulationContext()
+{
+	m_settings.initialise();
+}
+
+
+PBDSimulationContext::~PBDSimulationContext()
+{
+}
+
+void
+PBDSimulationContext::resizeBuffers()
+{
+	m_state.temporaryPositions.resize(m_state.particles->size());
+	m_state.numConstraintInfluences.resize(m_state.particles->size());
+}
+
+void
+PBDSimulationContext::initialise(const PBDSolverSettings& settings)
+{
+	m_settings = settings;
+
+	resizeBuffers();
+
+	m_solver.initialiseTetrahedraColoring(*m_state.tetrahedra, *m_state.particles);
+	m_solver.initialiseTetRestStates(*m_state.tetrahedra, m_settings);
+}
+
+void
+PBDSimulationContext::initialiseFirstFrame(const PBDSolverSettings& settings)
+{
+	PBDSolverSettings firstFrameSettings = settings;
+	firstFrameSettings.currentFrame = 1;
+	firstFrameSettings.calculateLambda();
+	firstFrameSettings.calculateMu();
+	firstFrameSettings.calculateFiberStructureTensor();
+
+	initialise(firstFrameSettings);
+}
+
+void
+PBDSimulationContext::generateTetBar(int width, int height, int depth)
+{
+	m_state.tetrahedra = std::make_shared<std::vector<PBDTetrahedra3d> >();
+	m_state.particles = std::make_shared<PBDParticleStore>();
+
+	MeshCreator::generateTetBar(m_state.particles, *m_state.tetrahedra, width, height, depth);
+}
+
+void
+PBDSimulationContext::shareMesh(const PBDSimulationContext& other, const PBDSolverSettings& settings)
+{
+	m_settings = settings;
+
+	m_state.tetrahedra = other.m_state.tetrahedra;
+	m_state.particles = std::make_shared<PBDParticleStore>(*other.m_state.particles);
+
+	resizeBuffers();
+
+	m_solver.shareMeshData(other.m_solver, m_settings);
+}
+
+void
+PBDSimulationContext::step()
+{
+	if (m_state.temporaryPositions.size() != m_state.particles->size())
+	{
+		resizeBuffers();
+	}
+
+	m_solver.advanceSystem(m_state, m_settings);
+
+	++m_settings.currentFrame;
+}
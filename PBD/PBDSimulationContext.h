@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include <Eigen\Dense>
+
+#include "PBDSimulationState.h"
+#include "PBDSolver.h"
+#include "PBDSolverSettings.h"
+
+//One simulation: the tet mesh, the particle state, the colliders, the moving hard constraints, the solver settings and
+//the solver, advanced a frame at a time by step(). Contexts have no mutable state in common, so several of them can
+//live in one process and be stepped concurrently (see ParameterSweep). The mesh is set up through the accessors
+//(e.g. by doIO in AppHelper.h) before initialise.
+class PBDSimulationContext
+{
+public:
+	PBDSimulationContext();
+	~PBDSimulationContext();
+
+	//Takes the settings, sizes the solver buffers and builds the colouring and rest states of the mesh
+	void initialise(const PBDSolverSettings& settings);
+
+	//initialise starting at frame 1, with lambda, mu and the fibre structure tensor derived from the Young's modulus,
+	//Poisson ratio and fibre direction of 'settings'. For scenes set up in code, e.g. by the benchmarks.
+	void initialiseFirstFrame(const PBDSolverSettings& settings);
+
+	//Replaces the mesh by a generated tet bar (see MeshCreator::generateTetBar), the benchmarks' scene; initialise
+	//afterwards
+	void generateTetBar(int width, int height, int depth);
+
+	//Initialises the context on the mesh of 'other', which has to be initialised: the tetrahedra and the solver's rest
+	//states are shared, the particles are copied. Colliders, drivers and probabilistic constraints are not taken over.
+	//The tetrahedra read the positions of the particles of 'other', so the context needs the multi-threaded or the
+	//Jacobi solver.
+	void shareMesh(const PBDSimulationContext& other, const PBDSolverSettings& settings);
+
+	//Advances the solver by one frame (settings.numSubsteps substeps) and moves on to the next frame
+	void step();
+
+	int getCurrentFrame() const { return m_settings.currentFrame; }
+
+	//For frames not advanced by step(), e.g. by the FEM solver
+	void increaseCurrentFrame() { ++m_settings.currentFrame; }
+
+	PBDSimulationState& getState() { return m_state; }
+
+	std::vector<PBDTetrahedra3d>& getTetrahedra() { return *m_state.tetrahedra; }
+	const std::vector<PBDTetrahedra3d>& getTetrahedra() const { return *m_state.tetrahedra; }
+
+	std::shared_ptr<PBDParticleStore>& getParticles() { return m_state.particles; }
+	const PBDParticleStore& getParticleStore() const { return *m_state.particles; }
+
+	std::vector<PBDProbabilisticConstraint>& getProbabilisticConstraints() { return m_state.probabilisticConstraints; }
+
+	std::vector<CollisionMesh>& getCollisionGeometry() { return m_state.collisionGeometry; }
+	std::vector<CollisionRod>& getCollisionGeometry2() { return m_state.collisionGeometry2; }
+	std::vector<CollisionSphere>& getCollisionGeometry3() { return m_state.collisionGeometry3; }
+
+	std::vector<MovingHardConstraints>& getMovingConstraints() { return m_state.movingConstraints; }
+
+	PBDSolverSettings& getSettings() { return m_settings; }
+	const PBDSolverSettings& getSettings() const { return m_settings; }
+
+	PBDSolver& getSolver() { return m_solver; }
+	const PBDSolver& getSolver() const { return m_solver; }
+
+private:
+	//Sizes the solver's scratch buffers to the particles
+	void resizeBuffers();
+
+	PBDSimulationState m_state;
+
+	PBDSolverSettings m_settings;
+	PBDSolver m_solver;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include <Eigen\Dense>
+
+#include "PBDParticleStore.h"
+#include "PBDTetrahedra3d.h"
+#include "PBDProbabilisticConstraint.h"
+#include "CollisionMesh.h"
+#include "CollisionRod.h"
+#include "CollisionSphere.h"
+#include "MovingHardConstraints.h"
+
+//What PBDSolver::advanceSystem works on besides the solver's own data: the tet mesh, the particles, the colliders, the
+//moving hard constraints and the scratch buffers of the Jacobi solver. PBDSimulationContext owns one per simulation,
+//the coarse levels of PBDMultilevelHierarchy one each (mesh and particles only).
+struct PBDSimulationState
+{
+	PBDSimulationState()
+		: tetrahedra(std::make_shared<std::vector<PBDTetrahedra3d> >()), particles(std::make_shared<PBDParticleStore>())
+	{
+	}
+
+	//shared pointers: the tetrahedra hold on to the particles, and contexts on one mesh share the tetrahedra (see
+	//PBDSimulationContext::shareMesh)
+	std::shared_ptr<std::vector<PBDTetrahedra3d> > tetrahedra;
+	std::shared_ptr<PBDParticleStore> particles;
+
+	std::vector<Eigen::Vector3f> temporaryPositions;
+	std::vector<int> numConstraintInfluences;
+
+	std::vector<PBDProbabilisticConstraint> probabilisticConstraints;
+	std::vector<CollisionMesh> collisionGeometry;
+	std::vector<CollisionRod> collisionGeometry2;
+	std::vector<CollisionSphere> collisionGeometry3;
+	std::vector<MovingHardConstraints> movingConstraints;
+};
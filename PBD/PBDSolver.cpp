@@ -16,6 +16,8 @@
 PBDSolver::PBDSolver()
 {
 	m_currentFrame = 0;
+	m_numConstraintItsUsed = 0;
+	m_constraintResidual = 0.0f;
 }
 
 
@@ -24,25 +26,238 @@ PBDSolver::~PBDSolver()
 }
 
 void
-PBDSolver::advanceSystem(std::vector<PBDTetrahedra3d>& tetrahedra,
-std::shared_ptr<std::vector<PBDParticle>>& particles, PBDSolverSettings& settings,
-std::vector<Eigen::Vector3f>& temporaryPositions, std::vector<int>& numConstraintInfluences,
-std::vector<PBDProbabilisticConstraint>& probabilisticConstraints,
-std::vector<CollisionMesh>& collisionGeometry,
-std::vector<CollisionRod>& collisionGeometry2,
-std::vector<CollisionSphere>& collisionGeometry3)
+PBDSolver::initialiseTetrahedraColoring(std::vector<PBDTetrahedra3d>& tetrahedra,
+PBDParticleStore& particles)
 {
-	//Advance Velocities
-	advanceVelocities(tetrahedra, particles, settings);
+	m_tetColoring.colorTetrahedra(tetrahedra, particles.size());
+}
+
+void
+PBDSolver::printColoringStatistics() const
+{
+	m_tetColoring.printStatistics();
+
+	if (m_geometricConstraints.getNumEdges() > 0)
+	{
+		m_geometricConstraints.printStatistics();
+	}
+}
+
+void
+PBDSolver::initialiseTetRestStates(std::vector<PBDTetrahedra3d>& tetrahedra, const PBDSolverSettings& settings)
+{
+	m_tetRestStates.initialise(tetrahedra, settings);
+}
+
+void
+PBDSolver::shareMeshData(const PBDSolver& source, const PBDSolverSettings& settings)
+{
+	m_tetColoring = source.m_tetColoring;
+	m_tetRestStates.shareRestStates(source.m_tetRestStates, settings);
+}
+
+void
+PBDSolver::initialiseMultilevelHierarchy(std::vector<PBDTetrahedra3d>& tetrahedra,
+PBDParticleStore& particles, const PBDSolverSettings& settings)
+{
+	m_multilevelHierarchy.initialise(tetrahedra, particles, settings);
+}
+
+void
+PBDSolver::selectConstraintKernels(const PBDSolverSettings& settings, bool hasColliders)
+{
+	m_constraintKernels = PBDConstraintKernels::select(settings, hasColliders);
+}
+
+void
+PBDSolver::initialiseJacobiAdjacency(std::vector<PBDTetrahedra3d>& tetrahedra,
+PBDParticleStore& particles)
+{
+	m_jacobiDeltas.resize(tetrahedra.size() * 4);
+	m_jacobiIsCorrected.resize(tetrahedra.size() * 4);
+
+	m_jacobiAdjacencyOffsets.assign(particles.size() + 1, 0);
+	for (int t = 0; t < tetrahedra.size(); ++t)
+	{
+		for (int v = 0; v < 4; ++v)
+		{
+			++m_jacobiAdjacencyOffsets[tetrahedra[t].getVertexIndices()[v] + 1];
+		}
+	}
+	for (int p = 0; p < particles.size(); ++p)
+	{
+		m_jacobiAdjacencyOffsets[p + 1] += m_jacobiAdjacencyOffsets[p];
+	}
+
+	//slots are filled in ascending tet order, which fixes the summation order in the gather step
+	m_jacobiAdjacency.resize(tetrahedra.size() * 4);
+	std::vector<int> fillPosition(m_jacobiAdjacencyOffsets.begin(), m_jacobiAdjacencyOffsets.end() - 1);
+	for (int t = 0; t < tetrahedra.size(); ++t)
+	{
+		for (int v = 0; v < 4; ++v)
+		{
+			m_jacobiAdjacency[fillPosition[tetrahedra[t].getVertexIndices()[v]]++] = t * 4 + v;
+		}
+	}
+}
 
-	//Advance Positions
-	advancePositions(tetrahedra, particles, settings);
+void
+PBDSolver::advanceSystem(PBDSimulationState& state, PBDSolverSettings& settings)
+{
+	std::vector<PBDTetrahedra3d>& tetrahedra = *state.tetrahedra;
+	PBDParticleStore& particles = *state.particles;
 
-	processCollisions(tetrahedra, particles, settings, probabilisticConstraints, collisionGeometry,
-		collisionGeometry2, collisionGeometry3);
+	if (settings.numSubsteps < 1)
+	{
+		std::cout << "ERROR: numSubsteps has to be at least 1!" << std::endl;
+		return;
+	}
 
 	if (!settings.disableConstraintProjection)
 	{
+		if (m_tetRestStates.getNumTetrahedra() != tetrahedra.size()
+			|| (settings.usePerTetMaterialAttributes && !m_tetRestStates.hasMaterials()))
+		{
+			initialiseTetRestStates(tetrahedra, settings);
+		}
+		m_tetRestStates.initialiseViscoelasticState(settings);
+
+		if (settings.numCoarseLevels > 0 && !m_multilevelHierarchy.isInitialised(particles.size(), settings.numCoarseLevels))
+		{
+			initialiseMultilevelHierarchy(tetrahedra, particles, settings);
+		}
+
+		//the feature flags are fixed for the whole step, so the kernels are specialised for them once here
+		selectConstraintKernels(settings, !state.collisionGeometry3.empty());
+	}
+
+	m_numConstraintItsUsed = 0;
+
+	m_profiler.setEnabled(settings.enableProfiling);
+	m_profiler.beginFrame(settings.currentFrame, m_inversionCounters.getCounts());
+	const tbb::tick_count advanceStart = tbb::tick_count::now();
+
+	//The solver runs with the substep size, the drivers keep sampling their animation in frames of deltaT. Frame
+	//'currentFrame' covers (currentFrame - 1, currentFrame], i.e. a single substep samples the drivers at currentFrame.
+	const float frameDeltaT = settings.deltaT;
+	settings.deltaT = settings.getSubstepDeltaT();
+
+	for (int s = 0; s < settings.numSubsteps; ++s)
+	{
+		const float systemFrame = (float)(settings.currentFrame - 1) + (float)(s + 1) / (float)settings.numSubsteps;
+
+		updateMovingDrivers(state, systemFrame, frameDeltaT);
+
+		m_profiler.setSubstep(s);
+
+		advanceSubstep(state, settings);
+	}
+
+	settings.deltaT = frameDeltaT;
+
+	m_profiler.addPhase(PHASE_ADVANCE, advanceStart);
+	m_profiler.endFrame(m_inversionCounters.getCounts());
+
+	++m_currentFrame;
+}
+
+void
+PBDSolver::updateMovingDrivers(PBDSimulationState& state, float systemFrame, float frameDeltaT)
+{
+	PBDParticleStore& particles = *state.particles;
+	std::vector<CollisionSphere>& collisionGeometry3 = state.collisionGeometry3;
+	std::vector<MovingHardConstraints>& movingConstraints = state.movingConstraints;
+
+	for (int i = 0; i < movingConstraints.size(); ++i)
+	{
+		movingConstraints[i].updatePositions(particles, systemFrame, frameDeltaT, 0);
+		movingConstraints[i].updatePositions(particles, systemFrame, frameDeltaT, 1);
+	}
+
+	for (int c = 0; c < collisionGeometry3.size(); ++c)
+	{
+		collisionGeometry3[c].calculateNewSphereCentre(systemFrame, frameDeltaT);
+	}
+}
+
+bool
+PBDSolver::isSleepingEnabled(const PBDSolverSettings& settings) const
+{
+	return settings.useSleeping && (settings.useJacobiSolver || settings.useMultiThreadedSolver);
+}
+
+void
+PBDSolver::projectGeometricConstraints(std::vector<PBDTetrahedra3d>& tetrahedra,
+PBDParticleStore& particles, const PBDSolverSettings& settings, bool skipSleeping)
+{
+	if (!settings.useDistanceConstraints && !settings.useVolumeConstraints)
+	{
+		return;
+	}
+
+	if (!m_geometricConstraints.isInitialised(particles.size(), tetrahedra.size()))
+	{
+		m_geometricConstraints.initialise(tetrahedra, particles.size());
+	}
+
+	const std::vector<char>* isSimulated = skipSleeping ? &m_activityTracker.getSimulatedParticleFlags() : NULL;
+
+	if (settings.useDistanceConstraints)
+	{
+		m_geometricConstraints.projectDistanceConstraints(particles,
+			PBDGeometricConstraints::getStiffnessMultiplier(settings.distanceConstraintStiffness, settings.numConstraintIts),
+			isSimulated, m_residualReduction);
+	}
+
+	if (settings.useVolumeConstraints)
+	{
+		m_geometricConstraints.projectVolumeConstraints(particles,
+			PBDGeometricConstraints::getStiffnessMultiplier(settings.volumeConstraintStiffness, settings.numConstraintIts),
+			isSimulated, m_residualReduction);
+	}
+
+	if (skipSleeping)
+	{
+		m_activityTracker.holdBoundaryParticles(particles);
+	}
+}
+
+bool
+PBDSolver::finishConstraintIteration(const PBDSolverSettings& settings, int iteration, const tbb::tick_count& iterationStart)
+{
+	++m_numConstraintItsUsed;
+	m_constraintResidual = m_residualReduction.getMaxCorrection();
+
+	m_profiler.addPhase(PHASE_PROJECTION_ITERATION, iterationStart, iteration);
+
+	return settings.constraintTolerance > 0.0f && m_constraintResidual < settings.constraintTolerance;
+}
+
+void
+PBDSolver::advanceSubstep(PBDSimulationState& state, PBDSolverSettings& settings)
+{
+	std::vector<PBDTetrahedra3d>& tetrahedra = *state.tetrahedra;
+	PBDParticleStore& particles = *state.particles;
+
+	if (isSleepingEnabled(settings))
+	{
+		m_activityTracker.beginStep(particles, tetrahedra, state.collisionGeometry3, settings);
+	}
+
+	//Advance Velocities and Positions
+	tbb::tick_count phaseStart = tbb::tick_count::now();
+	predictPositions(particles, settings);
+	m_profiler.addPhase(PHASE_PREDICT, phaseStart);
+
+	phaseStart = tbb::tick_count::now();
+	processCollisions(state, settings);
+	m_profiler.addPhase(PHASE_COLLISIONS, phaseStart);
+
+	if (!settings.disableConstraintProjection)
+	{
+		phaseStart = tbb::tick_count::now();
+		m_tetRestStates.resetLagrangeMultipliers(settings);
+
 		//Project Constraints
 		//if (!settings.useSOR)
 		//{
@@ -58,124 +273,147 @@ std::vector<CollisionSphere>& collisionGeometry3)
 		//projectConstraintsDistance(tetrahedra, particles, settings.numConstraintIts, settings.youngsModulus);
 		//projectConstraintsGeometricInversionHandling(tetrahedra, particles, settings);
 		//projectConstraintsVolume(tetrahedra, particles, settings.numConstraintIts, settings.youngsModulus);
-		if (settings.useMultiThreadedSolver)
+		if ((settings.useJacobiSolver || settings.useMultiThreadedSolver) && !m_constraintKernels.isValid())
+		{
+			std::cout << "ERROR: No constraint kernel for the selected material model!" << std::endl;
+		}
+		else if (settings.useJacobiSolver)
+		{
+			projectConstraintsVISCOELASTIC_JACOBI(state, settings);
+		}
+		else if (settings.useMultiThreadedSolver)
 		{
-			projectConstraintsVISCOELASTIC_MULTI(tetrahedra, particles, settings, probabilisticConstraints, collisionGeometry,
-				collisionGeometry2, collisionGeometry3);
+			projectConstraintsVISCOELASTIC_MULTI(state, settings);
 		}
 		else
 		{
-			projectConstraintsVISCOELASTIC(tetrahedra, particles, settings, probabilisticConstraints, collisionGeometry,
-				collisionGeometry2, collisionGeometry3);
+			projectConstraintsVISCOELASTIC(state, settings);
+			m_numConstraintItsUsed += settings.numConstraintIts;
 		}
+		m_profiler.addPhase(PHASE_PROJECTION, phaseStart);
 	}
 
 	//processCollisions(tetrahedra, particles, settings, temporaryPositions, numConstraintInfluences, probabilisticConstraints, collisionGeometry,
 	//	collisionGeometry2, collisionGeometry3);
 
-	//Update Velocities
-	updateVelocities(tetrahedra, particles, settings);
+	//Update Velocities and swap particles states
+	phaseStart = tbb::tick_count::now();
+	updateVelocitiesAndSwapStates(particles, settings);
+	m_profiler.addPhase(PHASE_VELOCITY_UPDATE_AND_SWAP, phaseStart);
 
-	//swap particles states
-	for (auto& p : *particles)
+	if (isSleepingEnabled(settings))
 	{
-		//std::cout << p.previousPosition() - p.position() << std::endl;
-		p.swapStates();
+		m_activityTracker.endStep(particles, settings);
 	}
-
-	++m_currentFrame;
 }
 
 
 void
-PBDSolver::advanceVelocities(std::vector<PBDTetrahedra3d>& tetrahedra,
-std::shared_ptr<std::vector<PBDParticle>>& particles, PBDSolverSettings& settings)
+PBDSolver::predictPositions(PBDParticleStore& particles, const PBDSolverSettings& settings)
 {
-	for (auto& p : *particles)
-	{
-		//gravity
-		float temp = settings.deltaT * p.inverseMass() * settings.gravity;
-		p.velocity().x() = p.previousVelocity().x() + 0;
-		p.velocity().y() = p.previousVelocity().y() + temp;
-		p.velocity().z() = p.previousVelocity().z() + 0;
-
-		//other external forces
-		p.velocity() += settings.deltaT * settings.forceMultiplicationFactor * settings.externalForce;
-	}
-}
+	std::vector<Eigen::Vector3f>& positions = particles.getPositions();
+	std::vector<Eigen::Vector3f>& previousPositions = particles.getPreviousPositions();
+	std::vector<Eigen::Vector3f>& velocities = particles.getVelocities();
+	std::vector<Eigen::Vector3f>& previousVelocities = particles.getPreviousVelocities();
+	std::vector<float>& inverseMasses = particles.getInverseMasses();
 
-void
-PBDSolver::advancePositions(std::vector<PBDTetrahedra3d>& tetrahedra,
-std::shared_ptr<std::vector<PBDParticle>>& particles, PBDSolverSettings& settings)
-{
-	//if (!settings.useSecondOrderUpdates)
-	//if (true)
-	//{
-	//	Eigen::Vector3f gravityVector(0.0f, settings.gravity, 0.0f);
-	//	for (auto& p : *particles)
-	//	{
-	//		if (p.inverseMass() != 0.0f)
-	//		{
-	//			p.position() = p.previousPosition() + settings.deltaT * p.velocity() + std::powf(settings.deltaT, 1.0f) * p.inverseMass() * gravityVector;
-	//			//std::cout << p.velocity().transpose() << std::endl;
-	//		}
-	//	}
-	//}
-	//else
-	//{
-	//	Eigen::Vector3f gravityVector(0.0f, settings.gravity, 0.0f);
-	//	for (auto& p : *particles)
-	//	{
-	//		p.position() = (4.0f / 3.0f) * p.position()
-	//			- (1.0f / 3.0f) * p.previousPosition()
-	//			+ (8.0f / 9.0f) * settings.deltaT * p.velocity()
-	//			- (2.0f / 9.0f) * settings.deltaT * p.previousPosition()
-	//			+ (4.0f / 9.0f) * std::powf(settings.deltaT, 2.0f) * p.inverseMass() * gravityVector;
-	//		//std::cout << p.velocity().transpose() << std::endl;
-	//	}
-	//}
-	for (auto& p : *particles)
+	const Eigen::Vector3f externalVelocity = settings.deltaT * settings.forceMultiplicationFactor * settings.externalForce;
+
+	const bool skipSleeping = isSleepingEnabled(settings);
+	const std::vector<char>& isSimulated = m_activityTracker.getSimulatedParticleFlags();
+
+	const bool warmStart = settings.useWarmStarting && m_warmStartCorrections.size() == particles.size();
+
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, particles.size()), [&](const tbb::blocked_range<size_t>& r)
 	{
-		p.position() = p.previousPosition() + settings.deltaT * p.velocity();
+		for (size_t p = r.begin(); p != r.end(); ++p)
+		{
+			//the current state is stale after the last swap, sleeping particles carry over the committed one
+			if (skipSleeping && !isSimulated[p])
+			{
+				positions[p] = previousPositions[p];
+				velocities[p] = previousVelocities[p];
+				continue;
+			}
 
-	}
+			//gravity
+			float temp = settings.deltaT * inverseMasses[p] * settings.gravity;
+			velocities[p].x() = previousVelocities[p].x() + 0;
+			velocities[p].y() = previousVelocities[p].y() + temp;
+			velocities[p].z() = previousVelocities[p].z() + 0;
 
-	//if (settings.currentFrame == 1)
-	//{
-	//	for (auto& p : *particles)
-	//	{
-	//		Eigen::Vector3f temp(0.0f, 1.5f, 0.0f);
-	//		//p.position() += settings.deltaT * settings.positionDeltaMultiplicationFactor * settings.externalPositionDelta;
-	//		//p.position() += settings.getCurrentTime() * settings.positionDeltaMultiplicationFactor * settings.externalPositionDelta;
-	//		p.position() = temp;
-	//		//std::cout << p.velocity().transpose() << std::endl;
-	//	}
-	//}
+			//other external forces
+			velocities[p] += externalVelocity;
+
+			positions[p] = previousPositions[p] + settings.deltaT * velocities[p];
+
+			if (warmStart)
+			{
+				positions[p] += settings.warmStartDecay * m_warmStartCorrections[p];
+			}
+		}
+	});
 }
 
 void
-PBDSolver::updateVelocities(std::vector<PBDTetrahedra3d>& tetrahedra,
-std::shared_ptr<std::vector<PBDParticle>>& particles, const PBDSolverSettings& settings)
+PBDSolver::updateVelocitiesAndSwapStates(PBDParticleStore& particles, const PBDSolverSettings& settings)
 {
-	if (!settings.useSecondOrderUpdates)
+	std::vector<Eigen::Vector3f>& positions = particles.getPositions();
+	std::vector<Eigen::Vector3f>& previousPositions = particles.getPreviousPositions();
+	std::vector<Eigen::Vector3f>& pastPositions = particles.getPastPositions();
+	std::vector<Eigen::Vector3f>& velocities = particles.getVelocities();
+
+	std::vector<float>& inverseMasses = particles.getInverseMasses();
+
+	const bool skipSleeping = isSleepingEnabled(settings);
+	const std::vector<char>& isSimulated = m_activityTracker.getSimulatedParticleFlags();
+
+	if (!settings.useWarmStarting)
 	{
-		for (auto& p : *particles)
-		{
-			p.velocity() = (1.0 / settings.deltaT) * (p.position() - p.previousPosition());
-		}
+		m_warmStartCorrections.clear();
 	}
-	else
+	else if (m_warmStartCorrections.size() != particles.size())
+	{
+		m_warmStartCorrections.assign(particles.size(), Eigen::Vector3f::Zero());
+	}
+
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, particles.size()), [&](const tbb::blocked_range<size_t>& r)
 	{
-		for (auto& p : *particles)
+		for (size_t p = r.begin(); p != r.end(); ++p)
 		{
-			p.velocity() = (1.0 / settings.deltaT) * ((3.0f / 2.0f) * p.position() - 2.0f * p.previousPosition() + 0.5f * p.pastPosition());
+			if (settings.useWarmStarting)
+			{
+				//the velocities are still the predicted ones; the drivers' (inverse mass 0) positions stay untouched
+				if ((!skipSleeping || isSimulated[p]) && inverseMasses[p] != 0.0f)
+				{
+					m_warmStartCorrections[p] = positions[p] - (previousPositions[p] + settings.deltaT * velocities[p]);
+				}
+				else
+				{
+					m_warmStartCorrections[p].setZero();
+				}
+			}
+
+			if (!skipSleeping || isSimulated[p])
+			{
+				if (!settings.useSecondOrderUpdates)
+				{
+					velocities[p] = (1.0 / settings.deltaT) * (positions[p] - previousPositions[p]);
+				}
+				else
+				{
+					velocities[p] = (1.0 / settings.deltaT) * ((3.0f / 2.0f) * positions[p] - 2.0f * previousPositions[p] + 0.5f * pastPositions[p]);
+				}
+			}
 		}
-	}
+	});
+
+	particles.swapStates();
 }
 
 float
 PBDSolver::calculateTotalStrainEnergy(std::vector<PBDTetrahedra3d>& tetrahedra,
-std::shared_ptr<std::vector<PBDParticle>>& particles, const PBDSolverSettings& settings, int it,
+PBDParticleStore& particles, const PBDSolverSettings& settings, int it,
 std::ofstream& file)
 {
 	Eigen::Matrix3f F;
@@ -437,419 +675,385 @@ const PBDSolverSettings& settings)
 
 void
 PBDSolver::projectConstraintsDistance(std::vector<PBDTetrahedra3d>& tetrahedra,
-std::shared_ptr<std::vector<PBDParticle>>& particles, int numIterations, float k)
+PBDParticleStore& particles, int numIterations, float k)
 {
-	float w1;
-	float w2;
-	float restDistance;
-
-	Eigen::Vector3f x1;
-	Eigen::Vector3f x2;
-
-	Eigen::Vector3f deltaX;
-
-	Eigen::Vector3f temp;
-
-	float stiffnessMultiplier;
+	if (!m_geometricConstraints.isInitialised(particles.size(), tetrahedra.size()))
+	{
+		m_geometricConstraints.initialise(tetrahedra, particles.size());
+	}
 
+	const float stiffnessMultiplier = PBDGeometricConstraints::getStiffnessMultiplier(k, numIterations);
 
-	if (k == 1.0f)
+	for (int it = 0; it < numIterations; ++it)
 	{
-		stiffnessMultiplier = 1.0f;
+		m_residualReduction.reset();
+		m_geometricConstraints.projectDistanceConstraints(particles, stiffnessMultiplier, NULL, m_residualReduction);
 	}
-	else
+}
+
+void
+PBDSolver::projectConstraintsVolume(std::vector<PBDTetrahedra3d>& tetrahedra,
+PBDParticleStore& particles, int numIterations, float k)
+{
+	if (!m_geometricConstraints.isInitialised(particles.size(), tetrahedra.size()))
 	{
-		if (k > 1.0f)
-		{
-			stiffnessMultiplier = 1.0f;
-		}
-		else
-		{
-			stiffnessMultiplier = 1.0f - std::pow((1.0f - k), 1.0f / (float)numIterations);
-		}
+		m_geometricConstraints.initialise(tetrahedra, particles.size());
 	}
 
+	const float stiffnessMultiplier = PBDGeometricConstraints::getStiffnessMultiplier(k, numIterations);
 
+	//'k' only softens the edges, the volumes are enforced fully
 	for (int it = 0; it < numIterations; ++it)
 	{
-		for (int t = 0; t < tetrahedra.size(); ++t)
-		{
-			w1 = tetrahedra[t].get_x(0).inverseMass();
-			x1 = tetrahedra[t].get_x(0).position();
-
-			w2 = tetrahedra[t].get_x(2).inverseMass();
-			x2 = tetrahedra[t].get_x(2).position();
-			computeDeltaXPositionConstraint(w1, w2, tetrahedra[t].getUndeformedSideLength(0),
-				x1, x2, temp, deltaX);
-			tetrahedra[t].get_x(0).position() += -deltaX * w1 * stiffnessMultiplier;
-			tetrahedra[t].get_x(2).position() += deltaX * w2 * stiffnessMultiplier;
-
-			w2 = tetrahedra[t].get_x(3).inverseMass();
-			x2 = tetrahedra[t].get_x(3).position();
-			computeDeltaXPositionConstraint(w1, w2, tetrahedra[t].getUndeformedSideLength(1),
-				x1, x2, temp, deltaX);
-			tetrahedra[t].get_x(0).position() += -deltaX * w1 * stiffnessMultiplier;
-			tetrahedra[t].get_x(3).position() += deltaX * w2 * stiffnessMultiplier;
-
-			w2 = tetrahedra[t].get_x(1).inverseMass();
-			x2 = tetrahedra[t].get_x(1).position();
-			computeDeltaXPositionConstraint(w1, w2, tetrahedra[t].getUndeformedSideLength(2),
-				x1, x2, temp, deltaX);
-			tetrahedra[t].get_x(0).position() += -deltaX * w1 * stiffnessMultiplier;
-			tetrahedra[t].get_x(1).position() += deltaX * w2 * stiffnessMultiplier;
-
-			//---------------------------------------------------
-
-			w1 = tetrahedra[t].get_x(2).inverseMass();
-			x1 = tetrahedra[t].get_x(2).position();
-
-			w2 = tetrahedra[t].get_x(3).inverseMass();
-			x2 = tetrahedra[t].get_x(3).position();
-			computeDeltaXPositionConstraint(w1, w2, tetrahedra[t].getUndeformedSideLength(3),
-				x1, x2, temp, deltaX);
-			tetrahedra[t].get_x(2).position() += -deltaX * w1 * stiffnessMultiplier;
-			tetrahedra[t].get_x(3).position() += deltaX * w2 * stiffnessMultiplier;
-
-
-			w2 = tetrahedra[t].get_x(1).inverseMass();
-			x2 = tetrahedra[t].get_x(1).position();
-			computeDeltaXPositionConstraint(w1, w2, tetrahedra[t].getUndeformedSideLength(4),
-				x1, x2, temp, deltaX);
-			tetrahedra[t].get_x(2).position() += -deltaX * w1 * stiffnessMultiplier;
-			tetrahedra[t].get_x(1).position() += deltaX * w2 * stiffnessMultiplier;
-
-			//---------------------------------------------------
-
-			w1 = tetrahedra[t].get_x(3).inverseMass();
-			x1 = tetrahedra[t].get_x(3).position();
-
-			w2 = tetrahedra[t].get_x(1).inverseMass();
-			x2 = tetrahedra[t].get_x(1).position();
-			computeDeltaXPositionConstraint(w1, w2, tetrahedra[t].getUndeformedSideLength(5),
-				x1, x2, temp, deltaX);
-			tetrahedra[t].get_x(3).position() += -deltaX * w1 * stiffnessMultiplier;
-			tetrahedra[t].get_x(1).position() += deltaX * w2 * stiffnessMultiplier;
-		}
+		m_residualReduction.reset();
+		m_geometricConstraints.projectDistanceConstraints(particles, stiffnessMultiplier, NULL, m_residualReduction);
+		m_geometricConstraints.projectVolumeConstraints(particles, 1.0f, NULL, m_residualReduction);
 	}
-
 }
 
 
-bool solveVolumeConstraint(
-	const Eigen::Vector3f &p0, float invMass0,
-	const Eigen::Vector3f &p1, float invMass1,
-	const Eigen::Vector3f &p2, float invMass2,
-	const Eigen::Vector3f &p3, float invMass3,
-	const float restVolume,
-	const float negVolumeStiffness,
-	const float posVolumeStiffness,
-	Eigen::Vector3f &corr0, Eigen::Vector3f &corr1, Eigen::Vector3f &corr2, Eigen::Vector3f &corr3);
-
 void
-PBDSolver::projectConstraintsVolume(std::vector<PBDTetrahedra3d>& tetrahedra,
-std::shared_ptr<std::vector<PBDParticle>>& particles, int numIterations, float k)
+PBDSolver::projectConstraintsVISCOELASTIC_MULTI(PBDSimulationState& state, PBDSolverSettings& settings)
 {
-	float w1;
-	float w2;
-	float restDistance;
+	std::vector<PBDTetrahedra3d>& tetrahedra = *state.tetrahedra;
+	PBDParticleStore& particles = *state.particles;
 
-	Eigen::Vector3f x1;
-	Eigen::Vector3f x2;
+	if (!m_tetColoring.isInitialised() || m_tetColoring.getNumConstraints() != tetrahedra.size())
+	{
+		initialiseTetrahedraColoring(tetrahedra, particles);
+	}
 
-	Eigen::Vector3f deltaX;
+	//keep the ranges large enough to fill whole SIMD batches
+	const size_t grainSize = m_constraintKernels.numLanes > 1 ? 2 * m_constraintKernels.numLanes : 1;
 
-	Eigen::Vector3f temp;
-	float stiffnessMultiplier;
+	//deterministic mode: blocks of whole batches
+	const size_t deterministicBlockSize = std::max(1, settings.deterministicBlockSize / m_constraintKernels.numLanes)
+		* m_constraintKernels.numLanes;
 
-	if (k == 1.0f)
+	const bool skipSleeping = isSleepingEnabled(settings);
+	if (skipSleeping)
 	{
-		stiffnessMultiplier = 1.0f;
+		m_activityTracker.filterColoring(m_tetColoring);
 	}
-	else
+
+	if (settings.numCoarseLevels > 0)
 	{
-		if (k > 1.0f)
-		{
-			stiffnessMultiplier = 1.0f;
-		}
-		else
-		{
-			stiffnessMultiplier = 1.0f - std::pow((1.0f - k), 1.0f / (float)numIterations);
-		}
+		m_multilevelHierarchy.projectCoarseLevels(particles, settings,
+			skipSleeping ? &m_activityTracker.getSimulatedParticleFlags() : NULL);
 	}
 
-	std::vector<int> idxs = { 0, 1, 2, 3 };
+	if (settings.useChebyshevAcceleration)
+	{
+		m_chebyshevAcceleration.begin(particles, settings);
+	}
 
-	for (int it = 0; it < numIterations; ++it)
+	if (settings.useSOR)
 	{
-		for (int t = 0; t < tetrahedra.size(); ++t)
+		m_overRelaxation.begin(settings);
+	}
+
+	for (int it = 0; it < settings.numConstraintIts; ++it)
+	{
+		const tbb::tick_count iterationStart = tbb::tick_count::now();
+		m_residualReduction.reset();
+
+		const bool overRelax = settings.useSOR && m_overRelaxation.getOmega() != 1.0f;
+
+		//colours are processed one after the other, the tets within a colour in parallel
+		for (int c = 0; c < m_tetColoring.getNumColors(); ++c)
 		{
+			const std::vector<int>& colorTetIdxs = skipSleeping ? m_activityTracker.getActiveColor(c) : m_tetColoring.getColor(c);
+
+			if (overRelax)
+			{
+				m_overRelaxation.saveColor(colorTetIdxs, m_tetRestStates, particles, settings);
+			}
 
-			w1 = tetrahedra[t].get_x(0).inverseMass();
-			x1 = tetrahedra[t].get_x(0).position();
-
-			w2 = tetrahedra[t].get_x(2).inverseMass();
-			x2 = tetrahedra[t].get_x(2).position();
-			computeDeltaXPositionConstraint(w1, w2, tetrahedra[t].getUndeformedSideLength(0),
-				x1, x2, temp, deltaX);
-			tetrahedra[t].get_x(0).position() += -deltaX * w1 * stiffnessMultiplier;
-			tetrahedra[t].get_x(2).position() += deltaX * w2 * stiffnessMultiplier;
-
-			w2 = tetrahedra[t].get_x(3).inverseMass();
-			x2 = tetrahedra[t].get_x(3).position();
-			computeDeltaXPositionConstraint(w1, w2, tetrahedra[t].getUndeformedSideLength(1),
-				x1, x2, temp, deltaX);
-			tetrahedra[t].get_x(0).position() += -deltaX * w1 * stiffnessMultiplier;
-			tetrahedra[t].get_x(3).position() += deltaX * w2 * stiffnessMultiplier;
-
-			w2 = tetrahedra[t].get_x(1).inverseMass();
-			x2 = tetrahedra[t].get_x(1).position();
-			computeDeltaXPositionConstraint(w1, w2, tetrahedra[t].getUndeformedSideLength(2),
-				x1, x2, temp, deltaX);
-			tetrahedra[t].get_x(0).position() += -deltaX * w1 * stiffnessMultiplier;
-			tetrahedra[t].get_x(1).position() += deltaX * w2 * stiffnessMultiplier;
-
-			//---------------------------------------------------
-
-			w1 = tetrahedra[t].get_x(2).inverseMass();
-			x1 = tetrahedra[t].get_x(2).position();
-
-			w2 = tetrahedra[t].get_x(3).inverseMass();
-			x2 = tetrahedra[t].get_x(3).position();
-			computeDeltaXPositionConstraint(w1, w2, tetrahedra[t].getUndeformedSideLength(3),
-				x1, x2, temp, deltaX);
-			tetrahedra[t].get_x(2).position() += -deltaX * w1 * stiffnessMultiplier;
-			tetrahedra[t].get_x(3).position() += deltaX * w2 * stiffnessMultiplier;
-
-
-			w2 = tetrahedra[t].get_x(1).inverseMass();
-			x2 = tetrahedra[t].get_x(1).position();
-			computeDeltaXPositionConstraint(w1, w2, tetrahedra[t].getUndeformedSideLength(4),
-				x1, x2, temp, deltaX);
-			tetrahedra[t].get_x(2).position() += -deltaX * w1 * stiffnessMultiplier;
-			tetrahedra[t].get_x(1).position() += deltaX * w2 * stiffnessMultiplier;
-
-			//---------------------------------------------------
-
-			w1 = tetrahedra[t].get_x(3).inverseMass();
-			x1 = tetrahedra[t].get_x(3).position();
-
-			w2 = tetrahedra[t].get_x(1).inverseMass();
-			x2 = tetrahedra[t].get_x(1).position();
-			computeDeltaXPositionConstraint(w1, w2, tetrahedra[t].getUndeformedSideLength(5),
-				x1, x2, temp, deltaX);
-			tetrahedra[t].get_x(3).position() += -deltaX * w1 * stiffnessMultiplier;
-			tetrahedra[t].get_x(1).position() += deltaX * w2 * stiffnessMultiplier;
+			const PBDSolverTBB projectColor(m_tetRestStates, particles, settings, state.collisionGeometry3, colorTetIdxs,
+				m_constraintKernels, m_inversionCounters, m_residualReduction);
+
+			if (settings.useDeterministicParallelism)
+			{
+				//the blocks start at multiples of the batch size, so every tet is evaluated in the same batch (and takes the
+				//same inversion handling path) whichever thread runs it
+				const size_t numBlocks = (colorTetIdxs.size() + deterministicBlockSize - 1) / deterministicBlockSize;
+				tbb::parallel_for(tbb::blocked_range<size_t>(0, numBlocks, 1), [&](const tbb::blocked_range<size_t>& r)
+				{
+					projectColor(tbb::blocked_range<size_t>(r.begin() * deterministicBlockSize,
+						std::min(r.end() * deterministicBlockSize, colorTetIdxs.size())));
+				},
+					tbb::simple_partitioner());
+			}
+			else
+			{
+				tbb::parallel_for(tbb::blocked_range<size_t>(0, colorTetIdxs.size(), grainSize), projectColor, tbb::auto_partitioner());
+			}
+
+			if (overRelax)
+			{
+				m_overRelaxation.relaxColor(colorTetIdxs, m_tetRestStates, particles, state.collisionGeometry3, settings);
+			}
+
+			if (skipSleeping)
+			{
+				m_activityTracker.holdBoundaryParticles(particles);
+			}
 		}
 
-		for (int t = 0; t < tetrahedra.size(); ++t)
+		projectGeometricConstraints(tetrahedra, particles, settings, skipSleeping);
+
+		if (settings.useSOR)
+		{
+			m_overRelaxation.endSweep(m_residualReduction.getMaxCorrection(), settings);
+		}
+
+		if (settings.useChebyshevAcceleration)
+		{
+			m_chebyshevAcceleration.apply(particles, settings);
+		}
+
+		if (settings.enableGroundPlaneCollision)
 		{
-			//if (std::abs(tetrahedra[t].getVolume() - tetrahedra[t].getUndeformedVolume()) < 1e-12f)
-			//{
-			//	continue;
-			//}
-
-			Eigen::Vector3f	 corr0;
-			Eigen::Vector3f	 corr1;
-			Eigen::Vector3f	 corr2;
-			Eigen::Vector3f	 corr3;
-
-			Eigen::Vector3f p0 = tetrahedra[t].get_x(0).position();
-			Eigen::Vector3f p1 = tetrahedra[t].get_x(1).position();
-			Eigen::Vector3f p2 = tetrahedra[t].get_x(2).position();
-			Eigen::Vector3f p3 = tetrahedra[t].get_x(3).position();
-
-			float m1 = tetrahedra[t].get_x(0).inverseMass();
-			float m2 = tetrahedra[t].get_x(1).inverseMass();
-			float m3 = tetrahedra[t].get_x(2).inverseMass();
-			float m4 = tetrahedra[t].get_x(3).inverseMass();
-
-			//m1 = 1.0f;
-			//m2 = 1.0f;
-			//m3 = 1.0f;
-			//m4 = 1.0f;
-
-			if (solveVolumeConstraint(p0, m1, p1, m2, p2, m3, p3, m4, tetrahedra[t].getUndeformedVolumeAlternative(),
-				1.0f,
-				1.0f,
-				corr0, corr1, corr2, corr3))
+			for (int p = 0; p < particles.size(); ++p)
 			{
-				if (m1 != 0.0f)
-				{
-					tetrahedra[t].get_x(0).position() += corr0;
-					//std::cout << corr0 << std::endl;
-				}
-				if (m2 != 0.0f)
-				{
-					tetrahedra[t].get_x(1).position() += corr1;
-				}
-				if (m3 != 0.0f)
-				{
-					tetrahedra[t].get_x(2).position() += corr2;
-				}
-				if (m4 != 0.0f)
+				if (particles.position(p)[1] < settings.groundplaneHeight)
 				{
-					tetrahedra[t].get_x(3).position() += corr3;
+					particles.position(p)[1] = settings.groundplaneHeight;
 				}
 			}
 		}
+
+		if (finishConstraintIteration(settings, it, iterationStart))
+		{
+			break;
+		}
+
+		//COLLISION HANDLING
+		//for (int c = 0; c < collisionGeometry.size(); ++c)
+		//{
+		//	collisionGeometry[c].resolveParticleCollisions(particles);
+		//}
+
+		//for (int c = 0; c < collisionGeometry2.size(); ++c)
+		//{
+		//	collisionGeometry2[c].resolveParticleCollisions(particles, settings.currentFrame, settings.deltaT,
+		//		settings.collisionSpheresNum[c], settings.collisionSpheresRadius[c]);
+		//}
+
+		//if (it == settings.numConstraintIts % 2 != 0)
+		//{
+		//	processCollisions(tetrahedra, particles, settings, probabilisticConstraints, collisionGeometry, collisionGeometry2, collisionGeometry3);
+		//}
 	}
-}
 
+	//processCollisions(tetrahedra, particles, settings, probabilisticConstraints, collisionGeometry, collisionGeometry2, collisionGeometry3);
+}
 
-bool solveVolumeConstraint(
-	const Eigen::Vector3f &p0, float invMass0,
-	const Eigen::Vector3f &p1, float invMass1,
-	const Eigen::Vector3f &p2, float invMass2,
-	const Eigen::Vector3f &p3, float invMass3,
-	const float restVolume,
-	const float negVolumeStiffness,
-	const float posVolumeStiffness,
-	Eigen::Vector3f &corr0, Eigen::Vector3f &corr1, Eigen::Vector3f &corr2, Eigen::Vector3f &corr3)
+void
+PBDSolver::projectConstraintsVISCOELASTIC_JACOBI(PBDSimulationState& state, PBDSolverSettings& settings)
 {
-	float volume = 1.0f / 6.0f * (p1 - p0).cross(p2 - p0).dot(p3 - p0);
+	std::vector<PBDTetrahedra3d>& tetrahedra = *state.tetrahedra;
+	PBDParticleStore& particles = *state.particles;
+	std::vector<Eigen::Vector3f>& temporaryPositions = state.temporaryPositions;
+	std::vector<int>& numConstraintInfluences = state.numConstraintInfluences;
 
-	//if (volume == restVolume)
-	//{
-	//	return false;
-	//}
+	if (m_jacobiDeltas.size() != tetrahedra.size() * 4 || m_jacobiAdjacencyOffsets.size() != particles.size() + 1)
+	{
+		initialiseJacobiAdjacency(tetrahedra, particles);
+	}
+
+	temporaryPositions.resize(particles.size());
+	numConstraintInfluences.resize(particles.size());
+
+	if (settings.useXPBD)
+	{
+		m_jacobiLagrangeMultipliers.resize(tetrahedra.size());
+	}
+
+	const bool skipSleeping = isSleepingEnabled(settings);
+	const std::vector<char>& isSimulated = m_activityTracker.getSimulatedParticleFlags();
 
+	if (settings.numCoarseLevels > 0)
+	{
+		m_multilevelHierarchy.projectCoarseLevels(particles, settings, skipSleeping ? &isSimulated : NULL);
+	}
+
+	if (settings.useChebyshevAcceleration)
+	{
+		m_chebyshevAcceleration.begin(particles, settings);
+	}
+
+	for (int it = 0; it < settings.numConstraintIts; ++it)
+	{
+		const tbb::tick_count iterationStart = tbb::tick_count::now();
+		m_residualReduction.reset();
+
+		if (settings.useXPBD)
+		{
+			for (int t = 0; t < tetrahedra.size(); ++t)
+			{
+				m_jacobiLagrangeMultipliers[t] = m_tetRestStates.getLagrangeMultiplier(t);
+			}
+		}
 
-	//std::cout << "Points: " << std::endl;
-	//std::cout << p0 << std::endl;
-	//std::cout << p1 << std::endl;
-	//std::cout << p2 << std::endl;
-	//std::cout << p3 << std::endl;
-	//std::cout << "Inverse Masses: " << invMass0 << ", " << invMass1 << ", " << invMass2 << ", " << invMass3 << std::endl;
+		//1. all tetrahedra against the same positions; every tet writes only its own delta slots
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, tetrahedra.size()),
+			PBDSolverJacobiTBB(m_tetRestStates, particles, settings, m_jacobiDeltas, m_jacobiIsCorrected, m_constraintKernels,
+				m_inversionCounters, skipSleeping ? &m_activityTracker.getActiveTetFlags() : NULL),
+			tbb::auto_partitioner());
 
-	Eigen::Vector3f d1 = p1 - p0;
-	Eigen::Vector3f d2 = p2 - p0;
-	Eigen::Vector3f d3 = p3 - p0;
+		//2. per particle gather in fixed slot order (deterministic), averaged by influence count
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, particles.size()), [&](const tbb::blocked_range<size_t>& r)
+		{
+			PBDProjectionResidual residual;
 
-	corr0.setZero(); corr1.setZero(); corr2.setZero(); corr3.setZero();
+			for (size_t p = r.begin(); p != r.end(); ++p)
+			{
+				temporaryPositions[p].setZero();
+				numConstraintInfluences[p] = 0;
 
-	if (posVolumeStiffness == 0.0f && volume > 0.0f)
-		return false;
+				if (skipSleeping && !isSimulated[p])
+				{
+					continue;
+				}
 
-	if (negVolumeStiffness == 0.0f && volume < 0.0f)
-		return false;
+				for (int a = m_jacobiAdjacencyOffsets[p]; a < m_jacobiAdjacencyOffsets[p + 1]; ++a)
+				{
+					if (m_jacobiIsCorrected[m_jacobiAdjacency[a]])
+					{
+						temporaryPositions[p] += m_jacobiDeltas[m_jacobiAdjacency[a]];
+						++numConstraintInfluences[p];
+					}
+				}
 
+				if (numConstraintInfluences[p] == 0 || settings.disablePositionCorrection)
+				{
+					continue;
+				}
 
-	Eigen::Vector3f grad0 = (p1 - p2).cross(p3 - p2);
-	Eigen::Vector3f grad1 = (p2 - p0).cross(p3 - p0);
-	Eigen::Vector3f grad2 = (p0 - p1).cross(p3 - p1);
-	Eigen::Vector3f grad3 = (p1 - p0).cross(p2 - p0);
+				const Eigen::Vector3f deltaX = (settings.w / (float)numConstraintInfluences[p]) * temporaryPositions[p];
+				residual.add(deltaX);
 
-	float lambda =
-		invMass0 * grad0.squaredNorm() +
-		invMass1 * grad1.squaredNorm() +
-		invMass2 * grad2.squaredNorm() +
-		invMass3 * grad3.squaredNorm();
+				Eigen::Vector3f proposedEndpoint = particles.position(p) + deltaX;
+				correctEndpointForCollisionSpheres(particles.position(p), proposedEndpoint, state.collisionGeometry3, settings);
 
-	if (fabs(lambda) < 1.0e-9)
-		return false;
+				particles.position(p) = proposedEndpoint;
+			}
 
-	//if (volume < 0.0f)
-	//	lambda = negVolumeStiffness * (volume - restVolume) / lambda;
-	//else
-	//	lambda = posVolumeStiffness * (volume - restVolume) / lambda;
+			m_residualReduction.add(residual);
+		});
 
-	lambda = 1.0f * (volume - restVolume) / lambda;
+		//3. XPBD: a tet's vertices only moved by w / numConstraintInfluences of its correction, so only that share of
+		//its multiplier update is kept; otherwise the multipliers run ahead of the positions and the effective
+		//compliance depends on the vertex valence. The share is weighted like the constraint's linearisation,
+		//sum_i w_i |grad_i C|^2 = sum_i |delta_i|^2 / w_i up to a common factor.
+		if (settings.useXPBD)
+		{
+			tbb::parallel_for(tbb::blocked_range<size_t>(0, tetrahedra.size()), [&](const tbb::blocked_range<size_t>& r)
+			{
+				for (size_t t = r.begin(); t != r.end(); ++t)
+				{
+					const PBDTetRestState& rest = m_tetRestStates.getRestState(t);
 
-	//std::cout << "Volume: " << volume << "; Undeformed Volume: " << restVolume << std::endl;
+					float appliedNorm = 0.0f;
+					float totalNorm = 0.0f;
+					for (int v = 0; v < 4; ++v)
+					{
+						if (!m_jacobiIsCorrected[t * 4 + v])
+						{
+							continue;
+						}
 
-	//corr0 = -lambda * invMass0 * grad0;
-	//corr1 = -lambda * invMass1 * grad1;
-	//corr2 = -lambda * invMass2 * grad2;
-	//corr3 = -lambda * invMass3 * grad3;
+						const int p = rest.vertexIndices[v];
+						const float norm = m_jacobiDeltas[t * 4 + v].squaredNorm() / particles.inverseMass(p);
 
-	//std::cout << "Correction Terms: " << std::endl;
-	//std::cout << corr0 << std::endl;
-	//std::cout << corr1 << std::endl;
-	//std::cout << corr2 << std::endl;
-	//std::cout << corr3 << std::endl;
-	//std::cout << "___________________________________________" << std::endl;
+						totalNorm += norm;
+						if (numConstraintInfluences[p] > 0 && !settings.disablePositionCorrection)
+						{
+							appliedNorm += (settings.w / (float)numConstraintInfluences[p]) * norm;
+						}
+					}
 
-	return true;
-}
+					const float appliedFraction = totalNorm > 0.0f ? appliedNorm / totalNorm : 0.0f;
 
+					float& lagrangeMultiplier = m_tetRestStates.getLagrangeMultiplier(t);
+					lagrangeMultiplier = m_jacobiLagrangeMultipliers[t]
+						+ appliedFraction * (lagrangeMultiplier - m_jacobiLagrangeMultipliers[t]);
+				}
+			});
+		}
 
-void
-PBDSolver::projectConstraintsVISCOELASTIC_MULTI(std::vector<PBDTetrahedra3d>& tetrahedra,
-std::shared_ptr<std::vector<PBDParticle>>& particles, PBDSolverSettings& settings,
-std::vector<PBDProbabilisticConstraint>& probabilisticConstraints,
-std::vector<CollisionMesh>& collisionGeometry,
-std::vector<CollisionRod>& collisionGeometry2,
-std::vector<CollisionSphere>& collisionGeometry3)
-{
-	for (int it = 0; it < settings.numConstraintIts; ++it)
-	{
+		projectGeometricConstraints(tetrahedra, particles, settings, skipSleeping);
 
-		tbb::parallel_for(tbb::blocked_range<size_t>(0, tetrahedra.size()), PBDSolverTBB(tetrahedra, particles,
-			settings, probabilisticConstraints, collisionGeometry, collisionGeometry2, collisionGeometry3, m_mutex), tbb::auto_partitioner());
+		if (settings.useChebyshevAcceleration)
+		{
+			m_chebyshevAcceleration.apply(particles, settings);
+		}
 
 		if (settings.enableGroundPlaneCollision)
 		{
-			for (int p = 0; p < particles->size(); ++p)
+			for (int p = 0; p < particles.size(); ++p)
 			{
-				if ((*particles)[p].position()[1] < settings.groundplaneHeight)
+				if (particles.position(p)[1] < settings.groundplaneHeight)
 				{
-					(*particles)[p].position()[1] = settings.groundplaneHeight;
+					particles.position(p)[1] = settings.groundplaneHeight;
 				}
 			}
 		}
 
-		//COLLISION HANDLING
-		//for (int c = 0; c < collisionGeometry.size(); ++c)
-		//{
-		//	collisionGeometry[c].resolveParticleCollisions(*particles);
-		//}
-
-		//for (int c = 0; c < collisionGeometry2.size(); ++c)
-		//{
-		//	collisionGeometry2[c].resolveParticleCollisions(*particles, settings.currentFrame, settings.deltaT,
-		//		settings.collisionSpheresNum[c], settings.collisionSpheresRadius[c]);
-		//}
-
-		//if (it == settings.numConstraintIts % 2 != 0)
-		//{
-		//	processCollisions(tetrahedra, particles, settings, probabilisticConstraints, collisionGeometry, collisionGeometry2, collisionGeometry3);
-		//}
+		if (finishConstraintIteration(settings, it, iterationStart))
+		{
+			break;
+		}
 	}
-
-	//processCollisions(tetrahedra, particles, settings, probabilisticConstraints, collisionGeometry, collisionGeometry2, collisionGeometry3);
 }
 
 void
-PBDSolver::processCollisions(std::vector<PBDTetrahedra3d>& tetrahedra,
-	std::shared_ptr<std::vector<PBDParticle>>& particles, PBDSolverSettings& settings,
-	std::vector<PBDProbabilisticConstraint>& probabilisticConstraints,
-	std::vector<CollisionMesh>& collisionGeometry,
-	std::vector<CollisionRod>& collisionGeometry2,
-	std::vector<CollisionSphere>& collisionGeometry3)
+PBDSolver::processCollisions(PBDSimulationState& state, PBDSolverSettings& settings)
 {
+	PBDParticleStore& particles = *state.particles;
+	std::vector<CollisionSphere>& collisionGeometry3 = state.collisionGeometry3;
+
+	//the sphere centres are updated per substep, see updateMovingDrivers
 	for (int c = 0; c < collisionGeometry3.size(); ++c)
 	{
-		collisionGeometry3[c].calculateNewSphereCentre(settings.currentFrame, settings.deltaT);
-		tbb::parallel_for(tbb::blocked_range<size_t>(0, particles->size()), [&](const tbb::blocked_range<size_t>& r)
+		if (isSleepingEnabled(settings))
 		{
-			collisionGeometry3[c].resolveParticleCollisions_SAFE(*particles, settings.currentFrame, settings.deltaT,
-				settings.collisionSpheresRadius[c],
-				r.begin(), r.end());
+			const std::vector<int>& simulatedParticles = m_activityTracker.getSimulatedParticles();
+
+			tbb::parallel_for(tbb::blocked_range<size_t>(0, simulatedParticles.size()), [&](const tbb::blocked_range<size_t>& r)
+			{
+				int numCorrections = 0;
+				for (size_t i = r.begin(); i != r.end(); ++i)
+				{
+					numCorrections += collisionGeometry3[c].resolveParticleCollisions_SAFE(particles, settings.currentFrame,
+						settings.deltaT, settings.collisionSpheresRadius[c], simulatedParticles[i], simulatedParticles[i] + 1);
+				}
+				m_profiler.addCollisionCorrections(numCorrections);
+			});
+			continue;
+		}
+
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, particles.size()), [&](const tbb::blocked_range<size_t>& r)
+		{
+			m_profiler.addCollisionCorrections(collisionGeometry3[c].resolveParticleCollisions_SAFE(particles,
+				settings.currentFrame, settings.deltaT, settings.collisionSpheresRadius[c], r.begin(), r.end()));
 		});
-		//collisionGeometry3[c].resolveParticleCollisions(*particles, settings.currentFrame, settings.deltaT,
+		//collisionGeometry3[c].resolveParticleCollisions(particles, settings.currentFrame, settings.deltaT,
 		//	settings.collisionSpheresRadius[c]);
 	}
 
 }
 
 void
-PBDSolver::projectConstraintsVISCOELASTIC(std::vector<PBDTetrahedra3d>& tetrahedra,
-std::shared_ptr<std::vector<PBDParticle>>& particles, PBDSolverSettings& settings,
-std::vector<PBDProbabilisticConstraint>& probabilisticConstraints,
-std::vector<CollisionMesh>& collisionGeometry,
-std::vector<CollisionRod>& collisionGeometry2,
-std::vector<CollisionSphere>& collisionGeometry3)
+PBDSolver::projectConstraintsVISCOELASTIC(PBDSimulationState& state, PBDSolverSettings& settings)
 {
+	std::vector<PBDTetrahedra3d>& tetrahedra = *state.tetrahedra;
+	PBDParticleStore& particles = *state.particles;
+	std::vector<CollisionMesh>& collisionGeometry = state.collisionGeometry;
+	std::vector<CollisionRod>& collisionGeometry2 = state.collisionGeometry2;
+	std::vector<CollisionSphere>& collisionGeometry3 = state.collisionGeometry3;
+
 	Eigen::Vector3f a(0.0f, 1.0f, 0.0f);
 
 	float w1;
@@ -874,11 +1078,10 @@ std::vector<CollisionSphere>& collisionGeometry3)
 	Eigen::MatrixXf gradient; gradient.resize(3, 4);
 
 	Eigen::Matrix3f U;
-	Eigen::Matrix3f U_orig;
 	Eigen::Matrix3f V;
 	bool isInverted;
 
-	Eigen::Matrix3f S;
+	Eigen::Vector3f singularValues;
 	Eigen::Matrix3f Fhat;
 
 	Eigen::Vector3f deltaX;
@@ -917,102 +1120,14 @@ std::vector<CollisionSphere>& collisionGeometry3)
 			float Volume;
 
 			//Get deformation gradient
-			F_orig = tetrahedra[t].getDeformationGradient();
-
-			FTransposeF = F_orig.transpose() * F_orig;
+			m_tetRestStates.getDeformationGradient(t, particles, F_orig);
 
 			if (!settings.disableInversionHandling)
 			{
-				//Eigen::EigenSolver<Eigen::Matrix3f> eigenSolver(FTransposeF);
-				//S = eigenSolver.pseudoEigenvalueMatrix(); //squared eigenvalues of F
-				//V = eigenSolver.pseudoEigenvectors(); //eigenvectors
-				eigenDecompositionCardano(FTransposeF, S, V);
-
-				for (int i = 0; i < 3; ++i)
-				{
-					if (S(i, i) < 0.0f)
-					{
-						S(i, i) = 0.0f;
-					}
-				}
-
-				//remove reflection from V if necessary
-				if (V.determinant() < 0.0f)
-				{
-					float minElementValue = 10000000000000;
-					int minElementIdx = 111;
-					for (int i = 0; i < 3; ++i)
-					{
-						if (S(i, i) < minElementValue)
-						{
-							minElementValue = V(i, i);
-							minElementIdx = i;
-						}
-					}
-					V.col(minElementIdx) *= -1.0f;
-					//V.col(0) *= -1.0f;
-				}
-
-				//determine entries of F
-				F.setZero();
-				for (int i = 0; i < 3; ++i)
-				{
-					F(i, i) = std::sqrtf(S(i, i));
-				}
+				//F = U * F_hat * V^T with rotations U and V; the smallest singular value is negative for inverted elements
+				svd3x3(F_orig, U, singularValues, V);
 
-				U = F_orig * V * F.inverse();
-				U_orig = U;
-				int numEntriesNearZero = 0;
-				int idx = 0;
-				for (int i = 0; i < 3; ++i)
-				{
-					if (std::fabs(F(i, i)) < 1.0e-4f)
-					{
-						++numEntriesNearZero;
-						idx = i;
-					}
-				}
-
-				if (numEntriesNearZero > 0)
-				{
-					if (numEntriesNearZero == 1)
-					{
-						if (idx == 0)
-						{
-							U.col(0) = U.col(1).cross(U.col(2)).normalized();
-						}
-						else if (idx == 1)
-						{
-							U.col(1) = U.col(0).cross(U.col(2)).normalized();
-						}
-						else
-						{
-							U.col(2) = U.col(0).cross(U.col(1)).normalized();
-						}
-					}
-					else
-					{
-						U.setIdentity();
-					}
-				}
-
-				//remove reflection from U if necessary
-				if (U.determinant() < 0.0f)
-				{
-					float minElementValue = 1000000000000000;
-					int minElementIdx = 111;
-					for (int i = 0; i < 3; ++i)
-					{
-						if (F(i, i) < minElementValue)
-						{
-							minElementValue = F(i, i);
-							minElementIdx = i;
-						}
-					}
-
-					F(minElementIdx, minElementIdx) *= -1.0f;
-					U.col(minElementIdx) *= -1.0f;
-				}
+				F = singularValues.asDiagonal();
 
 				const float minXVal = 0.577f;
 
@@ -1033,7 +1148,7 @@ std::vector<CollisionSphere>& collisionGeometry3)
 
 			if (settings.disableInversionHandling)
 			{
-				F = tetrahedra[t].getDeformationGradient();
+				F = F_orig;
 			}
 
 			FInverseTranspose = F.inverse().transpose();
@@ -1043,7 +1158,7 @@ std::vector<CollisionSphere>& collisionGeometry3)
 			{
 			case PBDSolverSettings::CONSTITUTIVE_MODEL::NEO_HOOKEAN:
 			{
-				Volume = tetrahedra[t].getUndeformedVolume();
+				Volume = m_tetRestStates.getRestState(t).undeformedVolume;
 
 				//Compute Isotropic Invariants
 				float I1 = (FTransposeF).trace();
@@ -1064,7 +1179,7 @@ std::vector<CollisionSphere>& collisionGeometry3)
 			break;
 			case PBDSolverSettings::CONSTITUTIVE_MODEL::NEO_HOOKEAN_FIBER:
 			{
-				Volume = tetrahedra[t].getUndeformedVolume();
+				Volume = m_tetRestStates.getRestState(t).undeformedVolume;
 
 				//Compute Isotropic Invariants
 				float I1 = (FTransposeF).trace();
@@ -1138,23 +1253,23 @@ std::vector<CollisionSphere>& collisionGeometry3)
 					for (int pComponent = 0; pComponent < settings.fullAlpha.size(); ++pComponent)
 					{
 						temp += (2.0f * settings.deltaT * settings.fullAlpha[pComponent] * PF
-							+ settings.fullRho[pComponent] * tetrahedra[t].getFullUpsilon(pComponent)) / (settings.deltaT + settings.fullRho[pComponent]);
+							+ settings.fullRho[pComponent] * m_tetRestStates.getFullUpsilon(t, pComponent)) / (settings.deltaT + settings.fullRho[pComponent]);
 
-						tetrahedra[t].getFullUpsilon(pComponent) = (2.0f * settings.deltaT * settings.fullAlpha[pComponent] * PF
-							+ settings.fullRho[pComponent] * tetrahedra[t].getFullUpsilon(pComponent)) / (settings.deltaT + settings.fullRho[pComponent]);
+						m_tetRestStates.getFullUpsilon(t, pComponent) = (2.0f * settings.deltaT * settings.fullAlpha[pComponent] * PF
+							+ settings.fullRho[pComponent] * m_tetRestStates.getFullUpsilon(t, pComponent)) / (settings.deltaT + settings.fullRho[pComponent]);
 					}
 
 					vMult = temp;
 				}
 				else
 				{
-					vMult = tetrahedra[t].getUpsilon();
+					vMult = m_tetRestStates.getUpsilon(t);
 
 					vMult = (2.0f * settings.deltaT * settings.alpha * PF + settings.rho * vMult) / (settings.deltaT + settings.rho);
 
 					//if (it == settings.numConstraintIts - 1)
 					{
-						tetrahedra[t].getUpsilon() = vMult;
+						m_tetRestStates.getUpsilon(t) = vMult;
 					}
 				}
 
@@ -1179,7 +1294,7 @@ std::vector<CollisionSphere>& collisionGeometry3)
 
 			//PF GRADIENT ---------------------------------------------------------------------------------------------------------------
 
-			gradientTemp = Volume * PF * tetrahedra[t].getReferenceShapeMatrixInverseTranspose();
+			gradientTemp = Volume * PF * m_tetRestStates.getRestState(t).referenceShapeMatrixInverseTranspose;
 			gradient.col(0) = gradientTemp.col(0);
 			gradient.col(1) = gradientTemp.col(1);
 			gradient.col(2) = gradientTemp.col(2);
@@ -1192,9 +1307,9 @@ std::vector<CollisionSphere>& collisionGeometry3)
 
 			for (int cI = 0; cI < 4; ++cI)
 			{
-				if (tetrahedra[t].get_x(cI).inverseMass() != 0)
+				if (particles.inverseMass(m_tetRestStates.getRestState(t).vertexIndices[cI]) != 0)
 				{
-					denominator += tetrahedra[t].get_x(cI).inverseMass()
+					denominator += particles.inverseMass(m_tetRestStates.getRestState(t).vertexIndices[cI])
 						* gradient.col(cI).lpNorm<2>();
 				}
 			}
@@ -1237,14 +1352,14 @@ std::vector<CollisionSphere>& collisionGeometry3)
 			{
 				for (int cI = 0; cI < 4; ++cI)
 				{
-					if (tetrahedra[t].get_x(cI).inverseMass() != 0)
+					if (particles.inverseMass(m_tetRestStates.getRestState(t).vertexIndices[cI]) != 0)
 					{
 						if (!settings.disablePositionCorrection)
 						{
-							deltaX = (tetrahedra[t].get_x(cI).inverseMass()
+							deltaX = (particles.inverseMass(m_tetRestStates.getRestState(t).vertexIndices[cI])
 								* lagrangeM) * gradient.col(cI);
 
-							tetrahedra[t].get_x(cI).position() += deltaX;
+							particles.position(m_tetRestStates.getRestState(t).vertexIndices[cI]) += deltaX;
 
 							if (settings.trackAverageDeltaXLength)
 							{
@@ -1268,11 +1383,11 @@ std::vector<CollisionSphere>& collisionGeometry3)
 
 		if (settings.enableGroundPlaneCollision)
 		{
-			for (int p = 0; p < particles->size(); ++p)
+			for (int p = 0; p < particles.size(); ++p)
 			{
-				if ((*particles)[p].position()[1] < settings.groundplaneHeight)
+				if (particles.position(p)[1] < settings.groundplaneHeight)
 				{
-					(*particles)[p].position()[1] = settings.groundplaneHeight;
+					particles.position(p)[1] = settings.groundplaneHeight;
 				}
 			}
 		}
@@ -1280,18 +1395,18 @@ std::vector<CollisionSphere>& collisionGeometry3)
 		//COLLISION HANDLING
 		for (int c = 0; c < collisionGeometry.size(); ++c)
 		{
-			collisionGeometry[c].resolveParticleCollisions(*particles);
+			collisionGeometry[c].resolveParticleCollisions(particles);
 		}
 
 		for (int c = 0; c < collisionGeometry2.size(); ++c)
 		{
-			collisionGeometry2[c].resolveParticleCollisions(*particles, settings.currentFrame, settings.deltaT,
+			collisionGeometry2[c].resolveParticleCollisions(particles, settings.currentFrame, settings.deltaT,
 				settings.collisionSpheresNum[c], settings.collisionSpheresRadius[c]);
 		}
 
 		for (int c = 0; c < collisionGeometry3.size(); ++c)
 		{
-			collisionGeometry3[c].resolveParticleCollisions(*particles, settings.currentFrame, settings.deltaT,
+			collisionGeometry3[c].resolveParticleCollisions(particles, settings.currentFrame, settings.deltaT,
 				settings.collisionSpheresRadius[c]);
 		}
 
@@ -1313,7 +1428,7 @@ std::vector<CollisionSphere>& collisionGeometry3)
 
 	if (settings.trackSpecificPosition)
 	{
-		settings.tracker.specificPosition.push_back((*particles)[settings.trackSpecificPositionIdx].position());
+		settings.tracker.specificPosition.push_back(particles.position(settings.trackSpecificPositionIdx));
 	}
 
 	if (settings.trackAverageDeltaXLength)
@@ -1332,7 +1447,7 @@ std::vector<CollisionSphere>& collisionGeometry3)
 
 	//for (int pC = 0; pC < probabilisticConstraints.size(); ++pC)
 	//{
-	//	probabilisticConstraints[pC].project(*particles);
+	//	probabilisticConstraints[pC].project(particles);
 	//}
 
 	if (settings.printStrainEnergyToFile)
@@ -11,70 +11,107 @@
 #include "PBDTetrahedra3d.h"
 #include "Parameters.h"
 #include "PBDSolverSettings.h"
-#include "PBDProbabilisticConstraint.h"
-#include "CollisionMesh.h"
-#include "CollisionRod.h"
-#include "CollisionSphere.h"
+#include "PBDSimulationState.h"
+#include "PBDConstraintColoring.h"
+#include "PBDTetRestStateTable.h"
+#include "PBDInversionHandling.h"
+#include "PBDConstraintKernels.h"
+#include "PBDProjectionResidual.h"
+#include "PBDChebyshevAcceleration.h"
+#include "PBDMultilevelHierarchy.h"
+#include "PBDActivityTracker.h"
+#include "PBDGeometricConstraints.h"
+#include "PBDOverRelaxation.h"
+#include "PBDSolverProfiler.h"
 
 #include <boost/thread.hpp>
 
 #include <tbb\parallel_for.h>
 #include <tbb\mutex.h>
-#include <tbb\queuing_mutex.h>
 
 class PBDSolver
 {
 public:
-	void advanceSystem(std::vector<PBDTetrahedra3d>& tetrahedra,
-		std::shared_ptr<std::vector<PBDParticle>>& particles, PBDSolverSettings& settings,
-		std::vector<Eigen::Vector3f>& temporaryPositions, std::vector<int>& numConstraintInfluences,
-		std::vector<PBDProbabilisticConstraint>& probabilisticConstraints,
-		std::vector<CollisionMesh>& collisionGeometry,
-		std::vector<CollisionRod>& collisionGeometry2,
-		std::vector<CollisionSphere>& collisionGeometry3);
+	//Advances 'state' by one frame. The solver samples the moving drivers (collision spheres and hard constraints) at
+	//every substep (see PBDSolverSettings::numSubsteps). settings.deltaT is set to the substep size while the substeps
+	//run and restored afterwards.
+	void advanceSystem(PBDSimulationState& state, PBDSolverSettings& settings);
+
 	PBDSolver();
 
 	~PBDSolver();
 
-	void processCollisions(std::vector<PBDTetrahedra3d>& tetrahedra,
-		std::shared_ptr<std::vector<PBDParticle>>& particles, PBDSolverSettings& settings,
-		std::vector<PBDProbabilisticConstraint>& probabilisticConstraints,
-		std::vector<CollisionMesh>& collisionGeometry,
-		std::vector<CollisionRod>& collisionGeometry2,
-		std::vector<CollisionSphere>& collisionGeometry3);
+	//Builds the tetrahedra colouring used by the multi-threaded solver. Has to be called again
+	//whenever the mesh topology changes; it is otherwise built lazily on first use.
+	void initialiseTetrahedraColoring(std::vector<PBDTetrahedra3d>& tetrahedra,
+		PBDParticleStore& particles);
+
+	const PBDConstraintColoring& getTetrahedraColoring() const { return m_tetColoring; }
+
+	//Colour counts of the tetrahedra and, once built, of the geometric constraint sets. The colourings are built
+	//quietly (also for coarse levels and benchmark meshes), the caller decides what to report.
+	void printColoringStatistics() const;
+
+	//Builds the solver's rest-state table from the tetrahedra. Has to be called again whenever the mesh or the
+	//per-tet material attributes change; it is otherwise built lazily on first use.
+	void initialiseTetRestStates(std::vector<PBDTetrahedra3d>& tetrahedra, const PBDSolverSettings& settings);
+
+	PBDTetRestStateTable& getTetRestStates() { return m_tetRestStates; }
+
+	//Copies the colouring of 'source' and shares its rest-state table instead of building them, for many solvers on
+	//the same mesh (see ParameterSweep). 'source' has to be initialised for the mesh.
+	void shareMeshData(const PBDSolver& source, const PBDSolverSettings& settings);
+
+	//Builds the coarse levels of the multilevel mode from the committed particle positions, which are taken as the rest
+	//state. Has to be called again whenever the mesh changes; it is otherwise built lazily on first use.
+	void initialiseMultilevelHierarchy(std::vector<PBDTetrahedra3d>& tetrahedra,
+		PBDParticleStore& particles, const PBDSolverSettings& settings);
+
+	//Specialises the constraint kernels for the given settings; advanceSystem does this at the start of every call
+	void selectConstraintKernels(const PBDSolverSettings& settings, bool hasColliders);
+
+	//How many constraint evaluations of the multi-threaded and Jacobi solvers skipped the SVD of inversion handling
+	//(see PBDSolverSettings::useInversionFastPath). Accumulates until reset.
+	PBDInversionHandlingCounters& getInversionHandlingCounters() { return m_inversionCounters; }
 
-	void advanceVelocities(std::vector<PBDTetrahedra3d>& tetrahedra,
-		std::shared_ptr<std::vector<PBDParticle>>& particles, PBDSolverSettings& settings);
+	//Constraint sweeps run by the last advanceSystem call, summed over its substeps. Less than numConstraintIts per
+	//substep if the multi-threaded or Jacobi solver terminated early (see PBDSolverSettings::constraintTolerance).
+	int getNumConstraintItsUsed() const { return m_numConstraintItsUsed; }
 
-	void advancePositions(std::vector<PBDTetrahedra3d>& tetrahedra,
-		std::shared_ptr<std::vector<PBDParticle>>& particles, PBDSolverSettings& settings);
+	//Largest position correction of the last sweep of the multi-threaded or Jacobi solver
+	float getConstraintResidual() const { return m_constraintResidual; }
 
-	void projectConstraintsVISCOELASTIC(std::vector<PBDTetrahedra3d>& tetrahedra,
-		std::shared_ptr<std::vector<PBDParticle>>& particles, PBDSolverSettings& settings,
-		std::vector<PBDProbabilisticConstraint>& probabilisticConstraints,
-		std::vector<CollisionMesh>& collisionGeometry,
-		std::vector<CollisionRod>& collisionGeometry2,
-		std::vector<CollisionSphere>& collisionGeometry3);
+	//Sleeping state and the simulated fractions (see PBDSolverSettings::useSleeping). The counts accumulate until reset.
+	PBDActivityTracker& getActivityTracker() { return m_activityTracker; }
 
-	void projectConstraintsVISCOELASTIC_MULTI(std::vector<PBDTetrahedra3d>& tetrahedra,
-		std::shared_ptr<std::vector<PBDParticle>>& particles, PBDSolverSettings& settings,
-		std::vector<PBDProbabilisticConstraint>& probabilisticConstraints,
-		std::vector<CollisionMesh>& collisionGeometry,
-		std::vector<CollisionRod>& collisionGeometry2,
-		std::vector<CollisionSphere>& collisionGeometry3);
+	//Omega of the multi-colour SOR mode (see PBDSolverSettings::useSOR)
+	const PBDOverRelaxation& getOverRelaxation() const { return m_overRelaxation; }
 
-	void updateVelocities(std::vector<PBDTetrahedra3d>& tetrahedra,
-		std::shared_ptr<std::vector<PBDParticle>>& particles, const PBDSolverSettings& settings);
+	//Phase times and counters per frame (see PBDSolverSettings::enableProfiling). Recorded until cleared.
+	PBDSolverProfiler& getProfiler() { return m_profiler; }
+
+	//Builds the particle -> tet vertex adjacency used by the Jacobi solver. Built lazily on first use.
+	void initialiseJacobiAdjacency(std::vector<PBDTetrahedra3d>& tetrahedra,
+		PBDParticleStore& particles);
+
+	//Resolves the predicted positions of state.particles against the collision spheres of 'state'
+	void processCollisions(PBDSimulationState& state, PBDSolverSettings& settings);
+
+	//Uses the constraint kernels selected by the last advanceSystem call (as does the Jacobi version). Also run on
+	//their own by the coarse levels of PBDMultilevelHierarchy.
+	void projectConstraintsVISCOELASTIC_MULTI(PBDSimulationState& state, PBDSolverSettings& settings);
 
 	float calculateTotalStrainEnergy(std::vector<PBDTetrahedra3d>& tetrahedra,
-		std::shared_ptr<std::vector<PBDParticle>>& particles, const PBDSolverSettings& settings, int it,
+		PBDParticleStore& particles, const PBDSolverSettings& settings, int it,
 		std::ofstream& file);
 
+	//Stand-alone projection of the geometric constraint sets (see PBDGeometricConstraints), 'numIterations' sweeps
 	void projectConstraintsDistance(std::vector<PBDTetrahedra3d>& tetrahedra,
-		std::shared_ptr<std::vector<PBDParticle>>& particles, int numIterations, float k);
+		PBDParticleStore& particles, int numIterations, float k);
 
+	//Edge lengths and tet volumes, see projectConstraintsDistance
 	void projectConstraintsVolume(std::vector<PBDTetrahedra3d>& tetrahedra,
-		std::shared_ptr<std::vector<PBDParticle>>& particles, int numIterations, float k);
+		PBDParticleStore& particles, int numIterations, float k);
 
 	bool correctInversion(Eigen::Matrix3f& F, 
 		Eigen::Matrix3f& FTransposeF,
@@ -90,7 +127,72 @@ public:
 	int m_currentFrame;
 private:
 
-	tbb::queuing_mutex m_mutex;
+	//One predict / project / update cycle with settings.deltaT
+	void advanceSubstep(PBDSimulationState& state, PBDSolverSettings& settings);
+
+	//Predictor: velocities from the external forces and the predicted positions (plus the warm start correction), in
+	//one parallel pass
+	void predictPositions(PBDParticleStore& particles, const PBDSolverSettings& settings);
+
+	void projectConstraintsVISCOELASTIC(PBDSimulationState& state, PBDSolverSettings& settings);
+
+	//Jacobi style projection: all tetrahedra are evaluated in parallel against the same positions, the
+	//corrections are then averaged per particle by the number of influencing tetrahedra and scaled by settings.w.
+	void projectConstraintsVISCOELASTIC_JACOBI(PBDSimulationState& state, PBDSolverSettings& settings);
+
+	//Corrector: velocities from the projected positions and the warm start corrections in one parallel pass, then the
+	//state rotation by pointer (see PBDParticleStore::swapStates)
+	void updateVelocitiesAndSwapStates(PBDParticleStore& particles, const PBDSolverSettings& settings);
+
+	//Records the residual and the time of the sweep that just finished; returns true if it is below the tolerance
+	bool finishConstraintIteration(const PBDSolverSettings& settings, int iteration, const tbb::tick_count& iterationStart);
+
+	//One sweep over the enabled geometric constraint sets, after the energy constraints of an iteration
+	void projectGeometricConstraints(std::vector<PBDTetrahedra3d>& tetrahedra,
+		PBDParticleStore& particles, const PBDSolverSettings& settings, bool skipSleeping);
+
+	//Sleeping only applies to the multi-threaded and Jacobi solvers
+	bool isSleepingEnabled(const PBDSolverSettings& settings) const;
+
+	//Samples the drivers at the (fractional) frame; the animation time is systemFrame * frameDeltaT
+	void updateMovingDrivers(PBDSimulationState& state, float systemFrame, float frameDeltaT);
+
+	PBDConstraintColoring m_tetColoring;
+
+	PBDTetRestStateTable m_tetRestStates;
+
+	PBDInversionHandlingCounters m_inversionCounters;
+
+	//Kernel instantiations for the current settings, selected at the start of every advanceSystem call
+	PBDConstraintKernels m_constraintKernels;
+
+	PBDProjectionResidualReduction m_residualReduction;
+	int m_numConstraintItsUsed;
+	float m_constraintResidual;
+
+	PBDChebyshevAcceleration m_chebyshevAcceleration;
+
+	PBDOverRelaxation m_overRelaxation;
+
+	PBDSolverProfiler m_profiler;
+
+	PBDMultilevelHierarchy m_multilevelHierarchy;
+
+	PBDActivityTracker m_activityTracker;
+
+	PBDGeometricConstraints m_geometricConstraints;
+
+	//Warm starting: the constraint and collision correction of the last step per particle (x - predicted x)
+	std::vector<Eigen::Vector3f> m_warmStartCorrections;
+
+	//Jacobi solver: per tet vertex corrections (4 per tet) and particle -> tet vertex adjacency (CSR)
+	std::vector<Eigen::Vector3f> m_jacobiDeltas;
+	std::vector<char> m_jacobiIsCorrected;
+	std::vector<int> m_jacobiAdjacencyOffsets;
+	std::vector<int> m_jacobiAdjacency;
+
+	//XPBD with the Jacobi solver: the multipliers before the current iteration
+	std::vector<float> m_jacobiLagrangeMultipliers;
 };
 
 void
@@ -0,0 +1,312 @@
+#include "PBDSolverBatchKernel.h"
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "PBDSolverBatchKernelAVX2.h"
+#include "PBDSolverProcessingFunctionsTBB.h"
+
+//Fills the lanes of 'batch' with the tetrahedra tetIdxs[0 .. batch.numActive - 1]; unused lanes repeat the first one
+template<typename Policy>
+static void gatherBatch(PBDTetRestStateTable& tetRestStates, PBDParticleStore& particles,
+	const PBDSolverSettings& settings, const int* tetIdxs, PBDTetBatchAVX2& batch)
+{
+	const int N = PBDTetBatchAVX2::numLanes;
+
+	for (int l = 0; l < N; ++l)
+	{
+		const int t = tetIdxs[l < batch.numActive ? l : 0];
+		const PBDTetRestState& rest = tetRestStates.getRestState(t);
+		const Eigen::Vector3f& x4 = particles.position(rest.vertexIndices[3]);
+
+		for (int c = 0; c < 3; ++c)
+		{
+			const Eigen::Vector3f d = particles.position(rest.vertexIndices[c]) - x4;
+			for (int r = 0; r < 3; ++r)
+			{
+				batch.ds[r][c][l] = d[r];
+				batch.dmInvT[r][c][l] = rest.referenceShapeMatrixInverseTranspose(r, c);
+			}
+		}
+
+		for (int cI = 0; cI < 4; ++cI)
+		{
+			batch.inverseMass[cI][l] = particles.inverseMass(rest.vertexIndices[cI]);
+		}
+		batch.volume[l] = rest.undeformedVolume;
+
+		Eigen::Vector3f anisotropyDirection;
+		if (Policy::perTetMaterials)
+		{
+			const PBDTetMaterial& material = tetRestStates.getMaterial(t);
+			batch.youngsModulus[l] = settings.minYoungsModulus + material.youngsModulus * settings.youngsModulus;
+			batch.lambda[l] = settings.calculateLambda(batch.youngsModulus[l], settings.poissonRatio);
+			batch.mu[l] = settings.calculateMu(batch.youngsModulus[l], settings.poissonRatio);
+			batch.anisotropyStrength[l] = material.anisotropyStrength;
+			anisotropyDirection = material.anisotropyDirection;
+		}
+		else
+		{
+			batch.youngsModulus[l] = settings.youngsModulus;
+			batch.lambda[l] = settings.lambda;
+			batch.mu[l] = settings.mu;
+			batch.anisotropyStrength[l] = settings.anisotropyParameter;
+			anisotropyDirection = settings.MR_a;
+		}
+
+		for (int r = 0; r < 3; ++r)
+		{
+			batch.anisotropyDirection[r][l] = anisotropyDirection[r];
+		}
+
+		if (Policy::xpbd)
+		{
+			batch.lagrangeMultiplier[l] = tetRestStates.getLagrangeMultiplier(t);
+		}
+
+		if (Policy::viscoelasticity != VISCOELASTICITY_NONE)
+		{
+			const Eigen::Matrix3f& upsilon = tetRestStates.getUpsilon(t);
+			for (int r = 0; r < 3; ++r)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					batch.upsilon[r][c][l] = upsilon(r, c);
+				}
+			}
+		}
+	}
+}
+
+//Writes the viscous stresses and multipliers of the active lanes back and applies their position corrections
+template<typename Policy>
+static void scatterBatch(PBDTetRestStateTable& tetRestStates, PBDParticleStore& particles, PBDSolverSettings& settings,
+	std::vector<CollisionSphere>& collisionGeometry3, const int* tetIdxs, const PBDTetBatchAVX2& batch,
+	Eigen::MatrixXf& gradient, PBDInversionHandlingCounts& inversionCounts, PBDProjectionResidual& residual)
+{
+	if (Policy::inversionHandling != INVERSION_HANDLING_NONE)
+	{
+		if (batch.isDiagonalised)
+		{
+			inversionCounts.numFullPath += batch.numActive;
+		}
+		else
+		{
+			inversionCounts.numFastPath += batch.numActive;
+		}
+	}
+
+	inversionCounts.numEvaluations += batch.numActive;
+	for (int l = 0; l < batch.numActive; ++l)
+	{
+		if (batch.zeroDenominatorLanes & (1 << l))
+		{
+			++inversionCounts.numZeroDenominatorSkips;
+		}
+		else if ((batch.validLanes & (1 << l)) == 0)
+		{
+			++inversionCounts.numInvalidMultiplierSkips;
+		}
+	}
+
+	for (int l = 0; l < batch.numActive; ++l)
+	{
+		const int t = tetIdxs[l];
+
+		if (Policy::viscoelasticity != VISCOELASTICITY_NONE)
+		{
+			Eigen::Matrix3f& upsilon = tetRestStates.getUpsilon(t);
+			for (int r = 0; r < 3; ++r)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					upsilon(r, c) = batch.upsilon[r][c][l];
+				}
+			}
+		}
+
+		if ((batch.validLanes & (1 << l)) == 0)
+		{
+			continue;
+		}
+
+		if (Policy::xpbd)
+		{
+			tetRestStates.getLagrangeMultiplier(t) += batch.deltaLagrangeMultiplier[l];
+		}
+
+		for (int r = 0; r < 3; ++r)
+		{
+			for (int c = 0; c < 4; ++c)
+			{
+				gradient(r, c) = batch.gradient[r][c][l];
+			}
+		}
+
+		applyPositionCorrectionsVISCOELASTIC<Policy>(tetRestStates.getRestState(t), particles, gradient, batch.lagrangeM[l],
+			collisionGeometry3, settings, residual);
+	}
+}
+
+template<typename Policy>
+static void projectTetrahedraAVX2(PBDTetRestStateTable& tetRestStates, PBDParticleStore& particles,
+	PBDSolverSettings& settings, std::vector<CollisionSphere>& collisionGeometry3,
+	const int* tetIdxs, int numTets, PBDInversionHandlingCounts& inversionCounts, PBDProjectionResidual& residual)
+{
+	Eigen::MatrixXf gradient; gradient.resize(3, 4);
+
+	PBDTetBatchAVX2 batch;
+	batch.globalMu = settings.mu;
+	batch.deltaT = settings.deltaT;
+	batch.alpha = settings.alpha;
+	batch.rho = settings.rho;
+
+	for (int i = 0; i < numTets; i += PBDTetBatchAVX2::numLanes)
+	{
+		batch.numActive = std::min((int)PBDTetBatchAVX2::numLanes, numTets - i);
+
+		gatherBatch<Policy>(tetRestStates, particles, settings, &tetIdxs[i], batch);
+
+		projectBatchAVX2<Policy::inversionHandling != INVERSION_HANDLING_NONE,
+			Policy::inversionHandling == INVERSION_HANDLING_ADAPTIVE,
+			Policy::materialModel == PBDSolverSettings::CONSTITUTIVE_MODEL::NEO_HOOKEAN_FIBER,
+			Policy::viscoelasticity != VISCOELASTICITY_NONE,
+			Policy::xpbd>(batch);
+
+		scatterBatch<Policy>(tetRestStates, particles, settings, collisionGeometry3, &tetIdxs[i], batch, gradient,
+			inversionCounts, residual);
+	}
+}
+
+//The batched kernel has no full Prony series; those policies are never instantiated
+template<typename Policy, bool IsSupported = Policy::viscoelasticity != VISCOELASTICITY_FULL_PRONY>
+struct ProjectTetrahedraAVX2Kernel
+{
+	static PBDConstraintKernels::ProjectTetrahedraFunction get() { return &projectTetrahedraAVX2<Policy>; }
+};
+
+template<typename Policy>
+struct ProjectTetrahedraAVX2Kernel<Policy, false>
+{
+	static PBDConstraintKernels::ProjectTetrahedraFunction get() { return NULL; }
+};
+
+struct ProjectTetrahedraAVX2Family
+{
+	typedef PBDConstraintKernels::ProjectTetrahedraFunction Result;
+
+	template<typename Policy>
+	static Result get() { return ProjectTetrahedraAVX2Kernel<Policy>::get(); }
+};
+
+PBDSolverBatchKernel::INSTRUCTION_SET
+PBDSolverBatchKernel::detectInstructionSet()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return SCALAR;
+	}
+
+	//OSXSAVE and AVX, then check that the OS saves the YMM registers
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	const bool fma = (info[2] & (1 << 12)) != 0;
+	if (!osxsave || !avx || !fma || (_xgetbv(0) & 0x6) != 0x6)
+	{
+		return SCALAR;
+	}
+
+	__cpuidex(info, 7, 0);
+	if ((info[1] & (1 << 5)) == 0)
+	{
+		return SCALAR;
+	}
+
+	return AVX2;
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+	{
+		return AVX2;
+	}
+
+	return SCALAR;
+#endif
+}
+
+PBDSolverBatchKernel::INSTRUCTION_SET
+PBDSolverBatchKernel::getInstructionSet()
+{
+	static const INSTRUCTION_SET instructionSet = detectInstructionSet();
+	return instructionSet;
+}
+
+const char*
+PBDSolverBatchKernel::getInstructionSetName()
+{
+	switch (getInstructionSet())
+	{
+	case AVX2:
+		return "AVX2";
+	default:
+		return "SCALAR";
+	}
+}
+
+int
+PBDSolverBatchKernel::getNumLanes()
+{
+	switch (getInstructionSet())
+	{
+	case AVX2:
+		return 8;
+	default:
+		return 1;
+	}
+}
+
+bool
+PBDSolverBatchKernel::isSupported(const PBDSolverSettings& settings)
+{
+	if (getInstructionSet() == SCALAR)
+	{
+		return false;
+	}
+
+	//the full Prony series and Rubin-Bodner stay on the scalar kernel
+	if (settings.materialModel == PBDSolverSettings::CONSTITUTIVE_MODEL::RUBIN_BODNER)
+	{
+		return false;
+	}
+
+	if (settings.useFullPronySeries && settings.alpha != 0.0f && settings.rho != 0.0f)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+PBDConstraintKernels::ProjectTetrahedraFunction
+PBDSolverBatchKernel::selectProjectTetrahedra(const PBDSolverSettings& settings, bool hasColliders)
+{
+	if (!isSupported(settings))
+	{
+		return NULL;
+	}
+
+	switch (getInstructionSet())
+	{
+	case AVX2:
+		return selectKernelPolicy<ProjectTetrahedraAVX2Family>(settings, hasColliders);
+	default:
+		return NULL;
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+
+#include "PBDParticleStore.h"
+#include "PBDTetRestStateTable.h"
+#include "PBDSolverSettings.h"
+#include "CollisionSphere.h"
+#include "PBDInversionHandling.h"
+#include "PBDConstraintKernels.h"
+
+//Lane-parallel evaluation of the viscoelastic Neo-Hookean constraint: tetrahedra of one colour are processed
+//in groups of SIMD lanes (gather, F, invariants, PF, strain energy and Lagrange multiplier per lane), the
+//position corrections are then scattered one tet at a time. Only the per-lane evaluation is compiled with AVX2
+//(see PBDSolverBatchKernelAVX2.h), the gather and the scatter are ordinary code. The instruction set is detected once at start-up;
+//on CPUs without AVX2 (and for settings the batched kernel does not cover) PBDConstraintKernels falls back to the
+//scalar kernel.
+class PBDSolverBatchKernel
+{
+public:
+	enum INSTRUCTION_SET
+	{
+		SCALAR,
+		AVX2
+	};
+
+	static INSTRUCTION_SET getInstructionSet();
+
+	static const char* getInstructionSetName();
+
+	//Number of tetrahedra evaluated per batch (1 for the scalar fallback)
+	static int getNumLanes();
+
+	//true if the batched kernel is available on this CPU and covers 'settings'
+	static bool isSupported(const PBDSolverSettings& settings);
+
+	//The batched projection kernel instantiated for the policy matching 'settings' (see PBDConstraintKernelPolicy.h),
+	//NULL if !isSupported(settings). A batch skips the SVD of inversion handling only if all its lanes qualify
+	//for the fast path.
+	static PBDConstraintKernels::ProjectTetrahedraFunction selectProjectTetrahedra(const PBDSolverSettings& settings,
+		bool hasColliders);
+
+private:
+	static INSTRUCTION_SET detectInstructionSet();
+};
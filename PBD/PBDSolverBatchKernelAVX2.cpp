@@ -0,0 +1,349 @@
+#include "PBDSolverBatchKernelAVX2.h"
+
+#include "LaneMathAVX2.h"
+#include "SVD3x3Lanes.h"
+#include "PBDInversionHandlingLanes.h"
+#include "PBDCompliance.h"
+
+//This file is compiled with AVX2 code generation (/arch:AVX2) and may only include the headers listed in
+//PBDSolverBatchKernelAVX2.h; nothing in it may be called before PBDSolverBatchKernel has confirmed that the CPU
+//supports AVX2.
+
+//Lane-parallel version of computeConstraintGradientVISCOELASTIC for the eight tetrahedra of 'batch'. The position
+//corrections are applied by the caller (see PBDSolverBatchKernel.cpp).
+template<bool InversionHandling, bool AdaptiveInversionHandling, bool Fiber, bool Viscoelastic, bool XPBD>
+void projectBatchAVX2(PBDTetBatchAVX2& batch)
+{
+	typedef LanesAVX2 Real;
+
+	const bool inversionHandling = InversionHandling;
+	const bool fiber = Fiber;
+	const bool viscoelastic = Viscoelastic;
+
+	LaneMat3<Real> Ds;
+	LaneMat3<Real> DmInvT;
+	for (int r = 0; r < 3; ++r)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			Ds.m[r][c] = Real::load(batch.ds[r][c]);
+			DmInvT.m[r][c] = Real::load(batch.dmInvT[r][c]);
+		}
+	}
+
+	const Real Volume = Real::load(batch.volume);
+	const Real lambda = Real::load(batch.lambda);
+	const Real mu = Real::load(batch.mu);
+
+	//DEFORMATION GRADIENT AND INVERSION HANDLING -------------------------------------------------------------------------------
+	const LaneMat3<Real> F_orig = laneMulTransposeB(Ds, DmInvT);
+
+	LaneMat3<Real> F;
+	LaneMat3<Real> U;
+	LaneMat3<Real> V;
+
+	const float minXVal = 0.577f;
+	const float maxXVal = 500.0f;
+
+	//the batch skips the SVD if all active lanes are neither inverted nor clamped (see PBDInversionHandling.h)
+	bool isDiagonalised = inversionHandling;
+	if (AdaptiveInversionHandling)
+	{
+		const int activeLanes = (1 << batch.numActive) - 1;
+		const int fastLanes = lanesMoveMask(laneIsWithinSingularValueRange(F_orig, minXVal, maxXVal));
+
+		isDiagonalised = (fastLanes & activeLanes) != activeLanes;
+	}
+
+	batch.isDiagonalised = isDiagonalised;
+
+	if (isDiagonalised)
+	{
+		//F = U * F_hat * V^T with rotations U and V; the smallest singular value is negative for inverted elements
+		Real f[3];
+		svd3x3(F_orig, U, f, V);
+
+		for (int i = 0; i < 3; ++i)
+		{
+			f[i] = lanesMin(lanesMax(f[i], Real(minXVal)), Real(maxXVal));
+		}
+
+		laneSetDiagonal(F, f);
+	}
+	else
+	{
+		F = F_orig;
+	}
+
+	//STRESS AND STRAIN ENERGY --------------------------------------------------------------------------------------------------
+	const LaneMat3<Real> FInverse = laneInverse(F);
+	const LaneMat3<Real> FInverseTranspose = laneTranspose(FInverse);
+
+	const Real isochoricScale = lanesPow(laneDeterminant(F), -2.0f / 3.0f);
+	LaneMat3<Real> FTransposeF = laneMulTransposeA(F, F);
+	for (int r = 0; r < 3; ++r)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			FTransposeF.m[r][c] = FTransposeF.m[r][c] * isochoricScale;
+		}
+	}
+
+	const Real I1 = laneTrace(FTransposeF);
+	const Real I3 = laneDeterminant(FTransposeF);
+	const Real logI3 = lanesLog(I3);
+
+	const Real muPF = fiber ? Real(batch.globalMu) : mu;
+	const Real volumetricScale = (lambda * logI3) / Real(2.0f);
+
+	LaneMat3<Real> PF;
+	LaneMat3<Real> PF_vol;
+	for (int r = 0; r < 3; ++r)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			PF.m[r][c] = muPF * F.m[r][c] - muPF * FInverseTranspose.m[r][c];
+			PF_vol.m[r][c] = volumetricScale * FInverseTranspose.m[r][c];
+		}
+	}
+
+	Real strainEnergy = Volume * (Real(0.5f) * mu * (I1 - logI3 - Real(3.0f)) + (lambda / Real(8.0f)) * (logI3 * logI3));
+
+	if (fiber)
+	{
+		const Real anisotropyStrength = Real::load(batch.anisotropyStrength);
+
+		Real a[3];
+		for (int r = 0; r < 3; ++r)
+		{
+			a[r] = Real::load(batch.anisotropyDirection[r]);
+		}
+
+		Real rotated_a[3];
+		for (int r = 0; r < 3; ++r)
+		{
+			rotated_a[r] = isDiagonalised ? V.m[0][r] * a[0] + V.m[1][r] * a[1] + V.m[2][r] * a[2] : a[r];
+		}
+
+		//STRETCH ('pseudo-invariant' of C)
+		Real aCa(0.0f);
+		for (int r = 0; r < 3; ++r)
+		{
+			aCa = aCa + rotated_a[r] * (FTransposeF.m[r][0] * rotated_a[0] + FTransposeF.m[r][1] * rotated_a[1] + FTransposeF.m[r][2] * rotated_a[2]);
+		}
+		const Real stretch = lanesSqrt(aCa);
+
+		strainEnergy = strainEnergy + (anisotropyStrength / Real(2.0f)) * ((stretch - Real(1.0f)) * (stretch - Real(1.0f)));
+
+		const LaneMat3<Real> FTransposeFInverse = laneInverse(FTransposeF);
+		const Real fiberScale = isochoricScale * (anisotropyStrength * (stretch - Real(1.0f)));
+		const Real stretchThird = stretch / Real(3.0f);
+		for (int r = 0; r < 3; ++r)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				PF.m[r][c] = PF.m[r][c] + fiberScale * (rotated_a[r] * rotated_a[c] + stretchThird * FTransposeFInverse.m[r][c]);
+			}
+		}
+	}
+
+	//VISCOELASTICITY -----------------------------------------------------------------------------------------------------------
+	if (viscoelastic)
+	{
+		PF = laneMul(FInverse, PF);
+		PF_vol = laneMul(FInverse, PF_vol);
+
+		const Real viscousScale = Real(2.0f * batch.deltaT * batch.alpha);
+		const Real rho(batch.rho);
+		const Real invDenominator = Real(1.0f) / Real(batch.deltaT + batch.rho);
+
+		//the viscous stress is kept in the reference frame when the fast path is enabled, see the scalar kernel
+		const bool rotateUpsilon = isDiagonalised && AdaptiveInversionHandling;
+
+		LaneMat3<Real> vMult;
+		for (int r = 0; r < 3; ++r)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				vMult.m[r][c] = Real::load(batch.upsilon[r][c]);
+			}
+		}
+
+		if (rotateUpsilon)
+		{
+			vMult = laneMul(laneMulTransposeA(V, vMult), V);
+		}
+
+		for (int r = 0; r < 3; ++r)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				vMult.m[r][c] = (viscousScale * PF.m[r][c] + rho * vMult.m[r][c]) * invDenominator;
+
+				PF.m[r][c] = Real(2.0f) * PF_vol.m[r][c] + Real(2.0f) * PF.m[r][c] - vMult.m[r][c];
+			}
+		}
+
+		const LaneMat3<Real> upsilon = rotateUpsilon ? laneMulTransposeB(laneMul(V, vMult), V) : vMult;
+		for (int r = 0; r < 3; ++r)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				upsilon.m[r][c].store(batch.upsilon[r][c]);
+			}
+		}
+
+		PF = laneMul(F, PF);
+	}
+
+	if (isDiagonalised)
+	{
+		PF = laneMulTransposeB(laneMul(U, PF), V);
+	}
+
+	//PF GRADIENT ---------------------------------------------------------------------------------------------------------------
+	const LaneMat3<Real> gradientTemp = laneMul(PF, DmInvT);
+
+	Real g[3][4];
+	for (int r = 0; r < 3; ++r)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			g[r][c] = Volume * gradientTemp.m[r][c];
+		}
+		g[r][3] = -(g[r][0] + g[r][1] + g[r][2]);
+	}
+
+	//PBD MAIN ROUTINE ----------------------------------------------------------------------------------------------------------
+	Real lagrangeM;
+	int validLanes;
+	int zeroDenominatorLanes;
+
+	if (XPBD)
+	{
+		Real weightedSquaredGradientNorm(0.0f);
+		for (int cI = 0; cI < 4; ++cI)
+		{
+			weightedSquaredGradientNorm = weightedSquaredGradientNorm
+				+ Real::load(batch.inverseMass[cI]) * (g[0][cI] * g[0][cI] + g[1][cI] * g[1][cI] + g[2][cI] * g[2][cI]);
+		}
+
+		Real deltaLagrangeMultiplier;
+		lagrangeM = laneComplianceMultiplier(strainEnergy, weightedSquaredGradientNorm, Real::load(batch.youngsModulus),
+			Real::load(batch.lagrangeMultiplier), batch.deltaT, deltaLagrangeMultiplier);
+		deltaLagrangeMultiplier.store(batch.deltaLagrangeMultiplier);
+
+		//see the scalar kernel
+		zeroDenominatorLanes = lanesMoveMask(lanesLess(weightedSquaredGradientNorm, Real(1e-20f)))
+			| lanesMoveMask(lanesLess(strainEnergy, Real(1e-20f)));
+		validLanes = lanesMoveMask(lanesIsFinite(lagrangeM)) & ~zeroDenominatorLanes;
+	}
+	else
+	{
+		Real denominator(0.0f);
+		for (int cI = 0; cI < 4; ++cI)
+		{
+			const Real inverseMass = Real::load(batch.inverseMass[cI]);
+			const Real norm = lanesSqrt(g[0][cI] * g[0][cI] + g[1][cI] * g[1][cI] + g[2][cI] * g[2][cI]);
+			denominator = denominator + lanesSelect(lanesNotEqual(inverseMass, Real(0.0f)), inverseMass * norm, Real(0.0f));
+		}
+
+		lagrangeM = -(strainEnergy / denominator);
+
+		//skip lanes without deformation (denominator < 1e-20) or with a non-finite multiplier
+		zeroDenominatorLanes = lanesMoveMask(lanesLess(denominator, Real(1e-20f)));
+		validLanes = lanesMoveMask(lanesIsFinite(lagrangeM)) & ~zeroDenominatorLanes;
+	}
+
+	for (int r = 0; r < 3; ++r)
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			g[r][c].store(batch.gradient[r][c]);
+		}
+	}
+	lagrangeM.store(batch.lagrangeM);
+
+	batch.validLanes = validLanes;
+	batch.zeroDenominatorLanes = zeroDenominatorLanes;
+}
+
+//The combinations selectKernelPolicy produces: adaptive inversion handling only exists for the isotropic model
+#define PBD_INSTANTIATE_BATCH_AVX2(Viscoelastic, XPBD) \
+	template void projectBatchAVX2<false, false, false, Viscoelastic, XPBD>(PBDTetBatchAVX2& batch); \
+	template void projectBatchAVX2<true, false, false, Viscoelastic, XPBD>(PBDTetBatchAVX2& batch); \
+	template void projectBatchAVX2<true, true, false, Viscoelastic, XPBD>(PBDTetBatchAVX2& batch); \
+	template void projectBatchAVX2<false, false, true, Viscoelastic, XPBD>(PBDTetBatchAVX2& batch); \
+	template void projectBatchAVX2<true, false, true, Viscoelastic, XPBD>(PBDTetBatchAVX2& batch);
+
+PBD_INSTANTIATE_BATCH_AVX2(false, false)
+PBD_INSTANTIATE_BATCH_AVX2(false, true)
+PBD_INSTANTIATE_BATCH_AVX2(true, false)
+PBD_INSTANTIATE_BATCH_AVX2(true, true)
+
+#undef PBD_INSTANTIATE_BATCH_AVX2
+
+void
+svd3x3AVX2(const float* A, float* U, float* S, float* V, int numMatrices)
+{
+	const int N = LanesAVX2::numLanes;
+
+	for (int i = 0; i < numMatrices; i += N)
+	{
+		const int numActive = (numMatrices - i < N) ? numMatrices - i : N;
+
+		//column-major, see PBDSolverBatchKernelAVX2.h
+		float aIn[3][3][N];
+		for (int l = 0; l < N; ++l)
+		{
+			const float* a = &A[9 * (i + (l < numActive ? l : 0))];
+			for (int r = 0; r < 3; ++r)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					aIn[r][c][l] = a[3 * c + r];
+				}
+			}
+		}
+
+		LaneMat3<LanesAVX2> A_l;
+		for (int r = 0; r < 3; ++r)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				A_l.m[r][c] = LanesAVX2::load(aIn[r][c]);
+			}
+		}
+
+		LaneMat3<LanesAVX2> U_l;
+		LaneMat3<LanesAVX2> V_l;
+		LanesAVX2 S_l[3];
+		svd3x3(A_l, U_l, S_l, V_l);
+
+		float uOut[3][3][N];
+		float vOut[3][3][N];
+		float sOut[3][N];
+		for (int r = 0; r < 3; ++r)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				U_l.m[r][c].store(uOut[r][c]);
+				V_l.m[r][c].store(vOut[r][c]);
+			}
+			S_l[r].store(sOut[r]);
+		}
+
+		for (int l = 0; l < numActive; ++l)
+		{
+			for (int r = 0; r < 3; ++r)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					U[9 * (i + l) + 3 * c + r] = uOut[r][c][l];
+					V[9 * (i + l) + 3 * c + r] = vOut[r][c][l];
+				}
+				S[3 * (i + l) + r] = sOut[r][l];
+			}
+		}
+	}
+}
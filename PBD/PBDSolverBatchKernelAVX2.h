@@ -0,0 +1,65 @@
+#pragma once
+
+//Interface of PBDSolverBatchKernelAVX2.cpp, the only file compiled with AVX2 code generation (/arch:AVX2). The
+//linker keeps an arbitrary copy of an inline function instantiated in several files, so that file must not
+//instantiate anything the rest of the solver instantiates as well (Eigen, the solver's tables, the scalar kernel
+//helpers, the standard library): otherwise the scalar fallback could end up running its AVX2 copy. It therefore only
+//includes the lane templates (LaneMath.h, LaneMathAVX2.h, SVD3x3Lanes.h, PBDInversionHandlingLanes.h,
+//PBDCompliance.h), which it instantiates for LanesAVX2 alone, and this header, which has plain float arrays in and
+//out. The gather from and the scatter to the solver's tables are in PBDSolverBatchKernel.cpp.
+//
+//Nothing declared here may be called before PBDSolverBatchKernel has confirmed that the CPU supports AVX2.
+
+//Up to eight tetrahedra, one per lane. Unused lanes (>= numActive) have to hold valid data, e.g. a copy of the first
+//tetrahedron; their results are ignored.
+struct PBDTetBatchAVX2
+{
+	enum { numLanes = 8 };
+
+	int numActive;
+
+	//INPUT: Ds (edges to the fourth vertex), Dm^-T, inverse masses, rest volume and the material per lane
+	float ds[3][3][numLanes];
+	float dmInvT[3][3][numLanes];
+	float inverseMass[4][numLanes];
+	float volume[numLanes];
+	float youngsModulus[numLanes];
+	float lambda[numLanes];
+	float mu[numLanes];
+	float anisotropyStrength[numLanes];
+	float anisotropyDirection[3][numLanes];
+
+	//XPBD: the accumulated Lagrange multiplier
+	float lagrangeMultiplier[numLanes];
+
+	//Viscoelasticity: the viscous stress, updated in place
+	float upsilon[3][3][numLanes];
+
+	//Global mu (the fibre model's isotropic part) and the step parameters
+	float globalMu;
+	float deltaT;
+	float alpha;
+	float rho;
+
+	//OUTPUT: the strain energy gradient per vertex and the multiplier the corrections are scaled by
+	float gradient[3][4][numLanes];
+	float lagrangeM[numLanes];
+	float deltaLagrangeMultiplier[numLanes];
+
+	//bit l set for lanes to apply / skipped for a zero denominator
+	int validLanes;
+	int zeroDenominatorLanes;
+
+	//true if the batch went through the SVD of inversion handling
+	bool isDiagonalised;
+};
+
+//Lane-parallel computeConstraintGradientVISCOELASTIC for the features of a PBDKernelPolicy: inversion handling
+//(always / adaptive), the fibre model, single term viscoelasticity and XPBD. Instantiated in
+//PBDSolverBatchKernelAVX2.cpp for the combinations selectKernelPolicy produces.
+template<bool InversionHandling, bool AdaptiveInversionHandling, bool Fiber, bool Viscoelastic, bool XPBD>
+void projectBatchAVX2(PBDTetBatchAVX2& batch);
+
+//svd3x3 (see SVD3x3Lanes.h) for numMatrices column-major 3x3 matrices (e.g. Eigen::Matrix3f), eight at a time;
+//S holds 3 floats per matrix.
+void svd3x3AVX2(const float* A, float* U, float* S, float* V, int numMatrices);
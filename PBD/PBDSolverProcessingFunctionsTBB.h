@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <string>
+#include <algorithm>
 
 #include "PBDParticle.h"
 #include "PBDTetrahedra3d.h"
@@ -9,520 +10,593 @@
 #include "CollisionRod.h"
 #include "PBDProbabilisticConstraint.h"
 #include "PBDSolverSettings.h"
+#include "PBDTetRestStateTable.h"
+#include "PBDSolverBatchKernel.h"
+#include "PBDConstraintKernels.h"
+#include "SVD3x3.h"
+#include "PBDInversionHandling.h"
+#include "PBDCompliance.h"
+#include "PBDProjectionResidual.h"
 
 
 #include <tbb\parallel_for.h>
-#include <tbb\mutex.h>
-#include <tbb\queuing_mutex.h>
 #include <tbb\blocked_range.h>
 
 
-//typedef tbb::queuing_mutex currentMutex_t;
-
-struct PBDSolverTBB
+//Evaluates the viscoelastic strain energy constraint of a single tetrahedron. On success 'gradient' (3x4) and
+//'lagrangeM' hold the constraint gradient and multiplier; the correction of vertex i is
+//inverseMass_i * lagrangeM * gradient.col(i). Returns false if the tetrahedron is not to be corrected.
+//The inversion handling path taken is counted in 'inversionCounts'. The solver features are those of 'Policy'
+//(see PBDConstraintKernelPolicy.h), not the corresponding members of 'settings'.
+template<typename Policy>
+inline bool computeConstraintGradientVISCOELASTIC(PBDTetRestStateTable& tetRestStates, int t, PBDParticleStore& particles,
+	PBDSolverSettings& settings, Eigen::MatrixXf& gradient, float& lagrangeM, PBDInversionHandlingCounts& inversionCounts)
 {
-	PBDSolverTBB(std::vector<PBDTetrahedra3d>& in_tetrahedra,
-	std::shared_ptr<std::vector<PBDParticle>>& in_particles, PBDSolverSettings& in_settings,
-	std::vector<PBDProbabilisticConstraint>& in_probabilisticConstraints,
-	std::vector<CollisionMesh>& in_collisionGeometry,
-	std::vector<CollisionRod>& in_collisionGeometry2,
-	std::vector<CollisionSphere>& in_collisionGeometry3,
-	tbb::queuing_mutex& in_mutex) : tetrahedra(in_tetrahedra), particles(in_particles),
-	settings(in_settings), probabilisticConstraints(in_probabilisticConstraints),
-	collisionGeometry(in_collisionGeometry), collisionGeometry2(in_collisionGeometry2), collisionGeometry3(in_collisionGeometry3), mutex(in_mutex)
-	{
-		//nothing else to do
-	}
+	const PBDTetRestState& rest = tetRestStates.getRestState(t);
 
-	std::vector<PBDTetrahedra3d>& tetrahedra;
-	std::shared_ptr<std::vector<PBDParticle>>& particles;
-	PBDSolverSettings& settings;
-	std::vector<PBDProbabilisticConstraint>& probabilisticConstraints;
-	std::vector<CollisionMesh>& collisionGeometry;
-	std::vector<CollisionRod>& collisionGeometry2;
-	std::vector<CollisionSphere>& collisionGeometry3;
+	++inversionCounts.numEvaluations;
 
-	tbb::queuing_mutex& mutex;
+	Eigen::Matrix3f F_orig;
+	Eigen::Matrix3f F;
+	Eigen::Matrix3f FInverseTranspose;
+	Eigen::Matrix3f FTransposeF;
 
-	void operator()(const tbb::blocked_range<size_t>& r) const
-	{
-		float w1;
-		float w2;
-		float restDistance;
+	Eigen::Matrix3f PF;
+	Eigen::Matrix3f PF_vol;
+	Eigen::Matrix3f gradientTemp;
 
-		Eigen::Vector3f x1;
-		Eigen::Vector3f x2;
+	Eigen::Matrix3f U;
+	Eigen::Matrix3f V;
 
-		Eigen::Vector3f temp;
+	Eigen::Vector3f singularValues;
 
-		Eigen::Matrix3f TEMP_1;
+	float youngsModulus;
+	float lambda;
+	float mu;
+	float anisotropyStrength;
+	Eigen::Vector3f anisotropyDirection;
 
-		Eigen::Matrix3f F_orig;
-		Eigen::Matrix3f F;
-		Eigen::Matrix3f FInverseTranspose;
-		Eigen::Matrix3f FTransposeF;
+	if (Policy::perTetMaterials)
+	{
+		youngsModulus = settings.minYoungsModulus + tetRestStates.getMaterial(t).youngsModulus * settings.youngsModulus;
+		lambda = settings.calculateLambda(youngsModulus, settings.poissonRatio);
+		mu = settings.calculateMu(youngsModulus, settings.poissonRatio);
+		anisotropyStrength = tetRestStates.getMaterial(t).anisotropyStrength;
+		anisotropyDirection = tetRestStates.getMaterial(t).anisotropyDirection;
+	}
+	else
+	{
+		youngsModulus = settings.youngsModulus;
+		lambda = settings.lambda;
+		mu = settings.mu;
+		anisotropyStrength = settings.anisotropyParameter;
+		anisotropyDirection = settings.MR_a;
+	}
+
+	float strainEnergy;
+	float Volume;
 
-		Eigen::Matrix3f PF;
-		Eigen::Matrix3f PF_vol;
-		Eigen::Matrix3f gradientTemp;
-		Eigen::MatrixXf gradient; gradient.resize(3, 4);
+	//Get deformation gradient
+	tetRestStates.getDeformationGradient(t, particles, F_orig);
 
-		Eigen::Matrix3f U;
-		Eigen::Matrix3f U_orig;
-		Eigen::Matrix3f V;
-		bool isInverted;
+	const float minXVal = 0.577f;
+	const float maxXVal = 500.0f;
+
+	//elements that are neither inverted nor clamped skip the diagonalisation (see PBDInversionHandling.h)
+	const bool isDiagonalised = Policy::inversionHandling == INVERSION_HANDLING_FULL
+		|| (Policy::inversionHandling == INVERSION_HANDLING_ADAPTIVE && !isWithinSingularValueRange(F_orig, minXVal, maxXVal));
+
+	if (Policy::inversionHandling != INVERSION_HANDLING_NONE)
+	{
+		if (isDiagonalised)
+		{
+			++inversionCounts.numFullPath;
+		}
+		else
+		{
+			++inversionCounts.numFastPath;
+		}
+	}
 
-		Eigen::Matrix3f S;
-		Eigen::Matrix3f Fhat;
+	if (isDiagonalised)
+	{
+		//F = U * F_hat * V^T with rotations U and V; the smallest singular value is negative for inverted elements
+		svd3x3(F_orig, U, singularValues, V);
 
-		Eigen::Vector3f deltaX;
+		F = singularValues.asDiagonal();
 
-		//Mooney-Rivlin
-		Eigen::Matrix3f C;
+		for (unsigned char j = 0; j < 3; j++)
+		{
+			if (F(j, j) < minXVal)
+				F(j, j) = minXVal;
+		}
 
-		//for (int it = 0; it < settings.numConstraintIts; ++it)
+		for (unsigned char j = 0; j < 3; j++)
 		{
-			for (size_t t = r.begin(); t != r.end(); ++t)
+			if (std::abs(F(j, j)) > maxXVal)
 			{
-				float lambda;
-				float mu;
-				float anisotropyStrength;
-				Eigen::Vector3f anisotropyDirection;
-
-				if (settings.usePerTetMaterialAttributes)
+				if (F(j, j) < 0.0f)
 				{
-					lambda = settings.calculateLambda(settings.minYoungsModulus + tetrahedra[t].getPerTetYoungsModulus() * settings.youngsModulus, settings.poissonRatio);
-					mu = settings.calculateMu(settings.minYoungsModulus + tetrahedra[t].getPerTetYoungsModulus()* settings.youngsModulus, settings.poissonRatio);
-					anisotropyStrength = tetrahedra[t].getPerTetAnisotropyStrength();
-					anisotropyDirection = tetrahedra[t].getPerTetAnisotropyDirection();
+					F(j, j) = -maxXVal;
 				}
 				else
 				{
-					lambda = settings.lambda;
-					mu = settings.mu;
-					anisotropyStrength = settings.anisotropyParameter;
-					anisotropyDirection = settings.MR_a;
+					F(j, j) = maxXVal;
 				}
+			}
+		}
+	}
 
-				float lagrangeM;
-				float strainEnergy;
-				float Volume;
+	if (!isDiagonalised)
+	{
+		F = F_orig;
+	}
 
-				//Get deformation gradient
-				F_orig = tetrahedra[t].getDeformationGradient();
+	FInverseTranspose = F.inverse().transpose();
+	FTransposeF = F.transpose() * F * std::powf(F.determinant(), -2.0f / 3.0f);
 
-				FTransposeF = F_orig.transpose() * F_orig;
+	switch (Policy::materialModel)
+	{
+	case PBDSolverSettings::CONSTITUTIVE_MODEL::NEO_HOOKEAN:
+	{
+		Volume = rest.undeformedVolume;
 
-				if (!settings.disableInversionHandling)
-				{
-					//Eigen::EigenSolver<Eigen::Matrix3f> eigenSolver(FTransposeF);
-					//S = eigenSolver.pseudoEigenvalueMatrix(); //squared eigenvalues of F
-					//V = eigenSolver.pseudoEigenvectors(); //eigenvectors
-					eigenDecompositionCardano(FTransposeF, S, V);
-
-					for (int i = 0; i < 3; ++i)
-					{
-						if (S(i, i) < 0.0f)
-						{
-							S(i, i) = 0.0f;
-						}
-					}
-
-					//remove reflection from V if necessary
-					if (V.determinant() < 0.0f)
-					{
-						float minElementValue = 10000000000000;
-						int minElementIdx = 111;
-						for (int i = 0; i < 3; ++i)
-						{
-							if (S(i, i) < minElementValue)
-							{
-								minElementValue = S(i, i);
-								minElementIdx = i;
-							}
-						}
-						V.col(minElementIdx) *= -1.0f;
-						//V.col(0) *= -1.0f;
-					}
-
-					//determine entries of F
-					F.setZero();
-					for (int i = 0; i < 3; ++i)
-					{
-						F(i, i) = std::sqrtf(S(i, i));
-					}
-
-					U = F_orig * V * F.inverse();
-					U_orig = U;
-					int numEntriesNearZero = 0;
-					int idx = 0;
-					for (int i = 0; i < 3; ++i)
-					{
-						if (std::fabs(F(i, i)) < 1.0e-4f)
-						{
-							++numEntriesNearZero;
-							idx = i;
-						}
-					}
-
-					if (numEntriesNearZero > 0)
-					{
-						if (numEntriesNearZero == 1)
-						{
-							if (idx == 0)
-							{
-								U.col(0) = U.col(1).cross(U.col(2)).normalized();
-							}
-							else if (idx == 1)
-							{
-								U.col(1) = U.col(0).cross(U.col(2)).normalized();
-							}
-							else
-							{
-								U.col(2) = U.col(0).cross(U.col(1)).normalized();
-							}
-						}
-						else
-						{
-							U.setIdentity();
-						}
-					}
-
-					//remove reflection from U if necessary
-					if (U.determinant() < 0.0f)
-					{
-						float minElementValue = 1000000000000000;
-						int minElementIdx = 111;
-						for (int i = 0; i < 3; ++i)
-						{
-							if (F(i, i) < minElementValue)
-							{
-								minElementValue = F(i, i);
-								minElementIdx = i;
-							}
-						}
-
-						F(minElementIdx, minElementIdx) *= -1.0f;
-						U.col(minElementIdx) *= -1.0f;
-					}
-
-					const float minXVal = 0.577f;
-
-					for (unsigned char j = 0; j < 3; j++)
-					{
-						if (F(j, j) < minXVal)
-							F(j, j) = minXVal;
-					}
-
-					const float maxXVal = 500.0f;
-
-					for (unsigned char j = 0; j < 3; j++)
-					{
-						if (std::abs(F(j, j)) > maxXVal)
-						{
-							if (F(j, j) < 0.0f)
-							{
-								F(j, j) = -maxXVal;
-							}
-							else
-							{
-								F(j, j) = maxXVal;
-							}
-						}
-					}
-				}
+		//Compute Isotropic Invariants
+		float I1 = (FTransposeF).trace();
+		float I3 = (FTransposeF).determinant();
 
-				if (settings.disableInversionHandling)
-				{
-					F = tetrahedra[t].getDeformationGradient();
-				}
+		float logI3 = log(I3);
 
-				FInverseTranspose = F.inverse().transpose();
-				FTransposeF = F.transpose() * F * std::powf(F.determinant(), -2.0f / 3.0f);
+		/*PF = settings.mu * F - settings.mu * FInverseTranspose;
+		PF_vol =  ((settings.lambda * logI3) / 2.0) * FInverseTranspose;*/
+		//PF = settings.mu * F - settings.mu * FInverseTranspose
+		//   + ((settings.lambda * logI3) / 2.0) * FInverseTranspose;
+		PF = mu * F - mu * FInverseTranspose;
 
-				switch (settings.materialModel)
-				{
-				case PBDSolverSettings::CONSTITUTIVE_MODEL::NEO_HOOKEAN:
-				{
-					Volume = tetrahedra[t].getUndeformedVolume();
+		PF_vol = ((lambda * logI3) / 2.0) * FInverseTranspose;
 
-					//Compute Isotropic Invariants
-					float I1 = (FTransposeF).trace();
-					float I3 = (FTransposeF).determinant();
+		//Compute Strain Energy density field
+		strainEnergy = Volume * (0.5 * mu * (I1 - logI3 - 3.0) + (lambda / 8.0) * std::pow(logI3, 2.0));
 
-					float logI3 = log(I3);
+	}
+		break;
+	case PBDSolverSettings::CONSTITUTIVE_MODEL::NEO_HOOKEAN_FIBER:
+	{
+		 Volume = rest.undeformedVolume;
 
-					/*PF = settings.mu * F - settings.mu * FInverseTranspose;
-					PF_vol =  ((settings.lambda * logI3) / 2.0) * FInverseTranspose;*/
-					//PF = settings.mu * F - settings.mu * FInverseTranspose
-					//   + ((settings.lambda * logI3) / 2.0) * FInverseTranspose;
-					PF = mu * F - mu * FInverseTranspose;
+		 //Compute Isotropic Invariants
+		 float I1 = (FTransposeF).trace();
+		 float I3 = (FTransposeF).determinant();
 
-					PF_vol = ((lambda * logI3) / 2.0) * FInverseTranspose;
+		 float logI3 = log(I3);
 
-					//Compute Strain Energy density field
-					strainEnergy = Volume * (0.5 * mu * (I1 - logI3 - 3.0) + (lambda / 8.0) * std::pow(logI3, 2.0));
+		 Eigen::Vector3f rotated_a = anisotropyDirection;
 
-				}
-					break;
-				case PBDSolverSettings::CONSTITUTIVE_MODEL::NEO_HOOKEAN_FIBER:
-				{
-					 Volume = tetrahedra[t].getUndeformedVolume();
+		 if (isDiagonalised)
+		 {
+			 rotated_a = V.transpose() * anisotropyDirection;
+		 }
+
+		 //PF = settings.mu * F - settings.mu * FInverseTranspose;
+		 //PF_vol = ((settings.lambda * logI3) / 2.0) * FInverseTranspose;
+		 PF = settings.mu * F - settings.mu * FInverseTranspose;
+
+		 PF_vol = ((lambda * logI3) / 2.0) * FInverseTranspose;
 
-					 //Compute Isotropic Invariants
-					 float I1 = (FTransposeF).trace();
-					 float I3 = (FTransposeF).determinant();
+		 //Compute Strain Energy density field
+		 strainEnergy = Volume * (0.5 * mu * (I1 - logI3 - 3.0) + (lambda / 8.0) * std::pow(logI3, 2.0));
 
-					 float logI3 = log(I3);
+		 //STRETCH ('pseudo-invariant' of C)
+		 float stretch = std::sqrtf((rotated_a.transpose() * (1.0f * FTransposeF)).dot(rotated_a));
+		 //float lambda = sqrtf(sqr(F(0, 0)) * sqr(rotated_a[0])
+			// + sqr(F(1, 1)) * sqr(rotated_a[1])
+			// + sqr(F(2, 2)) * sqr(rotated_a[2]));
 
-					 Eigen::Vector3f rotated_a = V.transpose() * anisotropyDirection;
+		 strainEnergy += (anisotropyStrength / 2.0f) * std::pow(stretch - 1.0f, 2.0f);
 
-					 if (settings.disableInversionHandling)
-					 {
-						 rotated_a = anisotropyDirection;
-					 }
+		 PF += std::pow(F.determinant(), -2.0 / 3.0)
+			 * (anisotropyStrength * (stretch - 1.0f)
+			 * (kroneckerProduct(rotated_a, rotated_a) + (stretch / 3.0f) * FTransposeF.inverse()));
+	}
+		break;
+	case PBDSolverSettings::CONSTITUTIVE_MODEL::RUBIN_BODNER:
+	{
+																std::cout << "Rubin-Bodner Implementation Removed Temporarily!" << std::endl;
+	}
+		break;
+	default:
+		std::cout << "ERROR: No Constitutive Model Selected!" << std::endl;
+		break;
+	}
 
-					 //PF = settings.mu * F - settings.mu * FInverseTranspose;
-					 //PF_vol = ((settings.lambda * logI3) / 2.0) * FInverseTranspose;
-					 PF = settings.mu * F - settings.mu * FInverseTranspose;
+	//VISCOELASTICITY -----------------------------------------------------------------------------------------------------------
+	if (Policy::viscoelasticity != VISCOELASTICITY_NONE)
+	{
+		//FInverseTranspose = F.inverse();
+		/*PF = U * PF * V.transpose();*/
 
-					 PF_vol = ((lambda * logI3) / 2.0) * FInverseTranspose;
+		//F_orig = tet.getDeformationGradient();
 
-					 //Compute Strain Energy density field
-					 strainEnergy = Volume * (0.5 * mu * (I1 - logI3 - 3.0) + (lambda / 8.0) * std::pow(logI3, 2.0));
+		PF = F.inverse() * PF;
+		PF_vol = F.inverse() * PF_vol;
 
-					 //STRETCH ('pseudo-invariant' of C)
-					 float stretch = std::sqrtf((rotated_a.transpose() * (1.0f * FTransposeF)).dot(rotated_a));
-					 //float lambda = sqrtf(sqr(F(0, 0)) * sqr(rotated_a[0])
-						// + sqr(F(1, 1)) * sqr(rotated_a[1])
-						// + sqr(F(2, 2)) * sqr(rotated_a[2]));
+		//PF *= F.inverse();
+		//PF_vol *= F.inverse();
 
-					 strainEnergy += (anisotropyStrength / 2.0f) * std::pow(stretch - 1.0f, 2.0f);
+		//PF_vol *= FInverseTranspose;
 
-					 PF += std::pow(F.determinant(), -2.0 / 3.0)
-						 * (anisotropyStrength * (stretch - 1.0f)
-						 * (kroneckerProduct(rotated_a, rotated_a) + (stretch / 3.0f) * FTransposeF.inverse()));
-				}
-					break;
-				case PBDSolverSettings::CONSTITUTIVE_MODEL::RUBIN_BODNER:
+		/*FInverseTranspose = F_orig.inverse().transpose();
+
+		PF *= FInverseTranspose.transpose();
+		*/
+		Eigen::Matrix3f vMult;
+
+		//With the fast path the evaluations of a tet switch between F and F_hat, so the viscous stress is kept in the
+		//reference frame and rotated into the singular value frame (by V) for the diagonalised evaluations.
+		const bool rotateUpsilon = isDiagonalised && Policy::inversionHandling == INVERSION_HANDLING_ADAPTIVE;
+
+		if (Policy::viscoelasticity == VISCOELASTICITY_FULL_PRONY)
+		{
+			Eigen::Matrix3f temp;
+			temp.setZero();
+
+			for (int pComponent = 0; pComponent < settings.fullAlpha.size(); ++pComponent)
+			{
+				Eigen::Matrix3f upsilon = tetRestStates.getFullUpsilon(t, pComponent);
+				if (rotateUpsilon)
 				{
-																			std::cout << "Rubin-Bodner Implementation Removed Temporarily!" << std::endl;
-				}
-					break;
-				default:
-					std::cout << "ERROR: No Constitutive Model Selected!" << std::endl;
-					break;
+					upsilon = V.transpose() * upsilon * V;
 				}
 
-				//VISCOELASTICITY -----------------------------------------------------------------------------------------------------------
-				if (settings.alpha != 0.0f && settings.rho != 0.0f)
-				{
-					//FInverseTranspose = F.inverse();
-					/*PF = U * PF * V.transpose();*/
+				upsilon = (2.0f * settings.deltaT * settings.fullAlpha[pComponent] * PF
+					+ settings.fullRho[pComponent] * upsilon) / (settings.deltaT + settings.fullRho[pComponent]);
 
-					//F_orig = tetrahedra[t].getDeformationGradient();
+				temp += upsilon;
 
-					PF = F.inverse() * PF;
-					PF_vol = F.inverse() * PF_vol;
+				tetRestStates.getFullUpsilon(t, pComponent) = rotateUpsilon ? Eigen::Matrix3f(V * upsilon * V.transpose()) : upsilon;
+			}
 
-					//PF *= F.inverse();
-					//PF_vol *= F.inverse();
+			vMult = temp;
+		}
+		else
+		{
+			vMult = tetRestStates.getUpsilon(t);
+			if (rotateUpsilon)
+			{
+				vMult = V.transpose() * vMult * V;
+			}
+
+			vMult = (2.0f * settings.deltaT * settings.alpha * PF + settings.rho * vMult) / (settings.deltaT + settings.rho);
 
-					//PF_vol *= FInverseTranspose;
+			//if (it == settings.numConstraintIts - 1)
+			{
+				tetRestStates.getUpsilon(t) = rotateUpsilon ? Eigen::Matrix3f(V * vMult * V.transpose()) : vMult;
+				//std::cout << vMult << std::endl;
+				//std::cout << "---------" << std::endl;
+			}
+		}
 
-					/*FInverseTranspose = F_orig.inverse().transpose();
+		PF = 2.0f * PF_vol + 2.0f * PF - vMult * 1.0f;
 
-					PF *= FInverseTranspose.transpose();
-					*/
-					Eigen::Matrix3f vMult;
+		//if (settings.trackS)
+		//{
+		//	settings.tracker.S.push_back(PF);
+		//}
 
-					if (settings.useFullPronySeries)
-					{
-						Eigen::Matrix3f temp;
-						temp.setZero();
+		//PF = F_orig * PF;
+		//PF *= F;
+		PF = F * PF;
+	}
 
-						for (int pComponent = 0; pComponent < settings.fullAlpha.size(); ++pComponent)
-						{
-							temp += (2.0f * settings.deltaT * settings.fullAlpha[pComponent] * PF
-								+ settings.fullRho[pComponent] * tetrahedra[t].getFullUpsilon(pComponent)) / (settings.deltaT + settings.fullRho[pComponent]);
+	//PF = U * PF * V.transpose();
 
-							tetrahedra[t].getFullUpsilon(pComponent) = (2.0f * settings.deltaT * settings.fullAlpha[pComponent] * PF
-								+ settings.fullRho[pComponent] * tetrahedra[t].getFullUpsilon(pComponent)) / (settings.deltaT + settings.fullRho[pComponent]);
-						}
+	if (isDiagonalised)
+	{
+		PF = U * PF * V.transpose();
+	}
 
-						vMult = temp;
-					}
-					else
-					{
-						vMult = tetrahedra[t].getUpsilon();
+	//PF GRADIENT ---------------------------------------------------------------------------------------------------------------
 
-						vMult = (2.0f * settings.deltaT * settings.alpha * PF + settings.rho * vMult) / (settings.deltaT + settings.rho);
+	gradientTemp = Volume * PF * rest.referenceShapeMatrixInverseTranspose;
+	gradient.col(0) = gradientTemp.col(0);
+	gradient.col(1) = gradientTemp.col(1);
+	gradient.col(2) = gradientTemp.col(2);
+	gradient.col(3) = -gradientTemp.rowwise().sum();
 
-						//if (it == settings.numConstraintIts - 1)
-						{
-							tetrahedra[t].getUpsilon() = vMult;
-							//std::cout << vMult << std::endl;
-							//std::cout << "---------" << std::endl;
-						}
-					}
 
-					PF = 2.0f * PF_vol + 2.0f * PF - vMult * 1.0f;
+	//XPBD ----------------------------------------------------------------------------------------------------------------------
 
-					//if (settings.trackS)
-					//{
-					//	settings.tracker.S.push_back(PF);
-					//}
+	if (Policy::xpbd)
+	{
+		float weightedSquaredGradientNorm = 0.0f;
 
-					//PF = F_orig * PF;
-					//PF *= F;
-					PF = F * PF;
-				}
+		for (int cI = 0; cI < 4; ++cI)
+		{
+			weightedSquaredGradientNorm += particles.inverseMass(rest.vertexIndices[cI]) * gradient.col(cI).squaredNorm();
+		}
 
-				//PF = U * PF * V.transpose();
+		//no deformation
+		if (weightedSquaredGradientNorm < 1e-20 || strainEnergy < 1e-20)
+		{
+			++inversionCounts.numZeroDenominatorSkips;
+			return false;
+		}
 
-				if (!settings.disableInversionHandling)
-				{
-					PF = U * PF * V.transpose();
-				}
+		float deltaLagrangeMultiplier;
+		lagrangeM = laneComplianceMultiplier(strainEnergy, weightedSquaredGradientNorm, youngsModulus,
+			tetRestStates.getLagrangeMultiplier(t), settings.deltaT, deltaLagrangeMultiplier);
 
-				//PF GRADIENT ---------------------------------------------------------------------------------------------------------------
+		if (std::isnan(lagrangeM) || std::isinf(lagrangeM))
+		{
+			++inversionCounts.numInvalidMultiplierSkips;
+			return false;
+		}
 
-				gradientTemp = Volume * PF * tetrahedra[t].getReferenceShapeMatrixInverseTranspose();
-				gradient.col(0) = gradientTemp.col(0);
-				gradient.col(1) = gradientTemp.col(1);
-				gradient.col(2) = gradientTemp.col(2);
-				gradient.col(3) = -gradientTemp.rowwise().sum();
+		tetRestStates.getLagrangeMultiplier(t) += deltaLagrangeMultiplier;
 
+		return true;
+	}
 
-				//PBD MAIN ROUTINE-----------------------------------------------------------------------------------------------------------
+	//PBD MAIN ROUTINE-----------------------------------------------------------------------------------------------------------
 
-				float denominator = 0.0;
+	float denominator = 0.0;
 
-				for (int cI = 0; cI < 4; ++cI)
-				{
-					if (tetrahedra[t].get_x(cI).inverseMass() != 0)
-					{
-						denominator += tetrahedra[t].get_x(cI).inverseMass()
-							* gradient.col(cI).lpNorm<2>();
-					}
-				}
+	for (int cI = 0; cI < 4; ++cI)
+	{
+		if (particles.inverseMass(rest.vertexIndices[cI]) != 0)
+		{
+			denominator += particles.inverseMass(rest.vertexIndices[cI])
+				* gradient.col(cI).lpNorm<2>();
+		}
+	}
 
-				//prevent division by zero if there is no deformation
-				if (denominator < 1e-20)
-				{
-					continue;
-				}
+	//prevent division by zero if there is no deformation
+	if (denominator < 1e-20)
+	{
+		++inversionCounts.numZeroDenominatorSkips;
+		return false;
+	}
+
+	lagrangeM = -(strainEnergy / denominator);
+
+
+	if (std::isnan(lagrangeM) || std::isinf(lagrangeM))
+	{
+		++inversionCounts.numInvalidMultiplierSkips;
+		return false;
+	}
 
-				lagrangeM = -(strainEnergy / denominator);
+	return true;
+}
 
+//Moves 'proposedEndpoint' out of the collision spheres, along the direction back towards 'position'.
+inline void correctEndpointForCollisionSpheres(const Eigen::Vector3f& position, Eigen::Vector3f& proposedEndpoint,
+	std::vector<CollisionSphere>& collisionGeometry3, const PBDSolverSettings& settings)
+{
+	float penetrationDistance;
+	bool penetrates;
+	for (int cS = 0; cS < collisionGeometry3.size(); ++cS)
+	{
+		collisionGeometry3[cS].checkForSinglePointIntersection_SAFE(proposedEndpoint, penetrationDistance, penetrates,
+			settings.collisionSpheresRadius[cS]);
 
-				if (std::isnan(lagrangeM) || std::isinf(lagrangeM))
+		if (penetrates)
+		{
+			if ((position - proposedEndpoint).squaredNorm() != 0.0f)
+			{
+				Eigen::Vector3f temp = penetrationDistance * (position - proposedEndpoint).normalized();
+				if (std::sqrtf(temp.squaredNorm()) > std::sqrtf((position - proposedEndpoint).squaredNorm()))
 				{
-					continue;
+					proposedEndpoint = position;
 				}
 				else
 				{
-					//std::cout << strainEnergy << ",";
-
-					//Acquire Lock
-					tbb::queuing_mutex::scoped_lock lock(mutex);
-
-					for (int cI = 0; cI < 4; ++cI)
-					{
-						if (tetrahedra[t].get_x(cI).inverseMass() != 0)
-						{
-							if (!settings.disablePositionCorrection)
-							{
-								deltaX = (tetrahedra[t].get_x(cI).inverseMass()
-									* lagrangeM) * gradient.col(cI);
-
-								Eigen::Vector3f proposedEndpoint = tetrahedra[t].get_x(cI).position() + deltaX;
-								Eigen::Vector3f normal;
-								Eigen::Vector3f correction;
-
-								float penetrationDistance;
-								bool penetrates;
-								for (int cS = 0; cS < collisionGeometry3.size(); ++cS)
-								{
-									collisionGeometry3[cS].checkForSinglePointIntersection_SAFE(proposedEndpoint, penetrationDistance, penetrates,
-										settings.collisionSpheresRadius[cS]);
-
-									if (penetrates)
-									{
-										if (!(tetrahedra[t].get_x(cI).position() - proposedEndpoint).squaredNorm() == 0.0f)
-										{
-											Eigen::Vector3f temp = penetrationDistance * (tetrahedra[t].get_x(cI).position() - proposedEndpoint).normalized();
-											if (std::sqrtf(temp.squaredNorm()) > std::sqrtf((tetrahedra[t].get_x(cI).position() - proposedEndpoint).squaredNorm()))
-											{
-												proposedEndpoint = tetrahedra[t].get_x(cI).position();
-											}
-											else
-											{
-												proposedEndpoint += penetrationDistance * (tetrahedra[t].get_x(cI).position() - proposedEndpoint).normalized();
-											}
-										}
-									}
-
-									//collisionGeometry3[cS].checkForSinglePointIntersection_normalReflection_SAFE(tetrahedra[t].get_x(cI).previousPosition(),
-									//	proposedEndpoint, penetrationDistance, penetrates, normal, correction,
-									//	settings.collisionSpheresRadius[cS]);
-
-									//if (penetrates)
-									//{
-									//	
-									//	proposedEndpoint = correction;
-									//}
-								}
-								tetrahedra[t].get_x(cI).position() = proposedEndpoint;
-
-								//tetrahedra[t].get_x(cI).position() += deltaX;
-
-								//if (settings.trackAverageDeltaXLength)
-								//{
-								//	float value = deltaX.squaredNorm();
-								//	if (!std::isnan(value) && !std::isinf(value))
-								//	{
-								//		averageDeltaXLengthAccumulator += value;
-								//		averageDeltaXLengthAccumulatorCounter += 1.0f;
-								//	}
-								//}
-							}
-						}
-					}
+					proposedEndpoint += penetrationDistance * (position - proposedEndpoint).normalized();
+				}
+			}
+		}
+
+		//collisionGeometry3[cS].checkForSinglePointIntersection_normalReflection_SAFE(tetrahedra[t].get_x(cI).previousPosition(),
+		//	proposedEndpoint, penetrationDistance, penetrates, normal, correction,
+		//	settings.collisionSpheresRadius[cS]);
+
+		//if (penetrates)
+		//{
+		//	
+		//	proposedEndpoint = correction;
+		//}
+	}
+}
+
+//Applies the corrections computed by computeConstraintGradientVISCOELASTIC to the particles of one tetrahedron.
+template<typename Policy>
+inline void applyPositionCorrectionsVISCOELASTIC(const PBDTetRestState& rest, PBDParticleStore& particles,
+	const Eigen::MatrixXf& gradient, float lagrangeM,
+	std::vector<CollisionSphere>& collisionGeometry3, const PBDSolverSettings& settings, PBDProjectionResidual& residual)
+{
+	Eigen::Vector3f deltaX;
+
+	for (int cI = 0; cI < 4; ++cI)
+	{
+		const int p = rest.vertexIndices[cI];
+
+		if (particles.inverseMass(p) != 0)
+		{
+			if (!settings.disablePositionCorrection)
+			{
+				deltaX = (particles.inverseMass(p)
+					* lagrangeM) * gradient.col(cI);
+				residual.add(deltaX);
+
+				Eigen::Vector3f proposedEndpoint = particles.position(p) + deltaX;
+				if (Policy::colliders)
+				{
+					correctEndpointForCollisionSpheres(particles.position(p), proposedEndpoint,
+						collisionGeometry3, settings);
 				}
+
+				particles.position(p) = proposedEndpoint;
 			}
+		}
+	}
+}
+
+//Coloured projection kernel (PBDConstraintKernels::ProjectTetrahedraFunction) for one policy.
+template<typename Policy>
+void projectTetrahedraVISCOELASTIC(PBDTetRestStateTable& tetRestStates, PBDParticleStore& particles,
+	PBDSolverSettings& settings, std::vector<CollisionSphere>& collisionGeometry3,
+	const int* tetIdxs, int numTets, PBDInversionHandlingCounts& inversionCounts, PBDProjectionResidual& residual)
+{
+	Eigen::MatrixXf gradient; gradient.resize(3, 4);
+	float lagrangeM;
+
+	for (int i = 0; i < numTets; ++i)
+	{
+		const int t = tetIdxs[i];
+
+		if (!computeConstraintGradientVISCOELASTIC<Policy>(tetRestStates, t, particles, settings, gradient, lagrangeM, inversionCounts))
+		{
+			continue;
+		}
 
-			if (settings.printStrainEnergy || settings.printStrainEnergyToFile)
+		applyPositionCorrectionsVISCOELASTIC<Policy>(tetRestStates.getRestState(t), particles, gradient, lagrangeM,
+			collisionGeometry3, settings, residual);
+	}
+}
+
+//Jacobi kernel (PBDConstraintKernels::ComputeJacobiCorrectionsFunction) for one policy: computes the corrections of
+//the tetrahedra [begin, end) and stores them per tet vertex in 'deltas' (4 entries per tet; zero if a vertex is
+//not corrected). Nothing is written to the particles.
+template<typename Policy>
+void computeJacobiCorrectionsVISCOELASTIC(PBDTetRestStateTable& tetRestStates, PBDParticleStore& particles,
+	PBDSolverSettings& settings, std::vector<Eigen::Vector3f>& deltas, std::vector<char>& isCorrected,
+	int begin, int end, PBDInversionHandlingCounts& inversionCounts)
+{
+	Eigen::MatrixXf gradient; gradient.resize(3, 4);
+	float lagrangeM;
+
+	for (int t = begin; t != end; ++t)
+	{
+		bool valid = computeConstraintGradientVISCOELASTIC<Policy>(tetRestStates, t, particles, settings, gradient, lagrangeM, inversionCounts);
+
+		const PBDTetRestState& rest = tetRestStates.getRestState(t);
+
+		for (int cI = 0; cI < 4; ++cI)
+		{
+			const float inverseMass = particles.inverseMass(rest.vertexIndices[cI]);
+
+			if (valid && inverseMass != 0)
 			{
-				//calculateTotalStrainEnergy(tetrahedra, particles, settings, it, strainEnergyfile);
+				deltas[t * 4 + cI] = (inverseMass * lagrangeM) * gradient.col(cI);
+				isCorrected[t * 4 + cI] = 1;
 			}
+			else
+			{
+				deltas[t * 4 + cI].setZero();
+				isCorrected[t * 4 + cI] = 0;
+			}
+		}
+	}
+}
+
+//Projects the tetrahedra of a single colour (see PBDConstraintColoring). As no two tetrahedra of
+//a colour share a particle, the position write-back needs no lock.
+struct PBDSolverTBB
+{
+	PBDSolverTBB(PBDTetRestStateTable& in_tetRestStates, PBDParticleStore& in_particles, PBDSolverSettings& in_settings,
+	std::vector<CollisionSphere>& in_collisionGeometry3,
+	const std::vector<int>& in_colorTetIdxs, const PBDConstraintKernels& in_kernels,
+	PBDInversionHandlingCounters& in_inversionCounters, PBDProjectionResidualReduction& in_residualReduction) : tetRestStates(in_tetRestStates),
+	particles(in_particles), settings(in_settings), collisionGeometry3(in_collisionGeometry3),
+	colorTetIdxs(in_colorTetIdxs), kernels(in_kernels), inversionCounters(in_inversionCounters),
+	residualReduction(in_residualReduction)
+	{
+		//nothing else to do
+	}
+
+	PBDTetRestStateTable& tetRestStates;
+	PBDParticleStore& particles;
+	PBDSolverSettings& settings;
+	std::vector<CollisionSphere>& collisionGeometry3;
+
+	const std::vector<int>& colorTetIdxs;
+
+	const PBDConstraintKernels& kernels;
+
+	PBDInversionHandlingCounters& inversionCounters;
+
+	PBDProjectionResidualReduction& residualReduction;
+
+	void operator()(const tbb::blocked_range<size_t>& r) const
+	{
+		PBDInversionHandlingCounts inversionCounts;
+		PBDProjectionResidual residual;
+
+		kernels.projectTetrahedra(tetRestStates, particles, settings, collisionGeometry3,
+			&colorTetIdxs[r.begin()], r.size(), inversionCounts, residual);
+
+		inversionCounters.add(inversionCounts);
+		residualReduction.add(residual);
+	}
+};
+
+//Jacobi variant: computes the corrections of a range of tetrahedra against the positions of the previous
+//sweep (see computeJacobiCorrectionsVISCOELASTIC), so the whole mesh can be processed in a single parallel_for.
+//If 'isTetActive' is given, only the active tets are evaluated; the others correct nothing.
+struct PBDSolverJacobiTBB
+{
+	PBDSolverJacobiTBB(PBDTetRestStateTable& in_tetRestStates, PBDParticleStore& in_particles, PBDSolverSettings& in_settings,
+	std::vector<Eigen::Vector3f>& in_deltas, std::vector<char>& in_isCorrected, const PBDConstraintKernels& in_kernels,
+	PBDInversionHandlingCounters& in_inversionCounters, const std::vector<char>* in_isTetActive) : tetRestStates(in_tetRestStates),
+	particles(in_particles), settings(in_settings), deltas(in_deltas), isCorrected(in_isCorrected),
+	kernels(in_kernels), inversionCounters(in_inversionCounters), isTetActive(in_isTetActive)
+	{
+		//nothing else to do
+	}
+
+	PBDTetRestStateTable& tetRestStates;
+	PBDParticleStore& particles;
+	PBDSolverSettings& settings;
+	std::vector<Eigen::Vector3f>& deltas;
+	std::vector<char>& isCorrected;
+	const PBDConstraintKernels& kernels;
+	PBDInversionHandlingCounters& inversionCounters;
+	const std::vector<char>* isTetActive;
 
-			//if (settings.trackAverageDeltaXLength)
-			//{
-			//	if (averageDeltaXLengthAccumulatorCounter != 0.0f)
-			//	{
-			//		settings.tracker.averageDeltaXLength.push_back(averageDeltaXLengthAccumulator / averageDeltaXLengthAccumulatorCounter);
-			//	}
-			//	else
-			//	{
-			//		settings.tracker.averageDeltaXLength.push_back(0.0f);
-			//	}
-			//}
-
-			//for (int pC = 0; pC < probabilisticConstraints.size(); ++pC)
-			//{
-			//	probabilisticConstraints[pC].project(*particles);
-			//}
-
-			//if (settings.printStrainEnergyToFile)
-			//{
-			//	strainEnergyfile.close();
-			//}
-
-			//if (inversionHandled)
-			//{
-			//	std::cout << "Inversion handled successfully!" << std::endl;
-			//}
+	void operator()(const tbb::blocked_range<size_t>& r) const
+	{
+		PBDInversionHandlingCounts inversionCounts;
+
+		if (isTetActive == NULL)
+		{
+			kernels.computeJacobiCorrections(tetRestStates, particles, settings, deltas, isCorrected,
+				r.begin(), r.end(), inversionCounts);
 		}
+		else
+		{
+			//runs of active tets go to the kernel in one call
+			int t = r.begin();
+			while (t != r.end())
+			{
+				const int runBegin = t;
+				const char runIsActive = (*isTetActive)[t];
+				while (t != r.end() && (*isTetActive)[t] == runIsActive)
+				{
+					++t;
+				}
+
+				if (runIsActive)
+				{
+					kernels.computeJacobiCorrections(tetRestStates, particles, settings, deltas, isCorrected,
+						runBegin, t, inversionCounts);
+				}
+				else
+				{
+					std::fill(isCorrected.begin() + runBegin * 4, isCorrected.begin() + t * 4, 0);
+				}
+			}
+		}
+
+		inversionCounters.add(inversionCounts);
 	}
 };
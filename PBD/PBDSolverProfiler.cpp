@@ -0,0 +1,272 @@
+#include "PBDSolverProfiler.h"
+
+#include <iostream>
+#include <fstream>
+
+PBDSolverFrameProfile::PBDSolverFrameProfile()
+{
+	frame = 0;
+	for (int p = 0; p < NUM_PBD_SOLVER_PHASES; ++p)
+	{
+		phaseTimes[p] = 0.0;
+		numPhaseEvents[p] = 0;
+	}
+	numCollisionCorrections = 0;
+}
+
+PBDSolverProfiler::PBDSolverProfiler()
+{
+	m_isEnabled = false;
+	m_isInFrame = false;
+	m_currentSubstep = 0;
+	m_numCollisionCorrections = 0;
+	m_origin = tbb::tick_count::now();
+}
+
+
+PBDSolverProfiler::~PBDSolverProfiler()
+{
+}
+
+void
+PBDSolverProfiler::setEnabled(bool enabled)
+{
+	if (enabled && !m_isEnabled)
+	{
+		m_origin = tbb::tick_count::now();
+	}
+	m_isEnabled = enabled;
+}
+
+void
+PBDSolverProfiler::beginFrame(int frame, const PBDInversionHandlingCounts& constraintCounts)
+{
+	if (!m_isEnabled)
+	{
+		return;
+	}
+
+	PBDSolverFrameProfile profile;
+	profile.frame = frame;
+	m_frames.push_back(profile);
+
+	m_frameStartCounts = constraintCounts;
+	m_numCollisionCorrections = 0;
+	m_currentSubstep = 0;
+	m_isInFrame = true;
+}
+
+void
+PBDSolverProfiler::endFrame(const PBDInversionHandlingCounts& constraintCounts)
+{
+	if (!m_isEnabled || !m_isInFrame)
+	{
+		return;
+	}
+
+	PBDSolverFrameProfile& profile = m_frames.back();
+	profile.constraintCounts.numFastPath = constraintCounts.numFastPath - m_frameStartCounts.numFastPath;
+	profile.constraintCounts.numFullPath = constraintCounts.numFullPath - m_frameStartCounts.numFullPath;
+	profile.constraintCounts.numEvaluations = constraintCounts.numEvaluations - m_frameStartCounts.numEvaluations;
+	profile.constraintCounts.numZeroDenominatorSkips = constraintCounts.numZeroDenominatorSkips
+		- m_frameStartCounts.numZeroDenominatorSkips;
+	profile.constraintCounts.numInvalidMultiplierSkips = constraintCounts.numInvalidMultiplierSkips
+		- m_frameStartCounts.numInvalidMultiplierSkips;
+	profile.numCollisionCorrections = m_numCollisionCorrections;
+
+	m_isInFrame = false;
+}
+
+void
+PBDSolverProfiler::addPhase(PBD_SOLVER_PHASE phase, const tbb::tick_count& start, int iteration)
+{
+	if (!m_isEnabled || !m_isInFrame)
+	{
+		return;
+	}
+
+	const tbb::tick_count end = tbb::tick_count::now();
+
+	PBDSolverPhaseEvent event;
+	event.phase = phase;
+	event.frame = m_frames.back().frame;
+	event.substep = m_currentSubstep;
+	event.iteration = iteration;
+	event.start = (start - m_origin).seconds();
+	event.duration = (end - start).seconds();
+	m_events.push_back(event);
+
+	m_frames.back().phaseTimes[phase] += event.duration;
+	++m_frames.back().numPhaseEvents[phase];
+}
+
+double
+PBDSolverProfiler::getTotalPhaseTime(PBD_SOLVER_PHASE phase) const
+{
+	double sum = 0.0;
+	for (int f = 0; f < m_frames.size(); ++f)
+	{
+		sum += m_frames[f].phaseTimes[phase];
+	}
+	return sum;
+}
+
+bool
+PBDSolverProfiler::writeCSV(const std::string& filename) const
+{
+	std::ofstream file(filename);
+	if (!file.is_open())
+	{
+		std::cout << "ERROR: Could not write [ " << filename << " ]." << std::endl;
+		return false;
+	}
+
+	file << "frame";
+	for (int p = 0; p < NUM_PBD_SOLVER_PHASES; ++p)
+	{
+		file << "," << getPhaseName((PBD_SOLVER_PHASE)p) << "_ms";
+	}
+	file << ",projection_iterations,evaluated_tets,zero_denominator_skips,invalid_multiplier_skips,inversion_fast_path,"
+		<< "inversion_full_path,collision_corrections" << std::endl;
+
+	for (int f = 0; f < m_frames.size(); ++f)
+	{
+		const PBDSolverFrameProfile& profile = m_frames[f];
+
+		file << profile.frame;
+		for (int p = 0; p < NUM_PBD_SOLVER_PHASES; ++p)
+		{
+			file << "," << 1000.0 * profile.phaseTimes[p];
+		}
+		file << "," << profile.numPhaseEvents[PHASE_PROJECTION_ITERATION] << "," << profile.constraintCounts.numEvaluations
+			<< "," << profile.constraintCounts.numZeroDenominatorSkips << "," << profile.constraintCounts.numInvalidMultiplierSkips
+			<< "," << profile.constraintCounts.numFastPath << "," << profile.constraintCounts.numFullPath
+			<< "," << profile.numCollisionCorrections << std::endl;
+	}
+
+	return true;
+}
+
+bool
+PBDSolverProfiler::writeChromeTrace(const std::string& filename) const
+{
+	std::ofstream file(filename);
+	if (!file.is_open())
+	{
+		std::cout << "ERROR: Could not write [ " << filename << " ]." << std::endl;
+		return false;
+	}
+
+	//complete events ("X") in microseconds; the advance phase encloses the others, so they nest in the viewer
+	file << "{\"traceEvents\":[" << std::endl;
+
+	bool isFirst = true;
+	for (int e = 0; e < m_events.size(); ++e)
+	{
+		const PBDSolverPhaseEvent& event = m_events[e];
+
+		file << (isFirst ? "" : ",\n") << "{\"name\":\"" << getPhaseName(event.phase) << "\",\"cat\":\"PBDSolver\",\"ph\":\"X\""
+			<< ",\"ts\":" << 1.0e6 * event.start << ",\"dur\":" << 1.0e6 * event.duration << ",\"pid\":0,\"tid\":0"
+			<< ",\"args\":{\"frame\":" << event.frame << ",\"substep\":" << event.substep << ",\"iteration\":" << event.iteration << "}}";
+		isFirst = false;
+	}
+
+	//counter tracks, one sample per frame at the end of its advance phase
+	for (int e = 0; e < m_events.size(); ++e)
+	{
+		const PBDSolverPhaseEvent& event = m_events[e];
+		if (event.phase != PHASE_ADVANCE)
+		{
+			continue;
+		}
+
+		for (int f = 0; f < m_frames.size(); ++f)
+		{
+			const PBDSolverFrameProfile& profile = m_frames[f];
+			if (profile.frame != event.frame)
+			{
+				continue;
+			}
+
+			file << (isFirst ? "" : ",\n") << "{\"name\":\"constraints\",\"ph\":\"C\",\"ts\":" << 1.0e6 * (event.start + event.duration)
+				<< ",\"pid\":0,\"args\":{\"evaluated\":" << profile.constraintCounts.numEvaluations
+				<< ",\"zeroDenominatorSkips\":" << profile.constraintCounts.numZeroDenominatorSkips
+				<< ",\"invalidMultiplierSkips\":" << profile.constraintCounts.numInvalidMultiplierSkips
+				<< ",\"inversionFullPath\":" << profile.constraintCounts.numFullPath << "}}";
+			file << ",\n{\"name\":\"collisionCorrections\",\"ph\":\"C\",\"ts\":" << 1.0e6 * (event.start + event.duration)
+				<< ",\"pid\":0,\"args\":{\"corrections\":" << profile.numCollisionCorrections << "}}";
+			isFirst = false;
+			break;
+		}
+	}
+
+	file << std::endl << "],\"displayTimeUnit\":\"ms\"}" << std::endl;
+
+	return true;
+}
+
+void
+PBDSolverProfiler::print() const
+{
+	if (m_frames.empty())
+	{
+		return;
+	}
+
+	const double numFrames = (double)m_frames.size();
+
+	std::cout << "Solver profile (" << m_frames.size() << " frames, average per frame):" << std::endl;
+	for (int p = 0; p < NUM_PBD_SOLVER_PHASES; ++p)
+	{
+		std::cout << "	" << getPhaseName((PBD_SOLVER_PHASE)p) << ": " << 1000.0 * getTotalPhaseTime((PBD_SOLVER_PHASE)p) / numFrames
+			<< "ms" << std::endl;
+	}
+
+	PBDSolverFrameProfile total;
+	for (int f = 0; f < m_frames.size(); ++f)
+	{
+		total.numPhaseEvents[PHASE_PROJECTION_ITERATION] += m_frames[f].numPhaseEvents[PHASE_PROJECTION_ITERATION];
+		total.constraintCounts.numEvaluations += m_frames[f].constraintCounts.numEvaluations;
+		total.constraintCounts.numZeroDenominatorSkips += m_frames[f].constraintCounts.numZeroDenominatorSkips;
+		total.constraintCounts.numInvalidMultiplierSkips += m_frames[f].constraintCounts.numInvalidMultiplierSkips;
+		total.constraintCounts.numFullPath += m_frames[f].constraintCounts.numFullPath;
+		total.numCollisionCorrections += m_frames[f].numCollisionCorrections;
+	}
+
+	std::cout << "	" << total.numPhaseEvents[PHASE_PROJECTION_ITERATION] / numFrames << " iterations, "
+		<< total.constraintCounts.numEvaluations / numFrames << " evaluated tets ("
+		<< total.constraintCounts.numZeroDenominatorSkips / numFrames << " zero denominator, "
+		<< total.constraintCounts.numInvalidMultiplierSkips / numFrames << " invalid multiplier skips; "
+		<< total.constraintCounts.numFullPath / numFrames << " diagonalised), "
+		<< total.numCollisionCorrections / numFrames << " collision corrections" << std::endl;
+}
+
+void
+PBDSolverProfiler::clear()
+{
+	m_frames.clear();
+	m_events.clear();
+	m_isInFrame = false;
+}
+
+const char*
+PBDSolverProfiler::getPhaseName(PBD_SOLVER_PHASE phase)
+{
+	switch (phase)
+	{
+	case PHASE_ADVANCE:
+		return "advance";
+	case PHASE_PREDICT:
+		return "predict";
+	case PHASE_COLLISIONS:
+		return "collisions";
+	case PHASE_PROJECTION:
+		return "projection";
+	case PHASE_PROJECTION_ITERATION:
+		return "projection_iteration";
+	case PHASE_VELOCITY_UPDATE_AND_SWAP:
+		return "velocity_update_and_swap";
+	default:
+		return "unknown";
+	}
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <atomic>
+
+#include <tbb\tick_count.h>
+
+#include "PBDInversionHandling.h"
+
+//Phases of PBDSolver::advanceSystem. A projection iteration is one sweep of the multi-threaded or Jacobi solver;
+//the projection phase covers all of them plus the coarse levels of the multilevel mode.
+enum PBD_SOLVER_PHASE
+{
+	PHASE_ADVANCE = 0,
+	PHASE_PREDICT,
+	PHASE_COLLISIONS,
+	PHASE_PROJECTION,
+	PHASE_PROJECTION_ITERATION,
+	PHASE_VELOCITY_UPDATE_AND_SWAP,
+	NUM_PBD_SOLVER_PHASES
+};
+
+//One timed phase; times in seconds since the profiler was enabled
+struct PBDSolverPhaseEvent
+{
+	PBD_SOLVER_PHASE phase;
+	int frame;
+	int substep;
+	int iteration;
+	double start;
+	double duration;
+};
+
+//Phase times (summed over substeps and iterations) and counters of one advanceSystem call
+struct PBDSolverFrameProfile
+{
+	PBDSolverFrameProfile();
+
+	int frame;
+	double phaseTimes[NUM_PBD_SOLVER_PHASES];
+	int numPhaseEvents[NUM_PBD_SOLVER_PHASES];
+
+	//constraint evaluations of the multi-threaded and Jacobi solvers, see PBDInversionHandlingCounts
+	PBDInversionHandlingCounts constraintCounts;
+
+	//particles moved out of a collision sphere by the collision phase
+	long long numCollisionCorrections;
+};
+
+//Per phase wall times and constraint counters of PBDSolver (see PBDSolverSettings::enableProfiling). Every phase
+//is recorded as an event and summed into the profile of its frame; both lists grow until clear() is called and can
+//be written as CSV (one row per frame) or as a Chrome trace (chrome://tracing, one slice per event).
+class PBDSolverProfiler
+{
+public:
+	PBDSolverProfiler();
+	~PBDSolverProfiler();
+
+	void setEnabled(bool enabled);
+
+	bool isEnabled() const { return m_isEnabled; }
+
+	//'constraintCounts' are the solver's running totals, the frame gets the difference to those of endFrame
+	void beginFrame(int frame, const PBDInversionHandlingCounts& constraintCounts);
+	void endFrame(const PBDInversionHandlingCounts& constraintCounts);
+
+	void setSubstep(int substep) { m_currentSubstep = substep; }
+
+	//Records the phase from 'start' until now; 'iteration' is -1 for phases other than PHASE_PROJECTION_ITERATION
+	void addPhase(PBD_SOLVER_PHASE phase, const tbb::tick_count& start, int iteration = -1);
+
+	//Thread safe
+	void addCollisionCorrections(long long numCorrections) { m_numCollisionCorrections += numCorrections; }
+
+	const std::vector<PBDSolverFrameProfile>& getFrames() const { return m_frames; }
+
+	const std::vector<PBDSolverPhaseEvent>& getEvents() const { return m_events; }
+
+	//Phase time summed over all recorded frames
+	double getTotalPhaseTime(PBD_SOLVER_PHASE phase) const;
+
+	bool writeCSV(const std::string& filename) const;
+
+	bool writeChromeTrace(const std::string& filename) const;
+
+	void print() const;
+
+	void clear();
+
+	static const char* getPhaseName(PBD_SOLVER_PHASE phase);
+
+private:
+	bool m_isEnabled;
+	bool m_isInFrame;
+
+	tbb::tick_count m_origin;
+
+	int m_currentSubstep;
+	PBDInversionHandlingCounts m_frameStartCounts;
+	std::atomic<long long> m_numCollisionCorrections;
+
+	std::vector<PBDSolverFrameProfile> m_frames;
+	std::vector<PBDSolverPhaseEvent> m_events;
+};
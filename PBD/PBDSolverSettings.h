@@ -27,6 +27,50 @@ struct PBDSolverSettings
 
 	int numConstraintIts;
 
+	//The multi-threaded and Jacobi solvers stop iterating once no particle was moved by more than this in a sweep,
+	//i.e. numConstraintIts becomes the maximum. 0 always runs numConstraintIts sweeps.
+	float constraintTolerance;
+
+	//Chebyshev acceleration of the multi-threaded and Jacobi sweeps (see PBDChebyshevAcceleration). The first
+	//chebyshevWarmUpIts sweeps of every step are plain ones; chebyshevSpectralRadius 0 estimates it from them.
+	bool useChebyshevAcceleration;
+	int chebyshevWarmUpIts;
+	float chebyshevSpectralRadius;
+
+	//Multilevel mode of the multi-threaded and Jacobi solvers (see PBDMultilevelHierarchy): before the fine sweeps,
+	//numCoarseLevelIts sweeps run on each of numCoarseLevels coarser tet grids and their corrections are prolongated
+	//to the mesh. 0 disables it. With XPBD the coarse corrections do not enter the fine Lagrange multipliers, which
+	//biases the step slightly towards the stiffer coarse solution.
+	int numCoarseLevels;
+	int numCoarseLevelIts;
+
+	//Sleeping of quiescent regions in the multi-threaded and Jacobi solvers (see PBDActivityTracker): particles whose
+	//neighbourhood stayed slower than sleepVelocityThreshold for numStepsToSleep steps, and tets with only such
+	//particles, are skipped. Short windows put slowly creeping, loaded regions to sleep, which then wake again.
+	bool useSleeping;
+	float sleepVelocityThreshold;
+	int numStepsToSleep;
+
+	//Warm starting: every step starts from the predicted positions plus warmStartDecay times the constraint and
+	//collision correction of the last step, and (XPBD) from warmStartDecay times the last step's multipliers instead
+	//of zero. Pays off when consecutive steps are nearly identical (quasi-static loading). The cached correction acts
+	//like an explicit force prediction, so decays close to 1 can destabilise stiff meshes with few iterations.
+	bool useWarmStarting;
+	float warmStartDecay;
+
+	//Geometric constraints projected after the energy constraints in every iteration of the multi-threaded and Jacobi
+	//solvers (see PBDGeometricConstraints): edge lengths and signed tet volumes are pulled towards their rest values.
+	//The stiffnesses in [0, 1] are the fractions reached after numConstraintIts iterations; 1 enforces them fully.
+	bool useDistanceConstraints;
+	float distanceConstraintStiffness;
+	bool useVolumeConstraints;
+	float volumeConstraintStiffness;
+
+	//Substepping: advanceSystem splits every frame (deltaT) into numSubsteps steps of deltaT / numSubsteps, each with
+	//numConstraintIts iterations. The moving drivers are interpolated at the substep times. The velocities are
+	//reconstructed from float positions, which limits the useful substep size (~0.3ms on a metre-sized mesh).
+	int numSubsteps;
+
 	int numTetrahedraIterations;
 
 	//Lame coefficients
@@ -46,17 +90,24 @@ struct PBDSolverSettings
 	std::vector<float> fullAlpha;
 	std::vector<float> fullRho;
 
-	//For SOR
+	//Jacobi solver: scale of the averaged corrections. Multi-threaded solver with useSOR: over-relaxation factor of
+	//every colour sweep (see PBDOverRelaxation); autoTuneSOR replaces it per step by an estimate from the residual
+	//decay of the first sorTuningIts sweeps.
 	float w;
 
 	float inverseMass;
 
 	bool useSOR;
+	bool autoTuneSOR;
+	int sorTuningIts;
 
 
 	bool useGeometricConstraintLimits;
 	bool correctStrongForcesWithSubteps;
 
+	//Per phase timing and constraint counters of PBDSolver (see PBDSolverProfiler)
+	bool enableProfiling;
+
 	//debug print
 	bool printStrainEnergy;
 	bool printStrainEnergyToFile;
@@ -84,6 +135,28 @@ struct PBDSolverSettings
 
 	bool useMultiThreadedSolver;
 
+	//Jacobi projection (takes precedence over useMultiThreadedSolver): deterministic and fully parallel,
+	//but converges slower than Gauss-Seidel. Corrections are averaged per particle and scaled by w.
+	bool useJacobiSolver;
+
+	//Evaluate the coloured projection in batches of SIMD lanes where the CPU supports it (see PBDSolverBatchKernel)
+	bool useSIMDKernel;
+
+	//Bitwise reproducible results for any thread count: the colours of the multi-threaded solver are split into fixed
+	//blocks of deterministicBlockSize tets (whole SIMD batches) and sums are added up in block order instead of in
+	//the order the threads finish. The Jacobi and serial solvers are deterministic anyway. BenchmarkSuite reports the
+	//throughput of both modes.
+	bool useDeterministicParallelism;
+	int deterministicBlockSize;
+
+	//XPBD: the multi-threaded and Jacobi solvers accumulate a Lagrange multiplier per tet and derive the constraint's
+	//compliance from the Young's modulus (see PBDCompliance.h), so the stiffness no longer depends on numConstraintIts
+	//and deltaT. The multipliers are reset at the start of every (sub)step.
+	//With the Jacobi solver a tet only keeps the share of its multiplier update that its averaged position corrections
+	//applied (w / influence count per vertex). The result is then independent of the vertex valence to first order,
+	//but Jacobi XPBD still converges to the compliance more slowly than the coloured solver.
+	bool useXPBD;
+
 	bool useSecondOrderUpdates;
 
 	enum CONSTITUTIVE_MODEL
@@ -112,6 +185,10 @@ struct PBDSolverSettings
 
 	bool disableInversionHandling;
 
+	//Skip the SVD of inversion handling for elements whose singular values provably lie within the clamping range
+	//(see PBDInversionHandling.h). Exact for the isotropic Neo-Hookean model, which is the only one it is used for.
+	bool useInversionFastPath;
+
 	bool usePerTetMaterialAttributes;
 
 	void initialise()
@@ -128,6 +205,7 @@ struct PBDSolverSettings
 		disablePositionCorrection = false;
 		useFullPronySeries = false;
 
+		enableProfiling = false;
 		printStrainEnergy = false;
 		printStrainEnergyToFile = false;
 		printStressComponentsToFile = false;
@@ -141,7 +219,33 @@ struct PBDSolverSettings
 		groundplaneHeight = 0.0f;
 
 		disableInversionHandling = false;
+		useInversionFastPath = true;
 		useMultiThreadedSolver = true;
+		useJacobiSolver = false;
+		useSIMDKernel = true;
+		useDeterministicParallelism = false;
+		deterministicBlockSize = 256;
+		useXPBD = false;
+		numSubsteps = 1;
+		constraintTolerance = 0.0f;
+		useChebyshevAcceleration = false;
+		chebyshevWarmUpIts = 4;
+		chebyshevSpectralRadius = 0.0f;
+		numCoarseLevels = 0;
+		numCoarseLevelIts = 5;
+		useSleeping = false;
+		sleepVelocityThreshold = 0.01f;
+		numStepsToSleep = 40;
+		useWarmStarting = false;
+		warmStartDecay = 0.5f;
+		useDistanceConstraints = false;
+		distanceConstraintStiffness = 1.0f;
+		useVolumeConstraints = false;
+		volumeConstraintStiffness = 1.0f;
+		w = 1.0f;
+		useSOR = false;
+		autoTuneSOR = false;
+		sorTuningIts = 3;
 		useSecondOrderUpdates = false;
 		usePerTetMaterialAttributes = false;
 		minYoungsModulus = 0.0f;
@@ -189,6 +293,16 @@ struct PBDSolverSettings
 		MR_A0 = kroneckerProduct(MR_a, MR_a);
 	}
 
+	bool isInversionFastPathApplicable() const
+	{
+		return useInversionFastPath && !disableInversionHandling && materialModel == NEO_HOOKEAN;
+	}
+
+	float getSubstepDeltaT() const
+	{
+		return deltaT / (float)numSubsteps;
+	}
+
 	float getCurrentTime() const
 	{
 		return deltaT * (float)currentFrame;
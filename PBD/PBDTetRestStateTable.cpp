@@ -0,0 +1,126 @@
+#include "PBDTetRestStateTable.h"
+
+PBDTetRestStateTable::PBDTetRestStateTable()
+{
+	m_restStateData = NULL;
+	m_materialData = NULL;
+	m_numTetrahedra = 0;
+	m_numPronyComponents = 0;
+}
+
+
+PBDTetRestStateTable::~PBDTetRestStateTable()
+{
+}
+
+void
+PBDTetRestStateTable::clear()
+{
+	m_restStates.reset();
+	m_materials.reset();
+	m_restStateData = NULL;
+	m_materialData = NULL;
+	m_numTetrahedra = 0;
+
+	clearMutableState();
+}
+
+void
+PBDTetRestStateTable::clearMutableState()
+{
+	m_upsilon.clear();
+	m_upsilonFull.clear();
+	m_numPronyComponents = 0;
+	m_lagrangeMultipliers.clear();
+}
+
+void
+PBDTetRestStateTable::initialise(std::vector<PBDTetrahedra3d>& tetrahedra, const PBDSolverSettings& settings)
+{
+	clear();
+
+	std::shared_ptr<RestStateArray> restStates = std::make_shared<RestStateArray>(tetrahedra.size());
+	for (int t = 0; t < tetrahedra.size(); ++t)
+	{
+		PBDTetRestState& rest = (*restStates)[t];
+		for (int v = 0; v < 4; ++v)
+		{
+			rest.vertexIndices[v] = tetrahedra[t].getVertexIndices()[v];
+		}
+		rest.referenceShapeMatrixInverseTranspose = tetrahedra[t].getReferenceShapeMatrixInverseTranspose();
+		rest.undeformedVolume = tetrahedra[t].getUndeformedVolume();
+	}
+	m_restStates = restStates;
+	m_restStateData = restStates->empty() ? NULL : &(*restStates)[0];
+	m_numTetrahedra = tetrahedra.size();
+
+	if (settings.usePerTetMaterialAttributes && !tetrahedra.empty())
+	{
+		std::shared_ptr<std::vector<PBDTetMaterial> > materials = std::make_shared<std::vector<PBDTetMaterial> >(tetrahedra.size());
+		for (int t = 0; t < tetrahedra.size(); ++t)
+		{
+			(*materials)[t].youngsModulus = tetrahedra[t].getPerTetYoungsModulus();
+			(*materials)[t].anisotropyStrength = tetrahedra[t].getPerTetAnisotropyStrength();
+			(*materials)[t].anisotropyDirection = tetrahedra[t].getPerTetAnisotropyDirection();
+		}
+		m_materials = materials;
+		m_materialData = &(*materials)[0];
+	}
+
+	initialiseViscoelasticState(settings);
+}
+
+void
+PBDTetRestStateTable::shareRestStates(const PBDTetRestStateTable& other, const PBDSolverSettings& settings)
+{
+	clear();
+
+	m_restStates = other.m_restStates;
+	m_materials = other.m_materials;
+	m_restStateData = other.m_restStateData;
+	m_materialData = other.m_materialData;
+	m_numTetrahedra = other.m_numTetrahedra;
+
+	initialiseViscoelasticState(settings);
+}
+
+void
+PBDTetRestStateTable::initialiseViscoelasticState(const PBDSolverSettings& settings)
+{
+	if (settings.alpha == 0.0f || settings.rho == 0.0f)
+	{
+		return;
+	}
+
+	if (m_upsilon.size() != m_numTetrahedra)
+	{
+		m_upsilon.resize(m_numTetrahedra, Eigen::Matrix3f::Zero());
+	}
+
+	if (settings.useFullPronySeries && (m_numPronyComponents != settings.fullAlpha.size()
+		|| m_upsilonFull.size() != m_numTetrahedra * m_numPronyComponents))
+	{
+		m_numPronyComponents = settings.fullAlpha.size();
+		m_upsilonFull.assign(m_numTetrahedra * m_numPronyComponents, Eigen::Matrix3f::Zero());
+	}
+}
+
+void
+PBDTetRestStateTable::resetLagrangeMultipliers(const PBDSolverSettings& settings)
+{
+	if (!settings.useXPBD)
+	{
+		return;
+	}
+
+	if (settings.useWarmStarting && m_lagrangeMultipliers.size() == m_numTetrahedra)
+	{
+		for (int t = 0; t < m_lagrangeMultipliers.size(); ++t)
+		{
+			m_lagrangeMultipliers[t] *= settings.warmStartDecay;
+		}
+		return;
+	}
+
+	m_lagrangeMultipliers.assign(m_numTetrahedra, 0.0f);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include <Eigen/Dense>
+
+#include <tbb\cache_aligned_allocator.h>
+
+#include "PBDParticleStore.h"
+#include "PBDTetrahedra3d.h"
+#include "PBDSolverSettings.h"
+
+//Everything the constraint kernels need to know about an undeformed tet, packed into one cache line.
+struct EIGEN_ALIGN_TO_BOUNDARY(64) PBDTetRestState
+{
+	int vertexIndices[4];
+	Eigen::Matrix3f referenceShapeMatrixInverseTranspose;
+	float undeformedVolume;
+};
+
+struct PBDTetMaterial
+{
+	float youngsModulus;
+	float anisotropyStrength;
+	Eigen::Vector3f anisotropyDirection;
+};
+
+//Solver-side copy of the tetrahedra: an immutable, linearly laid out rest-state table plus the optional per-tet
+//material attributes, the mutable viscoelastic state and the XPBD Lagrange multipliers, each in its own array. The
+//material array only exists with usePerTetMaterialAttributes, the viscoelastic state only while alpha and rho are
+//non-zero, the multipliers only with useXPBD. The rest states and materials are never written after initialise, so
+//several tables (solvers) can share them, see shareRestStates.
+class PBDTetRestStateTable
+{
+public:
+	typedef std::vector<PBDTetRestState, tbb::cache_aligned_allocator<PBDTetRestState>> RestStateArray;
+
+	PBDTetRestStateTable();
+	~PBDTetRestStateTable();
+
+	void initialise(std::vector<PBDTetrahedra3d>& tetrahedra, const PBDSolverSettings& settings);
+
+	//Uses the rest states and materials of 'other' instead of building them; the mutable state is allocated afresh
+	void shareRestStates(const PBDTetRestStateTable& other, const PBDSolverSettings& settings);
+
+	//Allocates (or resizes) the viscoelastic state if the settings require it; cheap if nothing changed
+	void initialiseViscoelasticState(const PBDSolverSettings& settings);
+
+	//Allocates the XPBD multipliers if the settings require them and sets them to zero, or with useWarmStarting scales
+	//the last step's ones by warmStartDecay; called once per (sub)step
+	void resetLagrangeMultipliers(const PBDSolverSettings& settings);
+
+	void clear();
+
+	int getNumTetrahedra() const { return m_numTetrahedra; }
+
+	const PBDTetRestState& getRestState(int t) const { return m_restStateData[t]; }
+
+	bool hasMaterials() const { return m_materialData != NULL; }
+
+	const PBDTetMaterial& getMaterial(int t) const { return m_materialData[t]; }
+
+	bool hasViscoelasticState() const { return !m_upsilon.empty(); }
+
+	Eigen::Matrix3f& getUpsilon(int t) { return m_upsilon[t]; }
+
+	Eigen::Matrix3f& getFullUpsilon(int t, int component) { return m_upsilonFull[t * m_numPronyComponents + component]; }
+
+	float& getLagrangeMultiplier(int t) { return m_lagrangeMultipliers[t]; }
+
+	//F = Ds * Dm^-1
+	void getDeformationGradient(int t, PBDParticleStore& particles, Eigen::Matrix3f& F) const
+	{
+		const PBDTetRestState& rest = m_restStateData[t];
+		const Eigen::Vector3f& x4 = particles.position(rest.vertexIndices[3]);
+
+		Eigen::Matrix3f deformedShapeMatrix;
+		deformedShapeMatrix.col(0) = particles.position(rest.vertexIndices[0]) - x4;
+		deformedShapeMatrix.col(1) = particles.position(rest.vertexIndices[1]) - x4;
+		deformedShapeMatrix.col(2) = particles.position(rest.vertexIndices[2]) - x4;
+
+		F = deformedShapeMatrix * rest.referenceShapeMatrixInverseTranspose.transpose();
+	}
+
+private:
+	//Clears the mutable state
+	void clearMutableState();
+
+	std::shared_ptr<const RestStateArray> m_restStates;
+	std::shared_ptr<const std::vector<PBDTetMaterial> > m_materials;
+
+	//raw views of the shared arrays for the kernels
+	const PBDTetRestState* m_restStateData;
+	const PBDTetMaterial* m_materialData;
+	int m_numTetrahedra;
+
+	std::vector<Eigen::Matrix3f> m_upsilon;
+	std::vector<Eigen::Matrix3f> m_upsilonFull;
+	int m_numPronyComponents;
+
+	std::vector<float> m_lagrangeMultipliers;
+};
@@ -7,47 +7,43 @@
 #define __idx3 2
 #define __idx4 3
 
-#define pbdX1 (*m_particles)[m_vertexIndices[__idx1]].previousPosition()
-#define pbdX2 (*m_particles)[m_vertexIndices[__idx2]].previousPosition()
-#define pbdX3 (*m_particles)[m_vertexIndices[__idx3]].previousPosition()
-#define pbdX4 (*m_particles)[m_vertexIndices[__idx4]].previousPosition()
-
-#define pbdx1 (*m_particles)[m_vertexIndices[__idx1]].position() 
-#define pbdx2 (*m_particles)[m_vertexIndices[__idx2]].position() 
-#define pbdx3 (*m_particles)[m_vertexIndices[__idx3]].position() 
-#define pbdx4 (*m_particles)[m_vertexIndices[__idx4]].position() 
-
-#define pbdX1_raw (*m_particles)[m_vertexIndices[__idx1]]
-#define pbdX2_raw (*m_particles)[m_vertexIndices[__idx2]]
-#define pbdX3_raw (*m_particles)[m_vertexIndices[__idx3]]
-#define pbdX4_raw (*m_particles)[m_vertexIndices[__idx4]]
-
-#define pbdx1_raw (*m_particles)[m_vertexIndices[__idx1]] 
-#define pbdx2_raw (*m_particles)[m_vertexIndices[__idx2]] 
-#define pbdx3_raw (*m_particles)[m_vertexIndices[__idx3]] 
-#define pbdx4_raw (*m_particles)[m_vertexIndices[__idx4]]
-
-#define pbdV1 (*m_particles)[m_vertexIndices[__idx1]].previousVelocity()
-#define pbdV2 (*m_particles)[m_vertexIndices[__idx2]].previousVelocity()
-#define pbdV3 (*m_particles)[m_vertexIndices[__idx3]].previousVelocity()
-#define pbdV4 (*m_particles)[m_vertexIndices[__idx4]].previousVelocity()
-
-#define pbdv1 (*m_particles)[m_vertexIndices[__idx1]].velocity() 
-#define pbdv2 (*m_particles)[m_vertexIndices[__idx2]].velocity() 
-#define pbdv3 (*m_particles)[m_vertexIndices[__idx3]].velocity() 
-#define pbdv4 (*m_particles)[m_vertexIndices[__idx4]].velocity() 
+#define pbdX1 m_particles->previousPosition(m_vertexIndices[__idx1])
+#define pbdX2 m_particles->previousPosition(m_vertexIndices[__idx2])
+#define pbdX3 m_particles->previousPosition(m_vertexIndices[__idx3])
+#define pbdX4 m_particles->previousPosition(m_vertexIndices[__idx4])
+
+#define pbdx1 m_particles->position(m_vertexIndices[__idx1])
+#define pbdx2 m_particles->position(m_vertexIndices[__idx2])
+#define pbdx3 m_particles->position(m_vertexIndices[__idx3])
+#define pbdx4 m_particles->position(m_vertexIndices[__idx4])
+
+//committed positions, see PBDParticleStore::swapStates
+#define pbdxc1 m_particles->previousPosition(m_vertexIndices[__idx1])
+#define pbdxc2 m_particles->previousPosition(m_vertexIndices[__idx2])
+#define pbdxc3 m_particles->previousPosition(m_vertexIndices[__idx3])
+#define pbdxc4 m_particles->previousPosition(m_vertexIndices[__idx4])
+
+#define pbdV1 m_particles->previousVelocity(m_vertexIndices[__idx1])
+#define pbdV2 m_particles->previousVelocity(m_vertexIndices[__idx2])
+#define pbdV3 m_particles->previousVelocity(m_vertexIndices[__idx3])
+#define pbdV4 m_particles->previousVelocity(m_vertexIndices[__idx4])
+
+#define pbdv1 m_particles->velocity(m_vertexIndices[__idx1])
+#define pbdv2 m_particles->velocity(m_vertexIndices[__idx2])
+#define pbdv3 m_particles->velocity(m_vertexIndices[__idx3])
+#define pbdv4 m_particles->velocity(m_vertexIndices[__idx4])
 
 #include <GL\glew.h>
 #include <gl\GL.h>
 
-PBDTetrahedra3d::PBDTetrahedra3d(std::vector<int>&& vertexIndices, const std::shared_ptr<std::vector<PBDParticle>>& particles, int thisIdx)
+PBDTetrahedra3d::PBDTetrahedra3d(std::vector<int>&& vertexIndices, const std::shared_ptr<PBDParticleStore>& particles, int thisIdx)
 {
 	m_thisIdx = thisIdx;
 	m_vertexIndices = std::move(vertexIndices);
 	initialise(vertexIndices, particles);
 }
 
-PBDTetrahedra3d::PBDTetrahedra3d(std::vector<int>& vertexIndices, const std::shared_ptr<std::vector<PBDParticle>>& particles, int thisIdx)
+PBDTetrahedra3d::PBDTetrahedra3d(std::vector<int>& vertexIndices, const std::shared_ptr<PBDParticleStore>& particles, int thisIdx)
 {
 	m_thisIdx = thisIdx;
 	m_vertexIndices = vertexIndices;
@@ -60,25 +56,13 @@ PBDTetrahedra3d::~PBDTetrahedra3d()
 }
 
 void
-PBDTetrahedra3d::initialise(std::vector<int>& vertexIndices, const std::shared_ptr<std::vector<PBDParticle>>& particles)
+PBDTetrahedra3d::initialise(std::vector<int>& vertexIndices, const std::shared_ptr<PBDParticleStore>& particles)
 {
 	m_particles = particles;
 	calculateReferenceShapeMatrix();
 	calculateReferenceShapeMatrixInverseTranspose();
 	calculateUndeformedVolume();
 	calculateUndeformedSideLengths();
-	m_upsilon.setZero();
-
-
-	m_distortionDissipative.setZero();
-	m_distortionElastic.setZero();
-	m_deformedShapeMatrix_previousVelocity.setZero();
-	m_deformedShapeMatrix_previousPosition.setZero();
-
-	for (int i = 0; i < m_vertexIndices.size(); ++i)
-	{
-		(*m_particles)[m_vertexIndices[i]].getContainingTetIdxs().push_back(m_thisIdx);
-	}
 }
 
 const Eigen::Matrix3f&
@@ -111,22 +95,6 @@ PBDTetrahedra3d::calculateDeformedShapeMatrix()
 	m_deformedShapeMatrix.col(2) = pbdx3 - pbdx4;
 }
 
-Eigen::Matrix3f
-PBDTetrahedra3d::calculateRelativeDeformationGradientVelocity()
-{
-	Eigen::Matrix3f result;
-	return result;
-}
-
-Eigen::Matrix3f
-PBDTetrahedra3d::calculateRelativeDeformationGradientPosition()
-{
-	calculateDeformedShapeMatrix();
-
-	return m_deformedShapeMatrix * m_deformedShapeMatrix_previousPosition.inverse();
-}
-
-
 Eigen::Matrix3f
 PBDTetrahedra3d::getDeformationGradient()
 {
@@ -141,16 +109,6 @@ PBDTetrahedra3d::getDeformationGradient()
 	return m_deformedShapeMatrix * m_referenceShapeMatrixInverse;
 }
 
-Eigen::Matrix3f
-PBDTetrahedra3d::getVelocityGradient()
-{
-	m_velocityMatrix.col(0) = pbdv1 - pbdv4;
-	m_velocityMatrix.col(1) = pbdv2 - pbdv4;
-	m_velocityMatrix.col(2) = pbdv3 - pbdv4;
-
-	return m_velocityMatrix * m_referenceShapeMatrixInverse;
-}
-
 float
 PBDTetrahedra3d::getVolume()
 {
@@ -219,73 +177,26 @@ PBDTetrahedra3d::calculateUndeformedVolume()
 
 }
 
-PBDParticle&
-PBDTetrahedra3d::get_x(int index)
-{
-	switch (index)
-	{
-	case 0:
-		return pbdx1_raw;
-		break;
-	case 1:
-		return pbdx2_raw;
-		break;
-	case 2:
-		return pbdx3_raw;
-		break;
-	case 3:
-		return pbdx4_raw;
-		break;
-	default:
-		return PBDParticle();
-		break;
-	}
-}
-
-
-PBDParticle&
-PBDTetrahedra3d::get_X(int index)
-{
-	switch (index)
-	{
-	case 0:
-		return pbdX1_raw;
-		break;
-	case 1:
-		return pbdX2_raw;
-		break;
-	case 2:
-		return pbdX3_raw;
-		break;
-	case 3:
-		return pbdX4_raw;
-		break;
-	default:
-		return PBDParticle();
-		break;
-	}
-}
-
 void
 PBDTetrahedra3d::glRender(double r, double g, double b)
 {
 	glBegin(GL_TRIANGLES);
 		glColor3d(r, g, b);
-		glVertex3d(pbdx1.x(), pbdx1.y(), pbdx1.z());
-		glVertex3d(pbdx2.x(), pbdx2.y(), pbdx2.z());
-		glVertex3d(pbdx3.x(), pbdx3.y(), pbdx3.z());
+		glVertex3d(pbdxc1.x(), pbdxc1.y(), pbdxc1.z());
+		glVertex3d(pbdxc2.x(), pbdxc2.y(), pbdxc2.z());
+		glVertex3d(pbdxc3.x(), pbdxc3.y(), pbdxc3.z());
 
-		glVertex3d(pbdx1.x(), pbdx1.y(), pbdx1.z());
-		glVertex3d(pbdx3.x(), pbdx3.y(), pbdx3.z());
-		glVertex3d(pbdx4.x(), pbdx4.y(), pbdx4.z());
+		glVertex3d(pbdxc1.x(), pbdxc1.y(), pbdxc1.z());
+		glVertex3d(pbdxc3.x(), pbdxc3.y(), pbdxc3.z());
+		glVertex3d(pbdxc4.x(), pbdxc4.y(), pbdxc4.z());
 
-		glVertex3d(pbdx1.x(), pbdx1.y(), pbdx1.z());
-		glVertex3d(pbdx3.x(), pbdx3.y(), pbdx3.z());
-		glVertex3d(pbdx2.x(), pbdx2.y(), pbdx2.z());
+		glVertex3d(pbdxc1.x(), pbdxc1.y(), pbdxc1.z());
+		glVertex3d(pbdxc3.x(), pbdxc3.y(), pbdxc3.z());
+		glVertex3d(pbdxc2.x(), pbdxc2.y(), pbdxc2.z());
 
-		glVertex3d(pbdx2.x(), pbdx2.y(), pbdx2.z());
-		glVertex3d(pbdx3.x(), pbdx3.y(), pbdx3.z());
-		glVertex3d(pbdx4.x(), pbdx4.y(), pbdx4.z());
+		glVertex3d(pbdxc2.x(), pbdxc2.y(), pbdxc2.z());
+		glVertex3d(pbdxc3.x(), pbdxc3.y(), pbdxc3.z());
+		glVertex3d(pbdxc4.x(), pbdxc4.y(), pbdxc4.z());
 	glEnd();
 }
 
@@ -10,8 +10,8 @@
 class PBDTetrahedra3d
 {
 public:
-	PBDTetrahedra3d(std::vector<int>&& vertexIndices, const std::shared_ptr<std::vector<PBDParticle>>& particles, int thisIdx);
-	PBDTetrahedra3d(std::vector<int>& vertexIndices, const std::shared_ptr<std::vector<PBDParticle>>& particles, int thisIdx);
+	PBDTetrahedra3d(std::vector<int>&& vertexIndices, const std::shared_ptr<PBDParticleStore>& particles, int thisIdx);
+	PBDTetrahedra3d(std::vector<int>& vertexIndices, const std::shared_ptr<PBDParticleStore>& particles, int thisIdx);
 	~PBDTetrahedra3d();
 
 	const std::vector<int>& getVertexIndices() const { return m_vertexIndices; }
@@ -22,8 +22,6 @@ public:
 
 	Eigen::Matrix3f getDeformationGradient();
 
-	Eigen::Matrix3f getVelocityGradient();
-
 	float getVolume();
 
 	float getUndeformedVolume()
@@ -31,58 +29,18 @@ public:
 		return m_undeformedVolume;
 	}
 
-	float getUndeformedVolumeAlternative()
+	float getUndeformedVolumeAlternative() const
 	{
 		return m_undeformedVolumeAlternative;
 	}
 
 	float getUndeformedSideLength(int idx);
 
-	PBDParticle& get_x(int index);
-	PBDParticle& get_X(int index);
-
-	Eigen::Matrix3f& getUpsilon()
-	{
-		return m_upsilon;
-	}
-
-	Eigen::Matrix3f& getFullUpsilon(int idx)
-	{
-		return m_upsilonFull[idx];
-	}
-
-	void setFullUpsilonCount(int num)
-	{
-		m_upsilonFull.resize(num);
-		for (int i = 0; i < num; ++i)
-		{
-			m_upsilonFull[i].setZero();
-		}
-	}
+	PBDParticle get_x(int index) { return (*m_particles)[m_vertexIndices[index]]; }
+	PBDParticle get_X(int index) { return (*m_particles)[m_vertexIndices[index]]; }
 
 	Eigen::Vector3f& getFaceVertex(int face, int vertex);
 
-	Eigen::Matrix3f& getDistortionDissipative() { return m_distortionDissipative; }
-	Eigen::Matrix3f& getDistortionElastic() { return m_distortionElastic; }
-
-	void setPreviousDeformedShapeMatrix()
-	{
-		calculateDeformedShapeMatrix();
-		m_deformedShapeMatrix_previousPosition = m_deformedShapeMatrix;
-	}
-
-	Eigen::Matrix3f getRelativeDeformationGradient()
-	{
-		calculateDeformedShapeMatrix();
-		return m_deformedShapeMatrix * m_deformedShapeMatrix_previousPosition.inverse();
-	}
-
-	void calculateReferenceVelocityMatrix();
-
-	Eigen::Matrix3f calculateRelativeDeformationGradientVelocity();
-
-	Eigen::Matrix3f calculateRelativeDeformationGradientPosition();
-
 	void glRender(double r, double g, double b);
 
 	float& getPerTetYoungsModulus(){ return c_youngsModulus; }
@@ -90,7 +48,7 @@ public:
 	Eigen::Vector3f& getPerTetAnisotropyDirection() { return c_anisotropyDirection; }
 private:
 
-	void initialise(std::vector<int>& vertexIndices, const std::shared_ptr<std::vector<PBDParticle>>& particles);
+	void initialise(std::vector<int>& vertexIndices, const std::shared_ptr<PBDParticleStore>& particles);
 
 	void calculateUndeformedVolume();
 	void calculateReferenceShapeMatrix();
@@ -104,13 +62,8 @@ private:
 	Eigen::Matrix3f m_referenceShapeMatrixInverse;
 	Eigen::Matrix3f m_deformedShapeMatrix;
 
-	Eigen::Matrix3f m_deformedShapeMatrix_previousVelocity;
-	Eigen::Matrix3f m_deformedShapeMatrix_previousPosition;
-
-	Eigen::Matrix3f m_velocityMatrix;
-
 	std::vector<int> m_vertexIndices;
-	std::shared_ptr<std::vector<PBDParticle>> m_particles;
+	std::shared_ptr<PBDParticleStore> m_particles;
 	float m_undeformedVolume;
 
 	std::vector<float> m_undeformedSideLengths;
@@ -119,15 +72,6 @@ private:
 
 	int m_thisIdx;
 
-	//viscoelasticity
-	Eigen::Matrix3f m_upsilon;
-	std::vector<Eigen::Matrix3f> m_upsilonFull;
-
-	//Rubin-Bodner stuff
-	Eigen::Matrix3f m_distortionElastic;
-	Eigen::Matrix3f m_distortionDissipative;
-
-
 	//Per-Tet Material Attributes
 	Eigen::Vector3f c_anisotropyDirection;
 	float c_anisotropyStrength;
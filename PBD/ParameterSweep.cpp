@@ -0,0 +1,287 @@
+#include "ParameterSweep.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+
+#include <tbb\parallel_for.h>
+#include <tbb\blocked_range.h>
+#include <tbb\tick_count.h>
+
+ParameterSweep::ParameterSweep()
+{
+}
+
+
+ParameterSweep::~ParameterSweep()
+{
+}
+
+std::vector<ParameterSweepRun>
+ParameterSweep::buildGrid(const std::vector<float>& youngsModuli, const std::vector<float>& poissonRatios,
+	const std::vector<Eigen::Vector2f>& alphaRho, const std::vector<int>& numConstraintIts)
+{
+	std::vector<ParameterSweepRun> runs;
+	for (int e = 0; e < youngsModuli.size(); ++e)
+	{
+		for (int n = 0; n < poissonRatios.size(); ++n)
+		{
+			for (int a = 0; a < alphaRho.size(); ++a)
+			{
+				for (int i = 0; i < numConstraintIts.size(); ++i)
+				{
+					ParameterSweepRun run;
+					run.youngsModulus = youngsModuli[e];
+					run.poissonRatio = poissonRatios[n];
+					run.alpha = alphaRho[a].x();
+					run.rho = alphaRho[a].y();
+					run.numConstraintIts = numConstraintIts[i];
+					runs.push_back(run);
+				}
+			}
+		}
+	}
+	return runs;
+}
+
+bool
+ParameterSweep::parseList(const std::string& list, std::vector<std::string>& values)
+{
+	values.clear();
+
+	std::stringstream ss(list);
+	std::string value;
+	while (std::getline(ss, value, ','))
+	{
+		if (value.empty())
+		{
+			std::cout << "ERROR: Empty entry in the sweep list [ " << list << " ]." << std::endl;
+			return false;
+		}
+		values.push_back(value);
+	}
+
+	if (values.empty())
+	{
+		std::cout << "ERROR: Empty sweep list." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool
+ParameterSweep::parseGrid(const std::string& youngsModuli, const std::string& poissonRatios, const std::string& alphaRho,
+	const std::string& numConstraintIts, std::vector<ParameterSweepRun>& runs)
+{
+	std::vector<std::string> youngsModulusValues;
+	std::vector<std::string> poissonRatioValues;
+	std::vector<std::string> alphaRhoValues;
+	std::vector<std::string> numConstraintItsValues;
+
+	if (!parseList(youngsModuli, youngsModulusValues) || !parseList(poissonRatios, poissonRatioValues)
+		|| !parseList(alphaRho, alphaRhoValues) || !parseList(numConstraintIts, numConstraintItsValues))
+	{
+		return false;
+	}
+
+	std::vector<float> E;
+	std::vector<float> nu;
+	std::vector<Eigen::Vector2f> ar;
+	std::vector<int> its;
+
+	try
+	{
+		for (int i = 0; i < youngsModulusValues.size(); ++i)
+		{
+			E.push_back(std::stof(youngsModulusValues[i]));
+		}
+		for (int i = 0; i < poissonRatioValues.size(); ++i)
+		{
+			nu.push_back(std::stof(poissonRatioValues[i]));
+		}
+		for (int i = 0; i < alphaRhoValues.size(); ++i)
+		{
+			size_t separator = alphaRhoValues[i].find(':');
+			if (separator == std::string::npos)
+			{
+				std::cout << "ERROR: Expected <ALPHA>:<RHO>, got [ " << alphaRhoValues[i] << " ]." << std::endl;
+				return false;
+			}
+			ar.push_back(Eigen::Vector2f(std::stof(alphaRhoValues[i].substr(0, separator)),
+				std::stof(alphaRhoValues[i].substr(separator + 1))));
+		}
+		for (int i = 0; i < numConstraintItsValues.size(); ++i)
+		{
+			its.push_back(std::stoi(numConstraintItsValues[i]));
+		}
+	}
+	catch (const std::exception&)
+	{
+		std::cout << "ERROR: Could not parse the sweep lists." << std::endl;
+		return false;
+	}
+
+	runs = buildGrid(E, nu, ar, its);
+	return true;
+}
+
+bool
+ParameterSweep::simulate(const PBDSimulationContext& scene, const PBDSolverSettings& settings, int numFrames,
+	const ParameterSweepDriverLoader& loadDrivers, tbb::mutex& loaderMutex, ParameterSweepResult& result)
+{
+	PBDSolverSettings localSettings = settings;
+	localSettings.currentFrame = 1;
+	localSettings.youngsModulus = result.run.youngsModulus;
+	localSettings.poissonRatio = result.run.poissonRatio;
+	localSettings.alpha = result.run.alpha;
+	localSettings.rho = result.run.rho;
+	localSettings.numConstraintIts = result.run.numConstraintIts;
+	localSettings.calculateLambda();
+	localSettings.calculateMu();
+	localSettings.calculateFiberStructureTensor();
+
+	PBDSimulationContext context;
+	context.shareMesh(scene, localSettings);
+
+	if (loadDrivers)
+	{
+		tbb::mutex::scoped_lock lock(loaderMutex);
+		if (!loadDrivers(context.getCollisionGeometry2(), context.getCollisionGeometry3(), context.getMovingConstraints()))
+		{
+			std::cout << "ERROR: Could not load the colliders of a sweep run." << std::endl;
+			return false;
+		}
+	}
+
+	for (int f = 0; f < numFrames; ++f)
+	{
+		tbb::tick_count start = tbb::tick_count::now();
+		context.step();
+		result.solveTime += (tbb::tick_count::now() - start).seconds();
+
+		result.numConstraintItsUsed += context.getSolver().getNumConstraintItsUsed();
+	}
+	result.constraintResidual = context.getSolver().getConstraintResidual();
+
+	const PBDParticleStore& initialParticles = scene.getParticleStore();
+	const PBDParticleStore& particles = context.getParticleStore();
+	for (int p = 0; p < particles.size(); ++p)
+	{
+		const Eigen::Vector3f& x = particles.previousPosition(p);
+		if (!std::isfinite(x.x()) || !std::isfinite(x.y()) || !std::isfinite(x.z()))
+		{
+			result.isValid = false;
+			continue;
+		}
+		result.maxDisplacement = std::max(result.maxDisplacement, (x - initialParticles.position(p)).norm());
+	}
+
+	//same signed volume as PBDTetrahedra3d::getUndeformedVolumeAlternative
+	const std::vector<PBDTetrahedra3d>& tetrahedra = context.getTetrahedra();
+	double volume = 0.0;
+	double undeformedVolume = 0.0;
+	for (int t = 0; t < tetrahedra.size(); ++t)
+	{
+		const std::vector<int>& vertexIndices = tetrahedra[t].getVertexIndices();
+		const Eigen::Vector3f& x1 = particles.previousPosition(vertexIndices[0]);
+		volume += 1.0 / 6.0 * (particles.previousPosition(vertexIndices[1]) - x1).cross(particles.previousPosition(vertexIndices[2]) - x1)
+			.dot(particles.previousPosition(vertexIndices[3]) - x1);
+		undeformedVolume += tetrahedra[t].getUndeformedVolumeAlternative();
+	}
+	result.volumeRatio = (undeformedVolume != 0.0) ? (float)(volume / undeformedVolume) : 1.0f;
+
+	return true;
+}
+
+bool
+ParameterSweep::run(const PBDSimulationContext& scene, const std::vector<ParameterSweepRun>& runs, int numFrames,
+	const ParameterSweepDriverLoader& loadDrivers, const std::string& summaryFile)
+{
+	if (runs.empty() || numFrames < 1)
+	{
+		std::cout << "ERROR: A sweep needs at least one run and one frame!" << std::endl;
+		return false;
+	}
+
+	if (scene.getTetrahedra().empty())
+	{
+		std::cout << "ERROR: The sweep scenario has no tetrahedra!" << std::endl;
+		return false;
+	}
+
+	PBDSolverSettings sweepSettings = scene.getSettings();
+	if (!sweepSettings.useMultiThreadedSolver && !sweepSettings.useJacobiSolver)
+	{
+		//the serial solver reads the positions through the tetrahedra, i.e. the particles they were built with
+		std::cout << "WARNING: The serial solver cannot run on shared tetrahedra, sweeping with the multi-threaded solver." << std::endl;
+		sweepSettings.useMultiThreadedSolver = true;
+	}
+
+	std::cout << "PARAMETER SWEEP: " << runs.size() << " runs of " << numFrames << " frames, " << scene.getTetrahedra().size()
+		<< " tets, " << scene.getParticleStore().size() << " particles." << std::endl;
+
+	std::vector<ParameterSweepResult> results(runs.size());
+	std::vector<char> succeeded(runs.size(), 0);
+	tbb::mutex loaderMutex;
+
+	tbb::tick_count start = tbb::tick_count::now();
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, runs.size(), 1), [&](const tbb::blocked_range<size_t>& r)
+	{
+		for (size_t i = r.begin(); i != r.end(); ++i)
+		{
+			results[i].run = runs[i];
+			succeeded[i] = simulate(scene, sweepSettings, numFrames, loadDrivers, loaderMutex, results[i]) ? 1 : 0;
+		}
+	});
+	const double wallTime = (tbb::tick_count::now() - start).seconds();
+
+	double solveTimeSum = 0.0;
+	bool allSucceeded = true;
+	for (int i = 0; i < results.size(); ++i)
+	{
+		solveTimeSum += results[i].solveTime;
+		allSucceeded = allSucceeded && succeeded[i];
+	}
+
+	std::cout << "Sweep time: " << wallTime << "s; summed run time: " << solveTimeSum << "s; concurrency: "
+		<< ((wallTime > 0.0) ? solveTimeSum / wallTime : 0.0) << std::endl;
+
+	if (!writeSummary(results, numFrames, summaryFile))
+	{
+		return false;
+	}
+
+	return allSucceeded;
+}
+
+bool
+ParameterSweep::writeSummary(const std::vector<ParameterSweepResult>& results, int numFrames, const std::string& fileName)
+{
+	std::ofstream file;
+	file.open(fileName);
+
+	if (!file.is_open())
+	{
+		std::cout << "ERROR: Could not write [ " << fileName << " ]." << std::endl;
+		return false;
+	}
+
+	file << "run,youngsModulus,poissonRatio,alpha,rho,numConstraintIts,numFrames,solveTime,averageFrameTime,"
+		<< "numConstraintItsUsed,constraintResidual,volumeRatio,maxDisplacement,valid" << std::endl;
+
+	for (int i = 0; i < results.size(); ++i)
+	{
+		const ParameterSweepResult& result = results[i];
+		file << i << "," << result.run.youngsModulus << "," << result.run.poissonRatio << "," << result.run.alpha << ","
+			<< result.run.rho << "," << result.run.numConstraintIts << "," << numFrames << "," << result.solveTime << ","
+			<< result.solveTime / (double)numFrames << "," << result.numConstraintItsUsed << "," << result.constraintResidual << ","
+			<< result.volumeRatio << "," << result.maxDisplacement << "," << (result.isValid ? 1 : 0) << std::endl;
+	}
+
+	file.close();
+
+	std::cout << "Sweep summary written to [ " << fileName << " ]." << std::endl;
+	return true;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <functional>
+
+#include <Eigen\Dense>
+
+#include <tbb\mutex.h>
+
+#include "PBDSolverSettings.h"
+#include "PBDSimulationContext.h"
+
+//One point of a sweep's parameter grid
+struct ParameterSweepRun
+{
+	float youngsModulus;
+	float poissonRatio;
+	float alpha;
+	float rho;
+	int numConstraintIts;
+};
+
+//Outcome of one run
+struct ParameterSweepResult
+{
+	ParameterSweepResult() : solveTime(0.0), numConstraintItsUsed(0), constraintResidual(0.0f), volumeRatio(1.0f),
+		maxDisplacement(0.0f), isValid(true)
+	{
+	}
+
+	ParameterSweepRun run;
+
+	//seconds spent in advanceSystem
+	double solveTime;
+	long long numConstraintItsUsed;
+	float constraintResidual;
+
+	//deformed / undeformed mesh volume and the largest distance of a particle from its initial position
+	float volumeRatio;
+	float maxDisplacement;
+
+	//false if a position became NaN or infinite
+	bool isValid;
+};
+
+//Fills one run's colliders and drivers. Their Alembic readers keep the current sample, so runs cannot share them.
+typedef std::function<bool(std::vector<CollisionRod>&, std::vector<CollisionSphere>&, std::vector<MovingHardConstraints>&)>
+	ParameterSweepDriverLoader;
+
+//Runs a scenario for every point of a parameter grid in one process. Each run is a PBDSimulationContext with its own
+//particles, colliders, drivers and solver; the mesh, the rest-state table and the colouring of the scenario's context
+//are shared read-only (see PBDSimulationContext::shareMesh). The runs are tbb tasks, so they are spread over the worker threads
+//by work stealing and nest with the solvers' own parallel loops. Per-frame scenario updates of main.cpp
+//(applyContinuousDeformationToMesh etc.) and tracking constraints are not part of a sweep.
+class ParameterSweep
+{
+public:
+	//Cartesian product of the lists; the alpha / rho pairs are x = alpha, y = rho
+	static std::vector<ParameterSweepRun> buildGrid(const std::vector<float>& youngsModuli,
+		const std::vector<float>& poissonRatios, const std::vector<Eigen::Vector2f>& alphaRho,
+		const std::vector<int>& numConstraintIts);
+
+	//Comma separated lists, the alpha / rho pairs as <ALPHA>:<RHO>
+	static bool parseGrid(const std::string& youngsModuli, const std::string& poissonRatios, const std::string& alphaRho,
+		const std::string& numConstraintIts, std::vector<ParameterSweepRun>& runs);
+
+	//'scene' has to be initialised, its settings are the base of every run. 'loadDrivers' may be empty if the scenario
+	//has no colliders or drivers; it is called once per run, never concurrently. Writes one CSV line per run to
+	//'summaryFile'.
+	static bool run(const PBDSimulationContext& scene, const std::vector<ParameterSweepRun>& runs, int numFrames,
+		const ParameterSweepDriverLoader& loadDrivers, const std::string& summaryFile);
+
+private:
+	//One run in its own context on the mesh of 'scene'; result.run selects the parameters
+	static bool simulate(const PBDSimulationContext& scene, const PBDSolverSettings& settings, int numFrames,
+		const ParameterSweepDriverLoader& loadDrivers, tbb::mutex& loaderMutex, ParameterSweepResult& result);
+
+	static bool writeSummary(const std::vector<ParameterSweepResult>& results, int numFrames, const std::string& fileName);
+
+	static bool parseList(const std::string& list, std::vector<std::string>& values);
+
+	ParameterSweep();
+	~ParameterSweep();
+};
@@ -103,6 +103,33 @@ struct Parameters
 
 		timingPrintInterval = 100;
 		solverSettings.currentFrame = 1;
+		solverSettings.useJacobiSolver = false;
+		solverSettings.useSIMDKernel = true;
+		solverSettings.useDeterministicParallelism = false;
+		solverSettings.deterministicBlockSize = 256;
+		solverSettings.useXPBD = false;
+		solverSettings.numSubsteps = 1;
+		solverSettings.constraintTolerance = 0.0f;
+		solverSettings.useChebyshevAcceleration = false;
+		solverSettings.chebyshevWarmUpIts = 4;
+		solverSettings.chebyshevSpectralRadius = 0.0f;
+		solverSettings.numCoarseLevels = 0;
+		solverSettings.numCoarseLevelIts = 5;
+		solverSettings.useSleeping = false;
+		solverSettings.sleepVelocityThreshold = 0.01f;
+		solverSettings.numStepsToSleep = 40;
+		solverSettings.useWarmStarting = false;
+		solverSettings.warmStartDecay = 0.5f;
+		solverSettings.useDistanceConstraints = false;
+		solverSettings.distanceConstraintStiffness = 1.0f;
+		solverSettings.useVolumeConstraints = false;
+		solverSettings.volumeConstraintStiffness = 1.0f;
+		solverSettings.useInversionFastPath = true;
+		solverSettings.w = 1.0f;
+		solverSettings.useSOR = false;
+		solverSettings.enableProfiling = false;
+		solverSettings.autoTuneSOR = false;
+		solverSettings.sorTuningIts = 3;
 		maxFrames = 1000;
 
 		useFEMSolver = false;
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Eigen\Dense>
+
+#include "SVD3x3Lanes.h"
+
+//Single matrix version of svd3x3 (see SVD3x3Lanes.h).
+inline void svd3x3(const Eigen::Matrix3f& A, Eigen::Matrix3f& U, Eigen::Vector3f& S, Eigen::Matrix3f& V)
+{
+	LaneMat3<float> A_l;
+	LaneMat3<float> U_l;
+	LaneMat3<float> V_l;
+	float S_l[3];
+
+	for (int r = 0; r < 3; ++r)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			A_l.m[r][c] = A(r, c);
+		}
+	}
+
+	svd3x3(A_l, U_l, S_l, V_l);
+
+	for (int r = 0; r < 3; ++r)
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			U(r, c) = U_l.m[r][c];
+			V(r, c) = V_l.m[r][c];
+		}
+		S[r] = S_l[r];
+	}
+}
@@ -0,0 +1,222 @@
+#include "SVD3x3Benchmark.h"
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+
+#include <tbb\tick_count.h>
+
+#include "SVD3x3.h"
+#include "commonMath.h"
+#include "PBDSolverBatchKernel.h"
+#include "PBDSolverBatchKernelAVX2.h"
+
+//keeps the timed loops from being optimised away
+static volatile float s_benchmarkSink;
+
+SVD3x3Benchmark::SVD3x3Benchmark()
+{
+}
+
+
+SVD3x3Benchmark::~SVD3x3Benchmark()
+{
+}
+
+void
+SVD3x3Benchmark::generateMatrices(int numMatrices, std::vector<Eigen::Matrix3f>& matrices)
+{
+	std::mt19937 generator(42);
+	std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+	matrices.resize(numMatrices);
+	for (int i = 0; i < numMatrices; ++i)
+	{
+		Eigen::Quaternionf q0(uniform(generator), uniform(generator), uniform(generator), uniform(generator));
+		Eigen::Quaternionf q1(uniform(generator), uniform(generator), uniform(generator), uniform(generator));
+		q0.normalize();
+		q1.normalize();
+
+		Eigen::Vector3f singularValues;
+		switch (i % 4)
+		{
+		case 0:
+			//mildly deformed
+			singularValues = Eigen::Vector3f(1.0f, 1.0f, 1.0f) + 0.05f * Eigen::Vector3f(uniform(generator), uniform(generator), uniform(generator));
+			break;
+		case 1:
+			//general
+			singularValues = Eigen::Vector3f(1.1f, 1.1f, 1.1f) + Eigen::Vector3f(uniform(generator), uniform(generator), uniform(generator));
+			break;
+		case 2:
+			//near-degenerate (almost flat element)
+			singularValues = Eigen::Vector3f(1.0f + 0.5f * uniform(generator), 1.0f + 0.5f * uniform(generator), 1.0e-4f * uniform(generator));
+			break;
+		default:
+			//inverted
+			singularValues = Eigen::Vector3f(1.1f, 1.1f, 1.1f) + Eigen::Vector3f(uniform(generator), uniform(generator), uniform(generator));
+			singularValues[i % 3] *= -1.0f;
+			break;
+		}
+
+		matrices[i] = q0.toRotationMatrix() * singularValues.asDiagonal() * q1.toRotationMatrix().transpose();
+	}
+}
+
+bool
+SVD3x3Benchmark::checkAccuracy(const std::vector<Eigen::Matrix3f>& matrices)
+{
+	const float tolerance = 1.0e-4f;
+
+	float maxReconstructionError = 0.0f;
+	float maxSingularValueError = 0.0f;
+	float maxOrthogonalityError = 0.0f;
+	float maxBatchDifference = 0.0f;
+	int numReflections = 0;
+	int numWrongSigns = 0;
+
+	Eigen::Matrix3f U;
+	Eigen::Matrix3f V;
+	Eigen::Vector3f S;
+
+	std::vector<Eigen::Matrix3f> batchU(matrices.size());
+	std::vector<Eigen::Matrix3f> batchV(matrices.size());
+	std::vector<Eigen::Vector3f> batchS(matrices.size());
+	const bool checkBatch = PBDSolverBatchKernel::getInstructionSet() == PBDSolverBatchKernel::AVX2;
+	if (checkBatch)
+	{
+		svd3x3AVX2(matrices[0].data(), batchU[0].data(), batchS[0].data(), batchV[0].data(), matrices.size());
+	}
+
+	for (int i = 0; i < matrices.size(); ++i)
+	{
+		const Eigen::Matrix3f& A = matrices[i];
+
+		svd3x3(A, U, S, V);
+
+		Eigen::JacobiSVD<Eigen::Matrix3f> reference(A);
+		const float scale = reference.singularValues()[0];
+
+		maxReconstructionError = std::max(maxReconstructionError, (U * S.asDiagonal() * V.transpose() - A).norm() / scale);
+		maxSingularValueError = std::max(maxSingularValueError, (S.cwiseAbs() - reference.singularValues()).cwiseAbs().maxCoeff() / scale);
+		maxOrthogonalityError = std::max(maxOrthogonalityError, (U.transpose() * U - Eigen::Matrix3f::Identity()).norm());
+		maxOrthogonalityError = std::max(maxOrthogonalityError, (V.transpose() * V - Eigen::Matrix3f::Identity()).norm());
+
+		if (U.determinant() < 0.0f || V.determinant() < 0.0f)
+		{
+			++numReflections;
+		}
+
+		//only the smallest singular value may be negative, and it has to be for inverted elements
+		const bool clearlyInverted = A.determinant() < -tolerance * scale * scale * scale;
+		const bool clearlyNotInverted = A.determinant() > tolerance * scale * scale * scale;
+		if (S[0] < 0.0f || S[1] < 0.0f || (clearlyInverted && S[2] > 0.0f) || (clearlyNotInverted && S[2] < 0.0f))
+		{
+			++numWrongSigns;
+		}
+
+		//U and V are not unique for (nearly) repeated singular values, so the batch version is compared by its
+		//singular values and its reconstruction
+		if (checkBatch)
+		{
+			maxBatchDifference = std::max(maxBatchDifference, (batchS[i] - S).cwiseAbs().maxCoeff() / scale);
+			maxBatchDifference = std::max(maxBatchDifference, (batchU[i] * batchS[i].asDiagonal() * batchV[i].transpose() - A).norm() / scale);
+		}
+	}
+
+	std::cout << "max. reconstruction error |U S V^T - A| / s_max: " << maxReconstructionError << std::endl;
+	std::cout << "max. singular value error vs. JacobiSVD / s_max: " << maxSingularValueError << std::endl;
+	std::cout << "max. orthogonality error of U, V:                " << maxOrthogonalityError << std::endl;
+	std::cout << "reflections in U or V:                           " << numReflections << std::endl;
+	std::cout << "wrong singular value signs:                      " << numWrongSigns << std::endl;
+	if (checkBatch)
+	{
+		std::cout << "max. AVX2 batch singular value / reconstruction error / s_max: " << maxBatchDifference << std::endl;
+	}
+
+	return maxReconstructionError < tolerance && maxSingularValueError < tolerance && maxOrthogonalityError < tolerance
+		&& numReflections == 0 && numWrongSigns == 0 && maxBatchDifference < tolerance;
+}
+
+void
+SVD3x3Benchmark::printTiming(const char* name, double seconds, int numMatrices)
+{
+	std::cout << name << ": " << seconds * 1.0e9 / numMatrices << " ns per matrix" << std::endl;
+}
+
+bool
+SVD3x3Benchmark::run(int numMatrices)
+{
+	if (numMatrices < 1)
+	{
+		std::cout << "ERROR: SVD benchmark needs at least one matrix!" << std::endl;
+		return false;
+	}
+
+	std::vector<Eigen::Matrix3f> matrices;
+	generateMatrices(numMatrices, matrices);
+
+	std::cout << "SVD 3x3 benchmark, " << numMatrices << " matrices, instruction set: "
+		<< PBDSolverBatchKernel::getInstructionSetName() << std::endl;
+
+	const bool isAccurate = checkAccuracy(matrices);
+	std::cout << "Accuracy check " << (isAccurate ? "PASSED" : "FAILED") << std::endl;
+
+	Eigen::Matrix3f U;
+	Eigen::Matrix3f V;
+	Eigen::Matrix3f S;
+	Eigen::Vector3f singularValues;
+	Eigen::Matrix3f F;
+	Eigen::Matrix3f FTransposeF;
+	float sink = 0.0f;
+
+	//previous inversion handling: eigen decomposition of F^T F, then U = F V F_hat^-1
+	tbb::tick_count start = tbb::tick_count::now();
+	for (int i = 0; i < numMatrices; ++i)
+	{
+		FTransposeF = matrices[i].transpose() * matrices[i];
+		eigenDecompositionCardano(FTransposeF, S, V);
+
+		F.setZero();
+		for (int j = 0; j < 3; ++j)
+		{
+			F(j, j) = std::sqrt(std::max(S(j, j), 0.0f));
+		}
+		U = matrices[i] * V * F.inverse();
+		sink += U(0, 0) + F(0, 0);
+	}
+	printTiming("eigenDecompositionCardano + U", (tbb::tick_count::now() - start).seconds(), numMatrices);
+
+	start = tbb::tick_count::now();
+	for (int i = 0; i < numMatrices; ++i)
+	{
+		Eigen::JacobiSVD<Eigen::Matrix3f> svd(matrices[i], Eigen::ComputeFullU | Eigen::ComputeFullV);
+		sink += svd.matrixU()(0, 0) + svd.singularValues()[0];
+	}
+	printTiming("Eigen::JacobiSVD             ", (tbb::tick_count::now() - start).seconds(), numMatrices);
+
+	start = tbb::tick_count::now();
+	for (int i = 0; i < numMatrices; ++i)
+	{
+		svd3x3(matrices[i], U, singularValues, V);
+		sink += U(0, 0) + singularValues[0];
+	}
+	printTiming("svd3x3                       ", (tbb::tick_count::now() - start).seconds(), numMatrices);
+
+	if (PBDSolverBatchKernel::getInstructionSet() == PBDSolverBatchKernel::AVX2)
+	{
+		std::vector<Eigen::Matrix3f> batchU(numMatrices);
+		std::vector<Eigen::Matrix3f> batchV(numMatrices);
+		std::vector<Eigen::Vector3f> batchS(numMatrices);
+
+		start = tbb::tick_count::now();
+		svd3x3AVX2(matrices[0].data(), batchU[0].data(), batchS[0].data(), batchV[0].data(), numMatrices);
+		printTiming("svd3x3 AVX2 (8 lanes)        ", (tbb::tick_count::now() - start).seconds(), numMatrices);
+
+		sink += batchU[0](0, 0) + batchS[0][0];
+	}
+
+	s_benchmarkSink = sink;
+
+	return isAccurate;
+}
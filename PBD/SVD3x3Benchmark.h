@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+
+#include <Eigen\Dense>
+
+//Accuracy check and micro-benchmark of svd3x3 (SVD3x3.h). The accuracy is checked against Eigen's JacobiSVD on
+//random deformation gradients (mildly deformed, general, near-degenerate and inverted ones); the timings compare
+//the Cardano-based diagonalisation the solver used before, JacobiSVD, svd3x3 and its AVX2 batch version.
+class SVD3x3Benchmark
+{
+public:
+	//Returns false if the accuracy check fails.
+	static bool run(int numMatrices);
+
+private:
+	static void generateMatrices(int numMatrices, std::vector<Eigen::Matrix3f>& matrices);
+
+	static bool checkAccuracy(const std::vector<Eigen::Matrix3f>& matrices);
+
+	static void printTiming(const char* name, double seconds, int numMatrices);
+
+	SVD3x3Benchmark();
+	~SVD3x3Benchmark();
+};
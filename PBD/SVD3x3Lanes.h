@@ -0,0 +1,182 @@
+#pragma once
+
+#include "LaneMath.h"
+
+//Branch-free 3x3 SVD with a fixed amount of work (McAdams et al., "Computing the Singular Value Decomposition of
+//3x3 matrices with minimal branching and elementary floating point operations"):
+//1. eigen vectors V of A^T A by cyclic Jacobi sweeps with approximate Givens rotations, accumulated as a quaternion
+//2. B = A V, columns sorted by decreasing norm
+//3. QR decomposition of B by Givens rotations, B = U R; the diagonal of R are the singular values
+//
+//A = U * diag(S) * V^T where U and V are rotations (det = +1) and |S[0]| >= |S[1]| >= |S[2]|. Only S[2] can be
+//negative, which is the case for inverted elements (det(A) < 0); this is the convention inversion handling needs.
+//Templated on the lane type (see LaneMath.h), i.e. usable for single matrices and for SIMD batches. Free of Eigen, so
+//that PBDSolverBatchKernelAVX2.cpp can include it; SVD3x3.h adds the Eigen version.
+
+//Conjugates the symmetric matrix S with an approximate Givens rotation about axis k that reduces S(p, q) and
+//accumulates the rotation into the quaternion (qw, qv). (p, q, k) has to be a cyclic permutation of (0, 1, 2).
+template<typename Real>
+LANE_INLINE void svd3x3JacobiConjugation(LaneMat3<Real>& S, Real& qw, Real qv[3], int p, int q, int k)
+{
+	//3 + 2 * sqrt(2), cos(pi / 8), sin(pi / 8)
+	const float gamma = 5.828427124746190f;
+	const float cosPi8 = 0.923879532511287f;
+	const float sinPi8 = 0.382683432365090f;
+
+	const Real app = S.m[p][p];
+	const Real aqq = S.m[q][q];
+	const Real apq = S.m[p][q];
+
+	//no rotation once S(p, q) is negligible; this also keeps denormals (very slow) out of the products below
+	const auto noRotation = lanesLessEqual(lanesAbs(apq), Real(1.0e-8f) * (lanesAbs(app) + lanesAbs(aqq)));
+
+	//half angle; pi/8 where the approximation tan(x) ~ x would overshoot (angles beyond pi/8)
+	Real ch = Real(2.0f) * (app - aqq);
+	Real sh = lanesSelect(noRotation, Real(0.0f), apq);
+	const Real omega = lanesRsqrt(lanesMax(ch * ch + sh * sh, Real(1.0e-30f)));
+
+	const auto useApproximation = lanesLess(Real(gamma) * sh * sh, ch * ch);
+
+	ch = lanesSelect(useApproximation, omega * ch, Real(cosPi8));
+	sh = lanesSelect(useApproximation, omega * sh, Real(sinPi8));
+	ch = lanesSelect(noRotation, Real(1.0f), ch);
+	sh = lanesSelect(noRotation, Real(0.0f), sh);
+
+	//full angle
+	const Real c = ch * ch - sh * sh;
+	const Real s = Real(2.0f) * ch * sh;
+
+	//S = R^T S R, R = rotation about axis k
+	const Real cc = c * c;
+	const Real ss = s * s;
+	const Real cs = c * s;
+	const Real akp = S.m[k][p];
+	const Real akq = S.m[k][q];
+
+	S.m[p][p] = cc * app + Real(2.0f) * cs * apq + ss * aqq;
+	S.m[q][q] = ss * app - Real(2.0f) * cs * apq + cc * aqq;
+	S.m[p][q] = cs * (aqq - app) + (cc - ss) * apq;
+	S.m[q][p] = S.m[p][q];
+	S.m[k][p] = c * akp + s * akq;
+	S.m[p][k] = S.m[k][p];
+	S.m[k][q] = c * akq - s * akp;
+	S.m[q][k] = S.m[k][q];
+
+	//q = q * (ch, sh * e_k)
+	const Real w = qw;
+	const Real vp = qv[p];
+	const Real vq = qv[q];
+	const Real vk = qv[k];
+	qw = ch * w - sh * vk;
+	qv[p] = ch * vp + sh * vq;
+	qv[q] = ch * vq - sh * vp;
+	qv[k] = ch * vk + sh * w;
+}
+
+//Swaps columns i and j of B and V if 'mask' is set, negating one of them so that det(V) stays +1.
+template<typename Real, typename Mask>
+LANE_INLINE void svd3x3ConditionalSwap(const Mask& mask, LaneMat3<Real>& B, LaneMat3<Real>& V, Real rho[3], int i, int j)
+{
+	for (int r = 0; r < 3; ++r)
+	{
+		const Real bi = B.m[r][i];
+		B.m[r][i] = lanesSelect(mask, B.m[r][j], bi);
+		B.m[r][j] = lanesSelect(mask, -bi, B.m[r][j]);
+
+		const Real vi = V.m[r][i];
+		V.m[r][i] = lanesSelect(mask, V.m[r][j], vi);
+		V.m[r][j] = lanesSelect(mask, -vi, V.m[r][j]);
+	}
+
+	const Real rhoI = rho[i];
+	rho[i] = lanesSelect(mask, rho[j], rhoI);
+	rho[j] = lanesSelect(mask, rhoI, rho[j]);
+}
+
+//Givens rotation of rows (j, i) that zeroes B(i, j); the transposed rotation is accumulated into U.
+template<typename Real>
+LANE_INLINE void svd3x3GivensQR(LaneMat3<Real>& B, LaneMat3<Real>& U, int j, int i)
+{
+	const Real a1 = B.m[j][j];
+	const auto noRotation = lanesLessEqual(lanesAbs(B.m[i][j]), Real(1.0e-8f) * lanesAbs(a1));
+	const Real a2 = lanesSelect(noRotation, Real(0.0f), B.m[i][j]);
+
+	const Real invRho = lanesRsqrt(lanesMax(a1 * a1 + a2 * a2, Real(1.0e-30f)));
+	const Real c = lanesSelect(noRotation, Real(1.0f), a1 * invRho);
+	const Real s = a2 * invRho;
+
+	for (int col = 0; col < 3; ++col)
+	{
+		const Real bj = B.m[j][col];
+		const Real bi = B.m[i][col];
+		B.m[j][col] = c * bj + s * bi;
+		B.m[i][col] = c * bi - s * bj;
+	}
+
+	for (int row = 0; row < 3; ++row)
+	{
+		const Real uj = U.m[row][j];
+		const Real ui = U.m[row][i];
+		U.m[row][j] = c * uj + s * ui;
+		U.m[row][i] = c * ui - s * uj;
+	}
+}
+
+template<typename Real>
+LANE_INLINE void svd3x3(const LaneMat3<Real>& A, LaneMat3<Real>& U, Real S[3], LaneMat3<Real>& V)
+{
+	const int numSweeps = 5;
+
+	//1. JACOBI EIGEN ANALYSIS OF A^T A -----------------------------------------------------------------------------------------
+	LaneMat3<Real> ATA = laneMulTransposeA(A, A);
+
+	Real qw(1.0f);
+	Real qv[3] = { Real(0.0f), Real(0.0f), Real(0.0f) };
+
+	for (int sweep = 0; sweep < numSweeps; ++sweep)
+	{
+		svd3x3JacobiConjugation(ATA, qw, qv, 0, 1, 2);
+		svd3x3JacobiConjugation(ATA, qw, qv, 1, 2, 0);
+		svd3x3JacobiConjugation(ATA, qw, qv, 2, 0, 1);
+	}
+
+	const Real invLength = lanesRsqrt(qw * qw + qv[0] * qv[0] + qv[1] * qv[1] + qv[2] * qv[2]);
+	const Real w = qw * invLength;
+	const Real x = qv[0] * invLength;
+	const Real y = qv[1] * invLength;
+	const Real z = qv[2] * invLength;
+
+	V.m[0][0] = Real(1.0f) - Real(2.0f) * (y * y + z * z);
+	V.m[0][1] = Real(2.0f) * (x * y - w * z);
+	V.m[0][2] = Real(2.0f) * (x * z + w * y);
+	V.m[1][0] = Real(2.0f) * (x * y + w * z);
+	V.m[1][1] = Real(1.0f) - Real(2.0f) * (x * x + z * z);
+	V.m[1][2] = Real(2.0f) * (y * z - w * x);
+	V.m[2][0] = Real(2.0f) * (x * z - w * y);
+	V.m[2][1] = Real(2.0f) * (y * z + w * x);
+	V.m[2][2] = Real(1.0f) - Real(2.0f) * (x * x + y * y);
+
+	//2. SORT THE COLUMNS OF A V BY DECREASING NORM -----------------------------------------------------------------------------
+	LaneMat3<Real> B = laneMul(A, V);
+
+	Real rho[3];
+	for (int c = 0; c < 3; ++c)
+	{
+		rho[c] = B.m[0][c] * B.m[0][c] + B.m[1][c] * B.m[1][c] + B.m[2][c] * B.m[2][c];
+	}
+
+	svd3x3ConditionalSwap(lanesLess(rho[0], rho[1]), B, V, rho, 0, 1);
+	svd3x3ConditionalSwap(lanesLess(rho[0], rho[2]), B, V, rho, 0, 2);
+	svd3x3ConditionalSwap(lanesLess(rho[1], rho[2]), B, V, rho, 1, 2);
+
+	//3. QR DECOMPOSITION -------------------------------------------------------------------------------------------------------
+	laneSetIdentity(U);
+	svd3x3GivensQR(B, U, 0, 1);
+	svd3x3GivensQR(B, U, 0, 2);
+	svd3x3GivensQR(B, U, 1, 2);
+
+	for (int i = 0; i < 3; ++i)
+	{
+		S[i] = B.m[i][i];
+	}
+}
@@ -0,0 +1,120 @@
+#include "SolverScalingReport.h"
+
+#include <iostream>
+#include <fstream>
+
+#include <tbb\task_scheduler_init.h>
+
+#include "BenchmarkRun.h"
+
+SolverScalingReport::SolverScalingReport()
+{
+}
+
+
+SolverScalingReport::~SolverScalingReport()
+{
+}
+
+bool
+SolverScalingReport::run(const PBDSolverSettings& settings, int width, int height, int depth,
+	int numFrames, int maxNumThreads, const std::string& fileName)
+{
+	if (maxNumThreads <= 0)
+	{
+		maxNumThreads = tbb::task_scheduler_init::default_num_threads();
+	}
+
+	std::cout << "SCALING REPORT: tet bar [ " << width << " x " << height << " x " << depth << " ], "
+		<< numFrames << " frames, up to " << maxNumThreads << " threads." << std::endl;
+
+	//Serial reference
+	PBDSolverSettings serialSettings = settings;
+	serialSettings.useMultiThreadedSolver = false;
+	serialSettings.useJacobiSolver = false;
+	BenchmarkRunResult result;
+	{
+		tbb::task_scheduler_init init(1);
+		BenchmarkRun::measureTetBar(serialSettings, width, height, depth, numFrames, result);
+	}
+	const double serialTime = result.seconds;
+	std::cout << "Serial solver: " << serialTime << "s" << std::endl;
+
+	PBDSolverSettings multiSettings = settings;
+	multiSettings.useMultiThreadedSolver = true;
+	multiSettings.useJacobiSolver = false;
+
+	PBDSolverSettings jacobiSettings = settings;
+	jacobiSettings.useJacobiSolver = true;
+
+	std::vector<int> numThreads;
+	std::vector<double> times;
+	std::vector<double> jacobiTimes;
+	for (int n = 1; n <= maxNumThreads; n *= 2)
+	{
+		numThreads.push_back(n);
+	}
+	if (numThreads.back() != maxNumThreads)
+	{
+		numThreads.push_back(maxNumThreads);
+	}
+
+	for (int i = 0; i < numThreads.size(); ++i)
+	{
+		tbb::task_scheduler_init init(numThreads[i]);
+		BenchmarkRun::measureTetBar(multiSettings, width, height, depth, numFrames, result);
+		times.push_back(result.seconds);
+
+		std::cout << "Threads [ " << numThreads[i] << " ]: " << times[i] << "s; speedup vs. 1 thread: "
+			<< times[0] / times[i] << "; speedup vs. serial: " << serialTime / times[i] << std::endl;
+
+		BenchmarkRun::measureTetBar(jacobiSettings, width, height, depth, numFrames, result);
+		jacobiTimes.push_back(result.seconds);
+
+		std::cout << "Threads [ " << numThreads[i] << " ], Jacobi: " << jacobiTimes[i] << "s; speedup vs. 1 thread: "
+			<< jacobiTimes[0] / jacobiTimes[i] << "; speedup vs. serial: " << serialTime / jacobiTimes[i] << std::endl;
+	}
+
+	std::ofstream file;
+	file.open(fileName);
+	if (!file.is_open())
+	{
+		std::cout << "ERROR: Could not write [ " << fileName << " ]." << std::endl;
+		return false;
+	}
+
+	file << "meshDimensions = [ " << width << ", " << height << ", " << depth << " ];" << std::endl;
+	file << "numFrames = " << numFrames << ";" << std::endl;
+	file << "serialTime = " << serialTime << ";" << std::endl;
+
+	file << "numThreads = [ ";
+	for (int i = 0; i < numThreads.size(); ++i)
+	{
+		file << numThreads[i] << ((i < numThreads.size() - 1) ? ", " : " ];");
+	}
+	file << std::endl;
+
+	file << "times = [ ";
+	for (int i = 0; i < times.size(); ++i)
+	{
+		file << times[i] << ((i < times.size() - 1) ? ", " : " ];");
+	}
+	file << std::endl;
+
+	file << "jacobiTimes = [ ";
+	for (int i = 0; i < jacobiTimes.size(); ++i)
+	{
+		file << jacobiTimes[i] << ((i < jacobiTimes.size() - 1) ? ", " : " ];");
+	}
+	file << std::endl;
+
+	file << "speedup = times(1) ./ times;" << std::endl;
+	file << "speedupVsSerial = serialTime ./ times;" << std::endl;
+	file << "jacobiSpeedup = jacobiTimes(1) ./ jacobiTimes;" << std::endl;
+	file << "jacobiSpeedupVsSerial = serialTime ./ jacobiTimes;" << std::endl;
+
+	file.close();
+	file.clear();
+
+	return true;
+}
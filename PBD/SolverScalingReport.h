@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "PBDSolverSettings.h"
+
+//Measures the speedup of the multi-threaded (graph-coloured) and of the Jacobi constraint projection against the
+//number of worker threads on a generated tet bar and writes the results as a Matlab script.
+class SolverScalingReport
+{
+public:
+	static bool run(const PBDSolverSettings& settings, int width, int height, int depth,
+		int numFrames, int maxNumThreads, const std::string& fileName);
+
+private:
+	SolverScalingReport();
+	~SolverScalingReport();
+};
@@ -0,0 +1,62 @@
+#include "SubsteppingBenchmark.h"
+
+#include <iostream>
+
+#include "BenchmarkRun.h"
+
+SubsteppingBenchmark::SubsteppingBenchmark()
+{
+}
+
+
+SubsteppingBenchmark::~SubsteppingBenchmark()
+{
+}
+
+bool
+SubsteppingBenchmark::run(const PBDSolverSettings& settings, int width, int height, int depth, int numFrames)
+{
+	if (numFrames < 1)
+	{
+		std::cout << "ERROR: Substepping benchmark needs at least one frame!" << std::endl;
+		return false;
+	}
+
+	std::cout << "SUBSTEPPING BENCHMARK: tet bar [ " << width << " x " << height << " x " << depth << " ], "
+		<< numFrames << " frames, Young's modulus " << settings.youngsModulus << ", XPBD." << std::endl;
+
+	//positions and velocities are floats, so (x - x_previous) / deltaT loses precision for very small substeps; the
+	//reference therefore stays at a moderate substep count and converges the iterations instead
+	const int referenceSubsteps = 16;
+	const int referenceIts = 32;
+
+	PBDSolverSettings benchmarkSettings = settings;
+	benchmarkSettings.useXPBD = true;
+	benchmarkSettings.numSubsteps = referenceSubsteps;
+	benchmarkSettings.numConstraintIts = referenceIts;
+
+	BenchmarkRunResult reference;
+	BenchmarkRun::measureTetBar(benchmarkSettings, width, height, depth, numFrames, reference);
+	std::cout << "Reference [ " << referenceSubsteps << " substeps x " << referenceIts << " its ]: "
+		<< reference.seconds << "s" << std::endl;
+
+	//iteration-heavy configurations first, then substepping at (roughly) the same projection counts
+	const int numConfigurations = 10;
+	const int substeps[numConfigurations] = { 1, 1, 1, 1, 2, 4, 8, 2, 4, 8 };
+	const int its[numConfigurations] = { 5, 10, 20, 40, 5, 2, 1, 10, 5, 4 };
+
+	BenchmarkRunResult result;
+	for (int c = 0; c < numConfigurations; ++c)
+	{
+		benchmarkSettings.numSubsteps = substeps[c];
+		benchmarkSettings.numConstraintIts = its[c];
+
+		BenchmarkRun::measureTetBar(benchmarkSettings, width, height, depth, numFrames, result);
+		const float error = BenchmarkRun::computeRMSDistance(result.positions, reference.positions);
+
+		std::cout << "[ " << substeps[c] << " substeps x " << its[c] << " its ]: " << result.seconds << "s; RMS distance to reference: "
+			<< error << "; time per frame: " << 1000.0 * result.seconds / numFrames << "ms" << std::endl;
+	}
+
+	return true;
+}
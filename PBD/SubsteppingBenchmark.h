@@ -0,0 +1,17 @@
+#pragma once
+
+#include "PBDSolverSettings.h"
+
+//Compares the iteration-heavy solver path (one step per frame, many constraint iterations) with substepping (many
+//substeps with one or a few iterations each) on a generated tet bar. Every configuration is timed and its final
+//positions are compared against a reference run with a large number of substeps and iterations. XPBD is enabled
+//for all runs, as plain PBD converges to a different material stiffness for every configuration.
+class SubsteppingBenchmark
+{
+public:
+	static bool run(const PBDSolverSettings& settings, int width, int height, int depth, int numFrames);
+
+private:
+	SubsteppingBenchmark();
+	~SubsteppingBenchmark();
+};
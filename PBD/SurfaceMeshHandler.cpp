@@ -32,7 +32,7 @@ SurfaceMeshHandler::setSample(const std::vector<Eigen::Vector3f>& positions)
 }
 
 void
-SurfaceMeshHandler::initTopology(std::vector<PBDParticle>& particles, std::vector<PBDTetrahedra3d>& tets)
+SurfaceMeshHandler::initTopology(PBDParticleStore& particles, std::vector<PBDTetrahedra3d>& tets)
 {
 	m_vertices.resize(particles.size());
 
@@ -19,7 +19,7 @@ public:
 	SurfaceMeshHandler(const std::string& surfaceMeshFile, const std::string& abcFile);
 	~SurfaceMeshHandler();
 
-	void initTopology(std::vector<PBDParticle>& particles, std::vector<PBDTetrahedra3d>& tets);
+	void initTopology(PBDParticleStore& particles, std::vector<PBDTetrahedra3d>& tets);
 
 	void setSample(const std::vector<Eigen::Vector3f>& positions);
 
@@ -17,7 +17,7 @@ TetGenIO::~TetGenIO()
 
 
 bool
-TetGenIO::readNodes(const std::string& fileName, std::vector<PBDParticle>& particles,
+TetGenIO::readNodes(const std::string& fileName, PBDParticleStore& particles,
 	float inverseMass, Eigen::Vector3f velocity)
 {
 	std::ifstream file;
@@ -61,7 +61,7 @@ TetGenIO::readNodes(const std::string& fileName, std::vector<PBDParticle>& parti
 		position.y() = std::stod(inputs[2 + add]);
 		position.z() = std::stod(inputs[3 + add]);
 
-		particles.emplace_back(position, velocity, inverseMass);
+		particles.addParticle(position, velocity, inverseMass);
 	}
 
 	std::cout << "Read " << particles.size() << " nodes." << std::endl;
@@ -70,7 +70,7 @@ TetGenIO::readNodes(const std::string& fileName, std::vector<PBDParticle>& parti
 
 bool
 TetGenIO::readTetrahedra(const std::string& fileName, std::vector<PBDTetrahedra3d>& tetrahedra,
-	const std::shared_ptr<std::vector<PBDParticle>>& particles)
+	const std::shared_ptr<PBDParticleStore>& particles)
 {
 	std::ifstream file;
 	file.open(fileName);
@@ -137,6 +137,8 @@ TetGenIO::readTetrahedra(const std::string& fileName, std::vector<PBDTetrahedra3
 		++tetIDx;
 	}
 
+	particles->initialiseTetAdjacency(tetrahedra);
+
 	std::cout << "Read " << tetrahedra.size() << " tets. " << std::endl;
 	return true;
 }	
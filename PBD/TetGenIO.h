@@ -11,11 +11,11 @@
 class TetGenIO
 {
 public:
-	static bool readNodes(const std::string& fileName, std::vector<PBDParticle>& particles,
+	static bool readNodes(const std::string& fileName, PBDParticleStore& particles,
 		float inverseMass, Eigen::Vector3f velocity);
 
 	static bool readTetrahedra(const std::string& fileName, std::vector<PBDTetrahedra3d>& tetrahedra,
-		const std::shared_ptr<std::vector<PBDParticle>>& particles);
+		const std::shared_ptr<PBDParticleStore>& particles);
 
 private:
 
@@ -14,7 +14,7 @@ VegaIO::~VegaIO()
 
 bool
 VegaIO::writeVegFile(const std::vector<PBDTetrahedra3d>& tetrahedra,
-const std::shared_ptr<std::vector<PBDParticle>> particles, const std::string& fileName)
+const std::shared_ptr<PBDParticleStore> particles, const std::string& fileName)
 {
 	std::ofstream file;
 	file.open(fileName);
@@ -12,6 +12,6 @@ public:
 	~VegaIO();
 
 	static bool writeVegFile(const std::vector<PBDTetrahedra3d>& tetrahedra,
-		const std::shared_ptr<std::vector<PBDParticle>> particles, const std::string& fileName);
+		const std::shared_ptr<PBDParticleStore> particles, const std::string& fileName);
 };
 
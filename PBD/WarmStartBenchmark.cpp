@@ -0,0 +1,99 @@
+#include "WarmStartBenchmark.h"
+
+#include <iostream>
+#include <algorithm>
+
+#include "PBDSimulationContext.h"
+
+WarmStartBenchmark::WarmStartBenchmark()
+{
+}
+
+
+WarmStartBenchmark::~WarmStartBenchmark()
+{
+}
+
+void
+WarmStartBenchmark::simulate(const PBDSolverSettings& settings, int numFrames, bool useWarmStarting, BenchmarkRunResult& result)
+{
+	PBDSimulationContext context;
+	context.generateTetBar(20, 6, 6);
+
+	PBDParticleStore& particles = *context.getParticles();
+
+	//clamp the x = min end, drive the x = max end
+	float minX = particles.position(0).x();
+	float maxX = particles.position(0).x();
+	for (int p = 0; p < particles.size(); ++p)
+	{
+		minX = std::min(minX, particles.position(p).x());
+		maxX = std::max(maxX, particles.position(p).x());
+	}
+
+	std::vector<int> drivenParticles;
+	for (int p = 0; p < particles.size(); ++p)
+	{
+		if (particles.position(p).x() < minX + 1e-4f)
+		{
+			particles.inverseMass(p) = 0.0f;
+		}
+		else if (particles.position(p).x() > maxX - 1e-4f)
+		{
+			particles.inverseMass(p) = 0.0f;
+			drivenParticles.push_back(p);
+		}
+	}
+
+	//the driven end moves by a quarter of the bar length over the run
+	const float displacementPerFrame = 0.25f * (maxX - minX) / (float)numFrames;
+
+	PBDSolverSettings localSettings = settings;
+	localSettings.gravity = 0.0f;
+	localSettings.useWarmStarting = useWarmStarting;
+
+	context.initialiseFirstFrame(localSettings);
+
+	BenchmarkRun::measure(context, numFrames, [&](PBDSimulationContext&, int)
+	{
+		for (int i = 0; i < drivenParticles.size(); ++i)
+		{
+			particles.position(drivenParticles[i]).z() += displacementPerFrame;
+			particles.previousPosition(drivenParticles[i]).z() += displacementPerFrame;
+		}
+	}, result);
+}
+
+bool
+WarmStartBenchmark::run(const PBDSolverSettings& settings, int numFrames, float constraintTolerance, int maxNumConstraintIts)
+{
+	if (numFrames < 1 || constraintTolerance <= 0.0f || maxNumConstraintIts < 1)
+	{
+		std::cout << "ERROR: Warm start benchmark needs at least one frame, one sweep and a positive tolerance!" << std::endl;
+		return false;
+	}
+
+	if (!settings.useMultiThreadedSolver)
+	{
+		std::cout << "ERROR: The warm start benchmark needs the multi-threaded solver!" << std::endl;
+		return false;
+	}
+
+	PBDSolverSettings benchmarkSettings = settings;
+	benchmarkSettings.constraintTolerance = constraintTolerance;
+	benchmarkSettings.numConstraintIts = maxNumConstraintIts;
+	benchmarkSettings.useXPBD = true;
+
+	std::cout << "WARM START BENCHMARK (XPBD): " << numFrames << " frames, tolerance " << constraintTolerance << ", at most "
+		<< maxNumConstraintIts << " sweeps per step, decay " << settings.warmStartDecay << ", Young's modulus "
+		<< settings.youngsModulus << "." << std::endl;
+
+	BenchmarkRunResult cold;
+	BenchmarkRunResult warm;
+	simulate(benchmarkSettings, numFrames, false, cold);
+	simulate(benchmarkSettings, numFrames, true, warm);
+
+	BenchmarkRun::printComparison("cold start", cold, "warm start", warm, numFrames);
+
+	return true;
+}
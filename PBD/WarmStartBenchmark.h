@@ -0,0 +1,21 @@
+#pragma once
+
+#include "PBDSolverSettings.h"
+#include "BenchmarkRun.h"
+
+//Number of sweeps the multi-threaded solver needs to reach a constraint tolerance with and without warm starting,
+//in a quasi-static loading scenario in the spirit of applyContinuousDeformationToMesh: a tet bar clamped at one end
+//whose other end is pulled sideways by a small amount every frame. XPBD is used, as the PBD energy projection does
+//not settle below a tolerance under load. The final positions of the cold and warm started runs are compared.
+class WarmStartBenchmark
+{
+public:
+	static bool run(const PBDSolverSettings& settings, int numFrames, float constraintTolerance, int maxNumConstraintIts);
+
+private:
+	//Sets up the loaded bar and measures it
+	static void simulate(const PBDSolverSettings& settings, int numFrames, bool useWarmStarting, BenchmarkRunResult& result);
+
+	WarmStartBenchmark();
+	~WarmStartBenchmark();
+};
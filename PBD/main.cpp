@@ -1,6 +1,7 @@
 #define _USE_MATH_DEFINES
 
 #include <iostream>
+#include <fstream>
 #include <chrono>
 #include <thread>
 
@@ -20,6 +21,7 @@
 #include "PBDTetrahedra3d.h"
 #include "PBDSolver.h"
 #include "PBDSolverSettings.h"
+#include "PBDSimulationContext.h"
 #include "PBDProbabilisticConstraint.h"
 
 #include "GLUTHelper.h"
@@ -38,21 +40,24 @@
 #include "CollisionSphere.h"
 
 #include "MovingHardConstraints.h"
-
-std::vector<PBDTetrahedra3d> tetrahedra;
-std::shared_ptr<std::vector<PBDParticle>> particles = std::make_shared<std::vector<PBDParticle>>();
+#include "SolverScalingReport.h"
+#include "SVD3x3Benchmark.h"
+#include "KernelCheck.h"
+#include "SubsteppingBenchmark.h"
+#include "ChebyshevBenchmark.h"
+#include "WarmStartBenchmark.h"
+#include "ParameterSweep.h"
+#include "BenchmarkSuite.h"
+
+//mesh, particles, colliders, drivers, solver settings and solver
+PBDSimulationContext simulation;
+
+//Alembic samples / FEM rest positions
 std::vector<Eigen::Vector3f> currentPositions;
 std::vector<Eigen::Vector3f> initialPositions;
-std::vector<int> numConstraintInfluences;
-std::vector<PBDProbabilisticConstraint> probabilisticConstraints;
 std::vector<std::vector<Eigen::Vector2f>> trackingData;
 std::shared_ptr<FiberMesh> fiberMesh;
-std::vector<CollisionMesh> collisionGeometry;
-std::vector<CollisionRod> collisionGeometry2;
-std::vector<CollisionSphere> collisionGeometry3;
-std::vector<MovingHardConstraints> movingConstraints;
 
-PBDSolver solver;
 FEMSimulator FEMsolver;
 
 std::shared_ptr<SurfaceMeshHandler> smHandler;
@@ -78,10 +83,13 @@ void applyPressure();
 
 void updateMovingHardConstraints()
 {
+	std::vector<MovingHardConstraints>& movingConstraints = simulation.getMovingConstraints();
 	for (int i = 0; i < movingConstraints.size(); ++i)
 	{
-		movingConstraints[i].updatePositions(*particles, parameters.getCurrentFrame(), parameters.solverSettings.deltaT, 0);
-		movingConstraints[i].updatePositions(*particles, parameters.getCurrentFrame(), parameters.solverSettings.deltaT, 1);
+		movingConstraints[i].updatePositions(*simulation.getParticles(), simulation.getCurrentFrame(),
+			simulation.getSettings().deltaT, 0);
+		movingConstraints[i].updatePositions(*simulation.getParticles(), simulation.getCurrentFrame(),
+			simulation.getSettings().deltaT, 1);
 	}
 
 }
@@ -98,13 +106,16 @@ std::string generateFileName(const std::string& base, const std::string& extensi
 
 void applyFEMDisplacementsToParticles()
 {
+	std::shared_ptr<PBDParticleStore>& particles = simulation.getParticles();
+
 	std::vector<double>& displacements = FEMsolver.getCurrentDisplacements();
 
+	//the previous positions are the committed state that is rendered and written out
 	for (int i = 0; i < displacements.size(); i += 3)
 	{
-		(*particles)[i / 3].position()[0] = initialPositions[i / 3][0] + displacements[i];
-		(*particles)[i / 3].position()[1] = initialPositions[i / 3][1] + displacements[i + 1];
-		(*particles)[i / 3].position()[2] = initialPositions[i / 3][2] + displacements[i + 2];
+		(*particles)[i / 3].previousPosition()[0] = initialPositions[i / 3][0] + displacements[i];
+		(*particles)[i / 3].previousPosition()[1] = initialPositions[i / 3][1] + displacements[i + 1];
+		(*particles)[i / 3].previousPosition()[2] = initialPositions[i / 3][2] + displacements[i + 2];
 
 		//std::cout << (*particles)[i / 3].position() << std::endl;
 		displacements[i] = 0;
@@ -115,15 +126,19 @@ void applyFEMDisplacementsToParticles()
 
 void setInitialPositionsFromParticles()
 {
+	std::shared_ptr<PBDParticleStore>& particles = simulation.getParticles();
+
 	initialPositions.resize(particles->size());
 	for (int i = 0; i < particles->size(); ++i)
 	{
-		initialPositions[i] = (*particles)[i].position();
+		initialPositions[i] = (*particles)[i].previousPosition();
 	}
 }
 
 void getCurrentPositionFromParticles()
 {
+	std::shared_ptr<PBDParticleStore>& particles = simulation.getParticles();
+
 	if (currentPositions.size() == 0)
 	{
 		currentPositions.resize(particles->size());
@@ -131,7 +146,7 @@ void getCurrentPositionFromParticles()
 
 	for (int i = 0; i < (*particles).size(); ++i)
 	{
-		currentPositions[i] = (*particles)[i].position();
+		currentPositions[i] = (*particles)[i].previousPosition();
 	}
 }
 
@@ -144,7 +159,7 @@ void updateProbabilisticConstraints()
 	{
 		Eigen::Vector3f currentConstraintPosition =
 			TrackerIO::getInterpolatedConstraintPosition(trackingData[trackingDataIndices[i]], 1.0f / 24.0f,
-			parameters.solverSettings.deltaT, parameters.getCurrentFrame() * parameters.solverSettings.deltaT);
+			simulation.getSettings().deltaT, simulation.getCurrentFrame() * simulation.getSettings().deltaT);
 
 		float scaleFactor = 0.01;
 
@@ -158,16 +173,17 @@ void updateProbabilisticConstraints()
 		//2. Rescale
 		currentConstraintPosition *= scaleFactor;
 
-		probabilisticConstraints[activeConstraintIndices[i]].getConstraintPosition() = currentConstraintPosition;
+		simulation.getProbabilisticConstraints()[activeConstraintIndices[i]].getConstraintPosition() = currentConstraintPosition;
 	}
 }
 
 void createProabilisticConstraints()
 {
+	std::vector<PBDProbabilisticConstraint>& probabilisticConstraints = simulation.getProbabilisticConstraints();
 	probabilisticConstraints.resize(2);
 	updateProbabilisticConstraints();
-	probabilisticConstraints[0].initialise(*particles, 0.1f);
-	probabilisticConstraints[1].initialise(*particles, 0.2f);
+	probabilisticConstraints[0].initialise(*simulation.getParticles(), 0.1f);
+	probabilisticConstraints[1].initialise(*simulation.getParticles(), 0.2f);
 }
 
 void setCamera()
@@ -211,6 +227,8 @@ void setCamera()
 
 void determineLookAt()
 {
+	std::shared_ptr<PBDParticleStore>& particles = simulation.getParticles();
+
 	//1. Compute Barycentre
 	Eigen::Vector3f baryCentreTemp;
 	baryCentreTemp.setZero();
@@ -254,17 +272,18 @@ void mainLoopGlut(void)
 	mainLoop();
 }
 
-void mainLoop()
+//Scenario updates of the current frame that the solver does not do itself; no OpenGL calls
+void prepareFrame()
 {
 	//Apply initial deformation if necessary
 	if (parameters.applyInitialDeformationToMesh)
 	{
-		if (parameters.getCurrentFrame() == parameters.frame2ApplyInitialDeformation)
+		if (simulation.getCurrentFrame() == parameters.frame2ApplyInitialDeformation)
 		{
 			applyInitialDeformationToMesh();
 		}
 
-		if (parameters.getCurrentFrame() == parameters.frame2DisApplyInitialDeformation)
+		if (simulation.getCurrentFrame() == parameters.frame2DisApplyInitialDeformation)
 		{
 			disapplyInitialDeformationToMesh();
 		}
@@ -300,11 +319,90 @@ void mainLoop()
 		applyPressure();
 	}
 
-	updateMovingHardConstraints();
+	//the PBD solver moves the hard constraints itself, at its substep times
+	if (parameters.disableSolver || parameters.useFEMSolver)
+	{
+		updateMovingHardConstraints();
+	}
+
+	simulation.getSettings().calculateLambda();
+	simulation.getSettings().calculateMu();
+	simulation.getSettings().calculateFiberStructureTensor();
+}
 
-	parameters.solverSettings.calculateLambda();
-	parameters.solverSettings.calculateMu();
-	parameters.solverSettings.calculateFiberStructureTensor();
+//Steps the PBD (or FEM) solver by one frame, moving the simulation on to the next frame, and adds its time to
+//parameters.executionTimeSum
+void advanceFrame()
+{
+	const int frame = simulation.getCurrentFrame();
+
+	//Advance Solver
+	tbb::tick_count start = tbb::tick_count::now();
+	if (!parameters.disableSolver)
+	{
+		if (!parameters.useFEMSolver)
+		{
+			if (parameters.useTrackingConstraints)
+			{
+				updateProbabilisticConstraints();
+			}
+			simulation.step();
+		}
+		else
+		{
+			FEMsolver.doTimeStep(true);
+			applyFEMDisplacementsToParticles();
+			simulation.increaseCurrentFrame();
+		}
+	}
+	tbb::tick_count end = tbb::tick_count::now();
+	parameters.executionTimeSum += (end - start).seconds();
+	if (frame % parameters.timingPrintInterval == 0)
+	{
+		std::cout << "Average simulation Time: " << parameters.executionTimeSum / frame << "s."
+			<< "FRAME: [ " << frame << " ]; constraint its: " << simulation.getSolver().getNumConstraintItsUsed()
+			<< " (residual " << simulation.getSolver().getConstraintResidual() << ")" << std::endl;
+	}
+}
+
+//Records the Alembic sample; returns true once maxFrames have been simulated
+bool finishFrame()
+{
+	if (parameters.writeToAlembic)
+	{
+		getCurrentPositionFromParticles();
+		smHandler->setSample(currentPositions);
+	}
+
+	return parameters.maxFrames <= simulation.getCurrentFrame();
+}
+
+//Debug output, counters and profiles at the end of a run
+void writeRunSummary()
+{
+	//Write all debug information
+	simulation.getSettings().tracker.writeAll();
+
+	simulation.getSolver().getInversionHandlingCounters().print();
+	if (simulation.getSettings().useSleeping)
+	{
+		simulation.getSolver().getActivityTracker().getCounts().print();
+	}
+
+	if (simulation.getSettings().enableProfiling)
+	{
+		simulation.getSolver().getProfiler().print();
+		simulation.getSolver().getProfiler().writeCSV("SolverProfile.csv");
+		simulation.getSolver().getProfiler().writeChromeTrace("SolverProfile.json");
+	}
+}
+
+void mainLoop()
+{
+	//step() moves the simulation on to the next frame
+	const int frame = simulation.getCurrentFrame();
+
+	prepareFrame();
 
 	//GLenum err = glGetError();
 	//if (err != GL_NO_ERROR)
@@ -333,27 +431,28 @@ void mainLoop()
 	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
 	//Render Tets
-	for (int t = 0; t < tetrahedra.size(); ++t)
+	for (int t = 0; t < simulation.getTetrahedra().size(); ++t)
 	{
-		tetrahedra[t].glRender(1.0, 1.0, 1.0);
+		simulation.getTetrahedra()[t].glRender(1.0, 1.0, 1.0);
 	}
 	//glDisable(GL_POLYGON_OFFSET_LINE);
 
 	if (parameters.renderCollisionGoemetry)
 	{
-		for (int i = 0; i < collisionGeometry2.size(); ++i)
+		for (int i = 0; i < simulation.getCollisionGeometry2().size(); ++i)
 		{
-			collisionGeometry2[i].glRender(parameters.getCurrentFrame(), parameters.solverSettings.deltaT,
-				parameters.solverSettings.collisionSpheresNum[i], parameters.solverSettings.collisionSpheresRadius[i]);
+			simulation.getCollisionGeometry2()[i].glRender(simulation.getCurrentFrame(), simulation.getSettings().deltaT,
+				simulation.getSettings().collisionSpheresNum[i], simulation.getSettings().collisionSpheresRadius[i]);
 		}
 
-		for (int i = 0; i < collisionGeometry3.size(); ++i)
+		for (int i = 0; i < simulation.getCollisionGeometry3().size(); ++i)
 		{
-			collisionGeometry3[i].glRender(parameters.getCurrentFrame(), parameters.solverSettings.deltaT,
-				parameters.solverSettings.collisionSpheresRadius[i]);
+			simulation.getCollisionGeometry3()[i].glRender(simulation.getCurrentFrame(), simulation.getSettings().deltaT,
+				simulation.getSettings().collisionSpheresRadius[i]);
 		}
 	}
 
+	const std::vector<PBDProbabilisticConstraint>& probabilisticConstraints = simulation.getProbabilisticConstraints();
 	for (int i = 0; i < probabilisticConstraints.size(); ++i)
 	{
 		glPushMatrix();
@@ -365,32 +464,7 @@ void mainLoop()
 		glPopMatrix();
 	}
 
-	//Advance Solver
-	tbb::tick_count start = tbb::tick_count::now();
-	if (!parameters.disableSolver)
-	{
-		if (!parameters.useFEMSolver)
-		{
-			if (parameters.useTrackingConstraints)
-			{
-				updateProbabilisticConstraints();
-			}
-			solver.advanceSystem(tetrahedra, particles, parameters.solverSettings, currentPositions, numConstraintInfluences,
-				probabilisticConstraints, collisionGeometry, collisionGeometry2, collisionGeometry3);
-		}
-		else
-		{
-			FEMsolver.doTimeStep(true);
-			applyFEMDisplacementsToParticles();
-		}
-	}
-	tbb::tick_count end = tbb::tick_count::now();
-	parameters.executionTimeSum += (end - start).seconds();
-	if (parameters.getCurrentFrame() % parameters.timingPrintInterval == 0)
-	{
-		std::cout << "Average simulation Time: " << parameters.executionTimeSum / parameters.getCurrentFrame() << "s."
-			<< "FRAME: [ " << parameters.getCurrentFrame() << " ]" << std::endl;
-	}
+	advanceFrame();
 
 	glPopMatrix();
 	glMatrixMode(GL_PROJECTION);
@@ -399,27 +473,16 @@ void mainLoop()
 
 	if (parameters.doImageIO)
 	{
-		saveImage(700, 700, parameters.getCurrentFrame(), parameters.imageFileName);
+		saveImage(700, 700, frame, parameters.imageFileName);
 	}
 
 	TwDraw();
 
 	glutSwapBuffers();
-	if (!parameters.disableSolver)
-	{
-		parameters.increaseCurrentFrame();
-	}
 
-	if (parameters.writeToAlembic)
+	if (finishFrame())
 	{
-		getCurrentPositionFromParticles();
-		smHandler->setSample(currentPositions);
-	}
-
-	if (parameters.maxFrames <= parameters.getCurrentFrame())
-	{
-		//Write all debug information
-		parameters.solverSettings.tracker.writeAll();
+		writeRunSummary();
 
 		std::cout << "Leaving Glut Main Loop..." << std::endl;
 		glutLeaveMainLoop();
@@ -458,7 +521,9 @@ void TerminateAll(void)
 
 void collapseMesh()
 {
-	if (parameters.getCurrentFrame() != 1)
+	std::shared_ptr<PBDParticleStore>& particles = simulation.getParticles();
+
+	if (simulation.getCurrentFrame() != 1)
 	{
 		return;
 	}
@@ -467,9 +532,9 @@ void collapseMesh()
 
 	for (int p = 0; p < particles->size(); ++p)
 	{
-		if ((*particles)[p].position()[parameters.dimToCollapse] > minDimValue)
+		if ((*particles)[p].previousPosition()[parameters.dimToCollapse] > minDimValue)
 		{
-			minDimValue = (*particles)[p].position()[parameters.dimToCollapse];
+			minDimValue = (*particles)[p].previousPosition()[parameters.dimToCollapse];
 		}
 	}
 
@@ -487,28 +552,34 @@ void collapseMesh()
 
 void applyInitialDeformationToMesh()
 {
+	std::shared_ptr<PBDParticleStore>& particles = simulation.getParticles();
+
 	(*particles)[1].position().y() += 0.5f;
 	(*particles)[1].previousPosition().y() += 0.5f;
 }
 
 void disapplyInitialDeformationToMesh()
 {
+	std::shared_ptr<PBDParticleStore>& particles = simulation.getParticles();
+
 	(*particles)[1].position().y() -= 0.5f;
 	(*particles)[1].previousPosition().y() -= 0.5f;
 }
 
 void applyContinuousDeformationToMesh()
 {
-	if (parameters.getCurrentFrame() < parameters.continuousDeformationRelaxationFrame)
+	std::shared_ptr<PBDParticleStore>& particles = simulation.getParticles();
+
+	if (simulation.getCurrentFrame() < parameters.continuousDeformationRelaxationFrame)
 	{
 		//float increaseFactor = parameters.continuousDeformationStrainIncreaseFactor;
 		//(*particles)[1].position().y() += parameters.continuousDeformationStrainIncreaseFactor;
-		(*particles)[1].previousPosition().z() -= parameters.continuousDeformationStrainIncreaseFactor * (parameters.continuousDeformationRelaxationFrame - parameters.getCurrentFrame());
+		(*particles)[1].previousPosition().z() -= parameters.continuousDeformationStrainIncreaseFactor * (parameters.continuousDeformationRelaxationFrame - simulation.getCurrentFrame());
 	}
-	else if (parameters.getCurrentFrame() < parameters.continuousDeformationRelaxationFrame * 2)
+	else if (simulation.getCurrentFrame() < parameters.continuousDeformationRelaxationFrame * 2)
 	{
 		//(*particles)[1].position().y() -= parameters.continuousDeformationStrainIncreaseFactor;
-		(*particles)[1].previousPosition().z() += parameters.continuousDeformationStrainIncreaseFactor * ((parameters.getCurrentFrame() - parameters.continuousDeformationRelaxationFrame));
+		(*particles)[1].previousPosition().z() += parameters.continuousDeformationStrainIncreaseFactor * ((simulation.getCurrentFrame() - parameters.continuousDeformationRelaxationFrame));
 	}
 	//else
 	//{
@@ -518,7 +589,9 @@ void applyContinuousDeformationToMesh()
 
 void invertSingleElementAtStart()
 {
-	if (parameters.getCurrentFrame() == 1)
+	std::shared_ptr<PBDParticleStore>& particles = simulation.getParticles();
+
+	if (simulation.getCurrentFrame() == 1)
 	{
 		switch (parameters.TEST_VERSION)
 		{
@@ -569,12 +642,12 @@ void invertSingleElementAtStart()
 
 void createFiberMesh()
 {
-	if (parameters.getCurrentFrame() != 1)
+	if (simulation.getCurrentFrame() != 1)
 	{
 		return;
 	}
 
-	fiberMesh = std::make_shared <FiberMesh>(particles, &tetrahedra);
+	fiberMesh = std::make_shared <FiberMesh>(simulation.getParticles(), &simulation.getTetrahedra());
 
 	//	Eigen::Vector3f origin(0.0f, 0.0f, 0.0f);
 	//	Eigen::Vector3f dimension(5.0f, 3.0f, 3.0f);
@@ -587,42 +660,263 @@ void createFiberMesh()
 
 void applyCollisitionGeometryTranslation()
 {
-	if (parameters.getCurrentFrame() < parameters.collisionGeometryTranslateUntilFrame)
+	if (simulation.getCurrentFrame() < parameters.collisionGeometryTranslateUntilFrame)
 	{
-		collisionGeometry[0].getCollisionMeshTranslation() += parameters.collisionGeometryTranslationAmount;
+		simulation.getCollisionGeometry()[0].getCollisionMeshTranslation() += parameters.collisionGeometryTranslationAmount;
 	}
 }
 
 void applyPressure()
 {
-	if (parameters.getCurrentFrame() > parameters.pressureStartFrame
-		&& parameters.getCurrentFrame() < parameters.pressureEndFrame)
+	std::shared_ptr<PBDParticleStore>& particles = simulation.getParticles();
+
+	if (simulation.getCurrentFrame() > parameters.pressureStartFrame
+		&& simulation.getCurrentFrame() < parameters.pressureEndFrame)
 	{
 		for (int i = 0; i < particles->size(); ++i)
 		{
-			float dist = ((*particles)[i].position() - parameters.pressureCentre).squaredNorm();
+			float dist = ((*particles)[i].previousPosition() - parameters.pressureCentre).squaredNorm();
 			if (dist < parameters.pressureRadius)
 			{
-				(*particles)[i].previousVelocity() += parameters.pressureForce * parameters.solverSettings.deltaT;
+				(*particles)[i].previousVelocity() += parameters.pressureForce * simulation.getSettings().deltaT;
 			}
 		}
 	}
 }
 
+//Steps the scenario set up by parseTerminalParameters / doIO for maxFrames as fast as possible: no window, TweakBar,
+//rendering or frame sleeps. Writes the Alembic output like the GLUT loop and a timing summary next to it.
+int runHeadless()
+{
+	if (parameters.disableSolver)
+	{
+		std::cout << "ERROR: Headless runs need the solver enabled!" << std::endl;
+		return 1;
+	}
+
+	if (parameters.doImageIO)
+	{
+		std::cout << "Headless run: no image output without a window." << std::endl;
+	}
+
+	std::cout << "Running headless for " << parameters.maxFrames << " frames..." << std::endl;
+
+	const int startFrame = simulation.getCurrentFrame();
+	tbb::tick_count start = tbb::tick_count::now();
+
+	do
+	{
+		prepareFrame();
+		advanceFrame();
+	} while (!finishFrame());
+
+	tbb::tick_count end = tbb::tick_count::now();
+
+	writeRunSummary();
+
+	//the Alembic archive is written out when the handler is destroyed
+	smHandler.reset();
+
+	const int numFrames = simulation.getCurrentFrame() - startFrame;
+	const double wallTime = (end - start).seconds();
+
+	std::stringstream summary;
+	summary << "frames: " << numFrames << std::endl;
+	summary << "wall time [s]: " << wallTime << std::endl;
+	summary << "solver time [s]: " << parameters.executionTimeSum << std::endl;
+	summary << "solver time per frame [s]: " << parameters.executionTimeSum / numFrames << std::endl;
+	summary << "frames per second: " << numFrames / wallTime << std::endl;
+
+	std::cout << "HEADLESS RUN COMPLETED:" << std::endl << summary.str();
+
+	const std::string timingFileName = generateFileName("headlessTiming", "txt", parameters.TEST_IDX, parameters.TEST_VERSION);
+	std::ofstream timingFile(timingFileName);
+	if (!timingFile.is_open())
+	{
+		std::cout << "ERROR: Could not write [ " << timingFileName << " ]." << std::endl;
+		return 1;
+	}
+	timingFile << summary.str();
+
+	return 0;
+}
+
+//PARAMETER_SWEEP <NUM_FRAMES> <YOUNGS_MODULI> <POISSON_RATIOS> <ALPHA:RHO> <NUM_CONSTRAINT_ITS> TEST_<IDX>_<VERSION> ...:
+//the scenario is set up once, then every point of the grid runs as its own solver context (see ParameterSweep)
+int runParameterSweep(int argc, char* argv[])
+{
+	if (argc < 8)
+	{
+		std::cout << "ERROR: PARAMETER_SWEEP needs <NUM_FRAMES> <YOUNGS_MODULI> <POISSON_RATIOS> <ALPHA:RHO> "
+			<< "<NUM_CONSTRAINT_ITS> TEST_<IDX>_<VERSION>!" << std::endl;
+		return 1;
+	}
+
+	const int numFrames = std::stoi(argv[2]);
+
+	std::vector<ParameterSweepRun> runs;
+	if (!ParameterSweep::parseGrid(argv[3], argv[4], argv[5], argv[6], runs))
+	{
+		return 1;
+	}
+
+	if (!parseTerminalParameters(argc - 6, argv + 6, parameters, ioParameters))
+	{
+		return 1;
+	}
+
+	if (parameters.useFEMSolver || parameters.useTrackingConstraints)
+	{
+		std::cout << "ERROR: Sweeps only run the PBD solver without tracking constraints!" << std::endl;
+		return 1;
+	}
+
+	if (parameters.applyInitialDeformationToMesh || parameters.applyContinuousDeformationToMesh || parameters.applyPressure
+		|| parameters.translateCollisionGeometry || parameters.invertSingleElementAtStart || parameters.collapseMeshAtStart)
+	{
+		std::cout << "WARNING: The scenario's per-frame mesh updates are not applied in a sweep." << std::endl;
+	}
+
+	std::vector<int> vertexConstraintIndices;
+	if (!doIO(parameters, ioParameters, vertexConstraintIndices,
+		simulation.getTetrahedra(), simulation.getParticles(), trackingData, simulation.getCollisionGeometry2(),
+		simulation.getCollisionGeometry3(), simulation.getMovingConstraints()))
+	{
+		return 1;
+	}
+
+	//every run reads its own colliders / drivers, only the mesh is shared
+	ParameterSweepDriverLoader loadDrivers;
+	if (!simulation.getCollisionGeometry2().empty() || !simulation.getCollisionGeometry3().empty()
+		|| !simulation.getMovingConstraints().empty())
+	{
+		loadDrivers = [](std::vector<CollisionRod>& rods, std::vector<CollisionSphere>& spheres,
+			std::vector<MovingHardConstraints>& drivers)
+		{
+			std::vector<int> runVertexConstraintIndices;
+			std::vector<PBDTetrahedra3d> runTetrahedra;
+			std::shared_ptr<PBDParticleStore> runParticles = std::make_shared<PBDParticleStore>();
+			std::vector<std::vector<Eigen::Vector2f>> runTrackingData;
+
+			return doIO(parameters, ioParameters, runVertexConstraintIndices, runTetrahedra, runParticles, runTrackingData,
+				rods, spheres, drivers);
+		};
+	}
+
+	parameters.solverSettings.calculateLambda();
+	parameters.solverSettings.calculateMu();
+	parameters.solverSettings.calculateFiberStructureTensor();
+
+	simulation.initialise(parameters.solverSettings);
+
+	const std::string summaryFileName = generateFileName("parameterSweep", "csv", parameters.TEST_IDX, parameters.TEST_VERSION);
+
+	return ParameterSweep::run(simulation, runs, numFrames, loadDrivers, summaryFileName) ? 0 : 1;
+}
+
 int main(int argc, char* argv[])
 {
-	if (!parseTerminalParameters(argc, argv, parameters, ioParameters))
+	const std::string mode = (argc >= 2) ? argv[1] : "";
+
+	//The command line benchmarks all start from the defaults of test 13
+	if (mode == "SCALING_REPORT" || mode == "SUBSTEPPING_BENCHMARK" || mode == "CHEBYSHEV_BENCHMARK"
+		|| mode == "WARM_START_BENCHMARK" || mode == "BENCHMARK_SUITE")
+	{
+		parameters.initialiseToDefaults();
+		ioParameters.initialiseToDefaults();
+		parameters.solverSettings.initialise();
+		initTest_13(parameters, ioParameters);
+	}
+
+	//Thread scaling of the constraint projection on the resolution test meshes, no rendering involved
+	if (mode == "SCALING_REPORT")
+	{
+		int numFrames = (argc > 2) ? std::stoi(argv[2]) : 100;
+		int maxNumThreads = (argc > 3) ? std::stoi(argv[3]) : 0;
+
+		SolverScalingReport::run(parameters.solverSettings, 20, 16, 16, numFrames, maxNumThreads, "SolverScalingReport.m");
+		return 0;
+	}
+
+	if (mode == "SUBSTEPPING_BENCHMARK")
+	{
+		int numFrames = (argc > 2) ? std::stoi(argv[2]) : 100;
+		parameters.solverSettings.youngsModulus = (argc > 3) ? std::stof(argv[3]) : 10000.0f;
+
+		return SubsteppingBenchmark::run(parameters.solverSettings, 10, 6, 6, numFrames) ? 0 : 1;
+	}
+
+	if (mode == "CHEBYSHEV_BENCHMARK")
+	{
+		int numFrames = (argc > 2) ? std::stoi(argv[2]) : 50;
+		float constraintTolerance = (argc > 3) ? std::stof(argv[3]) : 1e-5f;
+		int maxNumConstraintIts = (argc > 4) ? std::stoi(argv[4]) : 2000;
+
+		return ChebyshevBenchmark::run(parameters.solverSettings, numFrames, constraintTolerance, maxNumConstraintIts) ? 0 : 1;
+	}
+
+	if (mode == "WARM_START_BENCHMARK")
+	{
+		int numFrames = (argc > 2) ? std::stoi(argv[2]) : 200;
+		float constraintTolerance = (argc > 3) ? std::stof(argv[3]) : 1e-7f;
+		int maxNumConstraintIts = (argc > 4) ? std::stoi(argv[4]) : 1000;
+		parameters.solverSettings.youngsModulus = (argc > 5) ? std::stof(argv[5]) : 1000.0f;
+
+		return WarmStartBenchmark::run(parameters.solverSettings, numFrames, constraintTolerance, maxNumConstraintIts) ? 0 : 1;
+	}
+
+	if (mode == "SVD_BENCHMARK")
+	{
+		int numMatrices = (argc > 2) ? std::stoi(argv[2]) : 1000000;
+
+		return SVD3x3Benchmark::run(numMatrices) ? 0 : 1;
+	}
+
+	if (mode == "KERNEL_CHECK")
+	{
+		return KernelCheck::run() ? 0 : 1;
+	}
+
+	if (mode == "BENCHMARK_SUITE")
+	{
+		int maxNumTets = (argc > 2) ? std::stoi(argv[2]) : 5000000;
+		int numFrames = (argc > 3) ? std::stoi(argv[3]) : 10;
+		int maxNumThreads = (argc > 4) ? std::stoi(argv[4]) : 0;
+		std::string fileName = (argc > 5) ? argv[5] : "BenchmarkSuite.csv";
+
+		return BenchmarkSuite::run(parameters.solverSettings, maxNumTets, numFrames, maxNumThreads, fileName) ? 0 : 1;
+	}
+
+	if (argc >= 2 && std::string(argv[1]) == "PARAMETER_SWEEP")
+	{
+		return runParameterSweep(argc, argv);
+	}
+
+	//HEADLESS [<NUM_FRAMES>] <test parameters>: the same scenarios without GLUT, see runHeadless
+	const bool headless = argc >= 2 && std::string(argv[1]) == "HEADLESS";
+
+	//the frame count replaces the scenario's maxFrames, e.g. for short golden runs (see AlembicTools/CompareAnimations)
+	const bool headlessFrames = headless && argc >= 3 && std::string(argv[2]).find("TEST_") != 0;
+	const int numSkippedArgs = headless ? (headlessFrames ? 2 : 1) : 0;
+
+	if (!parseTerminalParameters(argc - numSkippedArgs, argv + numSkippedArgs, parameters, ioParameters))
 	{
 		return 0;
 	}
 
+	if (headlessFrames)
+	{
+		parameters.maxFrames = std::stoi(argv[2]);
+	}
+
 	std::cout << "Parameters setup completed..." << std::endl;
 
 	//We potentially need these for the FEM solver
 	std::vector<int> vertexConstraintIndices;
 
 	if (!doIO(parameters, ioParameters, vertexConstraintIndices,
-		tetrahedra, particles, trackingData, collisionGeometry2, collisionGeometry3, movingConstraints))
+		simulation.getTetrahedra(), simulation.getParticles(), trackingData, simulation.getCollisionGeometry2(),
+		simulation.getCollisionGeometry3(), simulation.getMovingConstraints()))
 	{
 		return 0;
 	}
@@ -630,12 +924,16 @@ int main(int argc, char* argv[])
 	std::cout << "IO completed..." << std::endl;
 
 	std::cout << "MESH COMPLEXITY: " << std::endl;
-	std::cout << "Num Tets: " << tetrahedra.size() << "; Num Nodes: " << particles->size() << std::endl;
+	std::cout << "Num Tets: " << simulation.getTetrahedra().size() << "; Num Nodes: " << simulation.getParticles()->size() << std::endl;
+
+	currentPositions.resize(simulation.getParticles()->size());
+
+	//from here on the simulation's settings are the live ones (TweakBar, scenario updates)
+	simulation.initialise(parameters.solverSettings);
+
+	simulation.getSolver().printColoringStatistics();
 	std::cout << "----------------------------------------------" << std::endl;
 
-	numConstraintInfluences.resize(particles->size());
-	currentPositions.resize(particles->size());
-	
 	if (parameters.useTrackingConstraints)
 	{
 		createProabilisticConstraints();
@@ -651,23 +949,26 @@ int main(int argc, char* argv[])
 	glutSettings.positionX = 100;
 	glutSettings.positionY = 100;
 	GLUTHelper helper;
-	helper.initWindow(argc, argv, glutSettings);
-	helper.setIdleFunc(idleLoopGlut);
-	determineLookAt();
+	if (!headless)
+	{
+		helper.initWindow(argc, argv, glutSettings);
+		helper.setIdleFunc(idleLoopGlut);
+		determineLookAt();
+	}
 	//parameters.initialiseCamera();
 	if (parameters.useFEMSolver)
 	{
 		std::cout << "FEM SOLVER INIT:" << std::endl;
 		std::cout << "Writing .veg file..." << std::endl;
-		VegaIO::writeVegFile(tetrahedra, particles, "FEMMesh.veg");
+		VegaIO::writeVegFile(simulation.getTetrahedra(), simulation.getParticles(), "FEMMesh.veg");
 
 		std::cout << "Setting initial node positions..." << std::endl;
 		setInitialPositionsFromParticles();
 
 		std::cout << "Initialising FEM solver..." << std::endl;
 		FEMsolver.initSolver("FEMMesh.veg", vertexConstraintIndices,
-			parameters.solverSettings.youngsModulus, parameters.solverSettings.poissonRatio,
-			parameters.solverSettings.deltaT);
+			simulation.getSettings().youngsModulus, simulation.getSettings().poissonRatio,
+			simulation.getSettings().deltaT);
 		std::cout << "----------------------------------------------" << std::endl;
 	}
 
@@ -681,21 +982,26 @@ int main(int argc, char* argv[])
 		{
 			smHandler = std::make_shared<SurfaceMeshHandler>("WRITE_TETS", generateFileName("deformedMesh", "abc", parameters.TEST_IDX, parameters.TEST_VERSION));
 		}
-		smHandler->initTopology(*particles, tetrahedra);
+		smHandler->initTopology(*simulation.getParticles(), simulation.getTetrahedra());
 		std::cout << "Initialised Topology for Alembic Output!" << std::endl;
 	}
 
 	if (parameters.readCollisionGeometry)
 	{
-		collisionGeometry.resize(parameters.collisionGeometryFiles.size());
+		simulation.getCollisionGeometry().resize(parameters.collisionGeometryFiles.size());
 		for (int c = 0; c < parameters.collisionGeometryFiles.size(); ++c)
 		{
-			collisionGeometry[c].readFromAbc(parameters.collisionGeometryFiles[c]);
+			simulation.getCollisionGeometry()[c].readFromAbc(parameters.collisionGeometryFiles[c]);
 		}
 
 		std::cout << "Read collision geometry files!" << std::endl;
 	}
 
+	if (headless)
+	{
+		return runHeadless();
+	}
+
 	//TweakBar Interface
 	TwInit(TW_OPENGL, NULL);
 	TwWindowSize(glutSettings.height, glutSettings.width);
@@ -703,38 +1009,98 @@ int main(int argc, char* argv[])
 	solverSettings = TwNewBar("Solver Settings");
 
 	TwDefine(" GLOBAL help='FEM based PBD Solver Demo.' ");
-	TwAddVarRW(solverSettings, "stepSize", TW_TYPE_FLOAT, &parameters.solverSettings.deltaT,
+	TwAddVarRW(solverSettings, "stepSize", TW_TYPE_FLOAT, &simulation.getSettings().deltaT,
 		" label='Step Size' min=0.0001 max=10 step=0.001 keyIncr=s keyDecr=S help='Internal Solver Step Size (0.005 is stable)' ");
 
-	TwAddVarRW(solverSettings, "constraintIts", TW_TYPE_INT32, &parameters.solverSettings.numConstraintIts,
+	TwAddVarRW(solverSettings, "constraintIts", TW_TYPE_INT32, &simulation.getSettings().numConstraintIts,
 		" label='Constraint Iterations' min=1 max=100 step=1 keyIncr=s keyDecr=S help='Internal Solver Constraint Iterations (5 is stable)' ");
 
+	TwAddVarRW(solverSettings, "substeps", TW_TYPE_INT32, &simulation.getSettings().numSubsteps,
+		" label='Substeps' min=1 max=100 step=1 help='Solver substeps per frame, each with the given constraint iterations' ");
+
+	TwAddVarRW(solverSettings, "constraintTolerance", TW_TYPE_FLOAT, &simulation.getSettings().constraintTolerance,
+		" label='Constraint Tolerance' min=0.0 max=0.1 step=0.00001 help='Stop iterating once no particle moves further than this in a sweep (0: off)' ");
+
+	TwAddVarRW(solverSettings, "multiThreaded", TW_TYPE_BOOLCPP, &simulation.getSettings().useMultiThreadedSolver,
+		" label='Multi-threaded' help='Project the colours of the tet graph colouring in parallel' ");
+
+	TwAddVarRW(solverSettings, "jacobi", TW_TYPE_BOOLCPP, &simulation.getSettings().useJacobiSolver,
+		" label='Jacobi' help='Average all corrections per particle: slower convergence, scales with the cores (overrides multi-threaded)' ");
+
+	TwAddVarRW(solverSettings, "chebyshev", TW_TYPE_BOOLCPP, &simulation.getSettings().useChebyshevAcceleration,
+		" label='Chebyshev Acceleration' help='Extrapolate the positions between sweeps (multi-threaded and Jacobi solvers)' ");
+
+	TwAddVarRW(solverSettings, "coarseLevels", TW_TYPE_INT32, &simulation.getSettings().numCoarseLevels,
+		" label='Coarse Levels' min=0 max=4 step=1 help='Coarser tet grids solved before the fine sweeps (0: off)' ");
+
+	TwAddVarRW(solverSettings, "coarseLevelIts", TW_TYPE_INT32, &simulation.getSettings().numCoarseLevelIts,
+		" label='Coarse Level Iterations' min=1 max=100 step=1 help='Constraint iterations on every coarse level' ");
+
+	TwAddVarRW(solverSettings, "sleeping", TW_TYPE_BOOLCPP, &simulation.getSettings().useSleeping,
+		" label='Sleeping' help='Skip particles and tets that stopped moving (multi-threaded and Jacobi solvers)' ");
+
+	TwAddVarRW(solverSettings, "sleepVelocity", TW_TYPE_FLOAT, &simulation.getSettings().sleepVelocityThreshold,
+		" label='Sleep Velocity' min=0.0 max=1.0 step=0.001 help='Particles slower than this fall asleep after a number of steps' ");
+
+	TwAddVarRW(solverSettings, "warmStarting", TW_TYPE_BOOLCPP, &simulation.getSettings().useWarmStarting,
+		" label='Warm Starting' help='Start every step from the last step's corrections and multipliers' ");
+
+	TwAddVarRW(solverSettings, "warmStartDecay", TW_TYPE_FLOAT, &simulation.getSettings().warmStartDecay,
+		" label='Warm Start Decay' min=0.0 max=1.0 step=0.05 help='Fraction of the last step's corrections reused' ");
+
+	TwAddVarRW(solverSettings, "distanceConstraints", TW_TYPE_BOOLCPP, &simulation.getSettings().useDistanceConstraints,
+		" label='Distance Constraints' help='Project the edge lengths after the energy constraints' ");
+
+	TwAddVarRW(solverSettings, "distanceStiffness", TW_TYPE_FLOAT, &simulation.getSettings().distanceConstraintStiffness,
+		" label='Distance Stiffness' min=0.0 max=1.0 step=0.01 help='Fraction of the edge length error removed per step' ");
+
+	TwAddVarRW(solverSettings, "volumeConstraints", TW_TYPE_BOOLCPP, &simulation.getSettings().useVolumeConstraints,
+		" label='Volume Constraints' help='Project the tet volumes after the energy constraints' ");
+
+	TwAddVarRW(solverSettings, "volumeStiffness", TW_TYPE_FLOAT, &simulation.getSettings().volumeConstraintStiffness,
+		" label='Volume Stiffness' min=0.0 max=1.0 step=0.01 help='Fraction of the volume error removed per step' ");
+
+	TwAddVarRW(solverSettings, "SOR", TW_TYPE_BOOLCPP, &simulation.getSettings().useSOR,
+		" label='SOR' help='Over-relax every colour sweep of the multi-threaded solver by w' ");
+
+	TwAddVarRW(solverSettings, "autoTuneSOR", TW_TYPE_BOOLCPP, &simulation.getSettings().autoTuneSOR,
+		" label='Auto-tune SOR' help='Estimate w per step from the residual decay of the first sweeps' ");
+
+	TwAddVarRW(solverSettings, "w", TW_TYPE_FLOAT, &simulation.getSettings().w,
+		" label='w' min=0.1 max=1.99 step=0.05 help='Over-relaxation factor (SOR) / correction scale (Jacobi)' ");
+
+	TwAddVarRW(solverSettings, "deterministic", TW_TYPE_BOOLCPP, &simulation.getSettings().useDeterministicParallelism,
+		" label='Deterministic' help='Identical results for any number of threads (fixed blocks, ordered sums)' ");
+
+	TwAddVarRW(solverSettings, "profiling", TW_TYPE_BOOLCPP, &simulation.getSettings().enableProfiling,
+		" label='Profiling' help='Record phase times and constraint counters, written to SolverProfile.csv / .json at the end' ");
+
 	TwAddSeparator(solverSettings, NULL, NULL);
 	TwAddButton(solverSettings, "comment0", NULL, NULL, " label='Elasticity' ");
-	TwAddVarRW(solverSettings, "YoungsModulus", TW_TYPE_FLOAT, &parameters.solverSettings.youngsModulus,
+	TwAddVarRW(solverSettings, "YoungsModulus", TW_TYPE_FLOAT, &simulation.getSettings().youngsModulus,
 		" label='Youngs Modulus' min=0.0 max=1000.0 step=0.0001 keyIncr=s keyDecr=S help='Stiffness' ");
 
-	TwAddVarRW(solverSettings, "PoissonRatio", TW_TYPE_FLOAT, &parameters.solverSettings.poissonRatio,
+	TwAddVarRW(solverSettings, "PoissonRatio", TW_TYPE_FLOAT, &simulation.getSettings().poissonRatio,
 		" label='Poisson Ratio' min=0.0 max=0.5 step=0.01 keyIncr=s keyDecr=S help='Poisson Ratio' ");
 
 	TwAddSeparator(solverSettings, NULL, NULL);
 	TwAddButton(solverSettings, "comment1", NULL, NULL, " label='Viscoelasticity' ");
-	TwAddVarRW(solverSettings, "Alpha", TW_TYPE_FLOAT, &parameters.solverSettings.alpha,
+	TwAddVarRW(solverSettings, "Alpha", TW_TYPE_FLOAT, &simulation.getSettings().alpha,
 		" label='Alpha' min=0.0 max=1.0 step=0.01 keyIncr=s keyDecr=S help='Alpha' ");
-	TwAddVarRW(solverSettings, "Rho", TW_TYPE_FLOAT, &parameters.solverSettings.rho,
+	TwAddVarRW(solverSettings, "Rho", TW_TYPE_FLOAT, &simulation.getSettings().rho,
 		" label='Rho' min=0.0 max=100 step=0.01 keyIncr=s keyDecr=S help='Rho' ");
 
 	TwAddSeparator(solverSettings, NULL, NULL);
 	TwAddButton(solverSettings, "comment2", NULL, NULL, " label='Anisotropy' ");
-	TwAddVarRW(solverSettings, "AnisotropyStrength", TW_TYPE_FLOAT, &parameters.solverSettings.anisotropyParameter,
+	TwAddVarRW(solverSettings, "AnisotropyStrength", TW_TYPE_FLOAT, &simulation.getSettings().anisotropyParameter,
 		" label='Strength' min=0.0 max=10000 step=0.01 keyIncr=s keyDecr=S help='Strength of Anisotropic Material Component' ");
 
-	TwAddVarRW(solverSettings, "AnistropyDir", TW_TYPE_DIR3F, &parameters.solverSettings.MR_a[0],
+	TwAddVarRW(solverSettings, "AnistropyDir", TW_TYPE_DIR3F, &simulation.getSettings().MR_a[0],
 		" label='Dir' help='Direction of Material Anisotropy' ");
 
 	TwAddSeparator(solverSettings, NULL, NULL);
 
-	TwAddVarRW(solverSettings, "Gravity", TW_TYPE_FLOAT, &parameters.solverSettings.gravity,
+	TwAddVarRW(solverSettings, "Gravity", TW_TYPE_FLOAT, &simulation.getSettings().gravity,
 		" label='Gravity' min=-100.0 max=100 step=0.01 keyIncr=s keyDecr=S help='Gravity' ");
 		
 	TwAddSeparator(solverSettings, NULL, NULL);